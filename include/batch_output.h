@@ -0,0 +1,16 @@
+#ifndef MONITOR_BATCH_OUTPUT_H
+#define MONITOR_BATCH_OUTPUT_H
+
+#include "options.h"
+
+class System;
+
+// Headless mode: runs the sampler on a fixed interval and streams every
+// snapshot to stdout as newline delimited JSON or CSV, one write per tick
+namespace BatchOutput {
+
+int Run(System& system, const CommandLine::Options& options);
+
+}  // namespace BatchOutput
+
+#endif
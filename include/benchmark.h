@@ -0,0 +1,16 @@
+#ifndef MONITOR_BENCHMARK_H
+#define MONITOR_BENCHMARK_H
+
+#include <string>
+
+class System;
+
+// Built-in micro benchmarks, run with --benchmark <name>; results go to
+// stdout and the exit code tells whether the checks passed
+namespace Benchmark {
+
+int Run(System& system, const std::string& name);
+
+}  // namespace Benchmark
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef MONITOR_CGROUP_MANAGER_H
+#define MONITOR_CGROUP_MANAGER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per-cgroup usage, taken from the kernel maintained cgroup v2 counters
+struct CgroupStats {
+  std::string path;
+  float cpuUtilization;   // percent of one CPU, like the process CPU%
+  uint64_t memCurrent;    // in kB
+  uint64_t memAnon;
+  uint64_t memFile;
+  float cpuPressure;      // "some avg10" in percent
+  float memoryPressure;
+  float ioPressure;
+  unsigned int numProcesses;
+
+  uint64_t lastUsageUsec;
+  std::chrono::steady_clock::time_point lastSample;
+};
+
+// Tracks the cgroups the current processes belong to. The cost of an update
+// is O(cgroups): the counters are read from /sys/fs/cgroup, never summed up
+// from the individual processes.
+class CgroupManager {
+ public:
+  // `processCounts` maps every cgroup path in use to its number of processes
+  void Update(const std::unordered_map<std::string, unsigned int>& processCounts);
+  std::vector<const CgroupStats*> GetSortedCgroups() const;
+
+ private:
+  std::unordered_map<std::string, CgroupStats> cgroups_;
+};
+
+#endif
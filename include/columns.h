@@ -0,0 +1,301 @@
+#ifndef MONITOR_COLUMNS_H
+#define MONITOR_COLUMNS_H
+
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+#include "format.h"
+#include "mem_data.h"
+#include "process.h"
+#include "sample_scheduler.h"
+
+// Room every column formatter may use
+#define COLUMN_BUFFER_SIZE 32
+
+// The value is left aligned and takes the rest of the line when last
+#define COLUMN_LEFT_ALIGNED (1u << 0)
+// Longer values are cut to the header width instead of running into the
+// column on their left
+#define COLUMN_CLIPPED (1u << 1)
+// Smaller values sort first
+#define COLUMN_ASCENDING (1u << 2)
+// Only shown when asked for with --fields
+#define COLUMN_HIDDEN (1u << 3)
+
+/*
+The columns of the process list. Everything about a column lives in its
+entry: the header (which sets the width), the --fields name, how the value is
+formatted and sorted and which files it needs. The header row, the process
+rows and the sort order are generated from the entries of the visible
+columns.
+*/
+namespace Columns {
+
+struct Column {
+  std::string_view name;
+  std::string_view header;
+  uint32_t flags;
+  uint32_t sources;  // SAMPLE_SOURCE_* the value is computed from
+  // Text of the value; numbers are written to `buffer`
+  // (COLUMN_BUFFER_SIZE bytes), text is returned in place
+  std::string_view (*format)(Process& process, const MemData& memData,
+                             char* buffer);
+  // Sort key of numeric columns; text columns sort by their text. Batch
+  // output writes the key, in the units of /proc, with `precision` decimals.
+  double (*key)(Process& process, const MemData& memData);
+  int precision = 0;
+};
+
+namespace Detail {
+inline std::string_view View(const char* buffer, const char* end) {
+  return std::string_view(buffer, end - buffer);
+}
+inline double MemPercent(Process& process, const MemData& memData) {
+  return memData.memTotal ? (double)process.MemUtilization().resident_mem /
+                                memData.memTotal * 100.0
+                          : 0.0;
+}
+// kB per second like the memory columns, "-" until two reads of
+// /proc/<pid>/io exist (never for processes we may not inspect)
+inline std::string_view IoRate(char* buffer, Process& process, double kb) {
+  if (!process.IoAvailable()) return "-";
+  return View(buffer, Format::Memory(buffer, buffer + COLUMN_BUFFER_SIZE,
+                                     (uint64_t)std::llround(kb), 0));
+}
+// Context switches per second, "-" until status was read twice
+inline std::string_view Rate(char* buffer, Process& process, double rate) {
+  if (!process.CtxtAvailable()) return "-";
+  return View(buffer, Format::Integer(buffer, buffer + COLUMN_BUFFER_SIZE,
+                                      std::llround(rate)));
+}
+// kB like RES, "-" until smaps_rollup was read (never for processes we may
+// not inspect)
+inline std::string_view SmapsMemory(char* buffer, Process& process,
+                                    uint64_t kb) {
+  if (!process.SmapsAvailable()) return "-";
+  return View(buffer, Format::Memory(buffer, buffer + COLUMN_BUFFER_SIZE, kb, 0));
+}
+}  // namespace Detail
+
+inline constexpr Column kColumns[] = {
+    {"pid", "    PID", COLUMN_ASCENDING, SAMPLE_SOURCE_STAT,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::View(b, Format::Integer(b, b + COLUMN_BUFFER_SIZE, p.Pid()));
+     },
+     [](Process& p, const MemData&) { return (double)p.Pid(); }},
+    {"user", "USER    ", COLUMN_CLIPPED | COLUMN_ASCENDING,
+     SAMPLE_SOURCE_STATUS,
+     [](Process& p, const MemData&, char*) {
+       return std::string_view(p.User());
+     },
+     nullptr},
+    {"pri", "PRI", 0, SAMPLE_SOURCE_STAT,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::View(
+           b, Format::Integer(b, b + COLUMN_BUFFER_SIZE, p.PriorityValue()));
+     },
+     [](Process& p, const MemData&) { return (double)p.PriorityValue(); }},
+    {"ni", " NI", 0, SAMPLE_SOURCE_STAT,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::View(
+           b, Format::Integer(b, b + COLUMN_BUFFER_SIZE, p.NiceValue()));
+     },
+     [](Process& p, const MemData&) { return (double)p.NiceValue(); }},
+    {"virt", "  VIRT", 0, SAMPLE_SOURCE_STATUS,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::View(b, Format::Memory(b, b + COLUMN_BUFFER_SIZE,
+                                             p.MemUtilization().virtual_mem, 0));
+     },
+     [](Process& p, const MemData&) {
+       return (double)p.MemUtilization().virtual_mem;
+     }},
+    {"res", "  RES", 0, SAMPLE_SOURCE_STATUS,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::View(b, Format::Memory(b, b + COLUMN_BUFFER_SIZE,
+                                             p.MemUtilization().resident_mem, 0));
+     },
+     [](Process& p, const MemData&) {
+       return (double)p.MemUtilization().resident_mem;
+     }},
+    {"shr", "  SHR", 0, SAMPLE_SOURCE_STATUS,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::View(b, Format::Memory(b, b + COLUMN_BUFFER_SIZE,
+                                             p.MemUtilization().shared_mem, 0));
+     },
+     [](Process& p, const MemData&) {
+       return (double)p.MemUtilization().shared_mem;
+     }},
+    {"state", "S", COLUMN_ASCENDING, SAMPLE_SOURCE_STAT,
+     [](Process& p, const MemData&, char* b) {
+       b[0] = p.State();
+       return std::string_view(b, 1);
+     },
+     nullptr},
+    {"cpu", "  CPU%", 0, SAMPLE_SOURCE_STAT,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::View(
+           b, Format::Tenths(b, b + COLUMN_BUFFER_SIZE, p.CpuUtilization()));
+     },
+     [](Process& p, const MemData&) { return (double)p.CpuUtilization(); },
+     1},
+    {"mem", "  MEM%", 0, SAMPLE_SOURCE_STATUS,
+     [](Process& p, const MemData& m, char* b) {
+       return Detail::View(b, Format::Tenths(b, b + COLUMN_BUFFER_SIZE,
+                                             Detail::MemPercent(p, m)));
+     },
+     Detail::MemPercent, 1},
+    {"time", "   TIME+ ", 0, SAMPLE_SOURCE_STAT,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::View(
+           b, Format::ElapsedTime(b, b + COLUMN_BUFFER_SIZE, p.UpTime()));
+     },
+     [](Process& p, const MemData&) { return p.UpTime(); }, 2},
+    {"threads", "THR", COLUMN_HIDDEN, SAMPLE_SOURCE_STATUS,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::View(
+           b, Format::Integer(b, b + COLUMN_BUFFER_SIZE, p.getNumThreads()));
+     },
+     [](Process& p, const MemData&) { return (double)p.getNumThreads(); }},
+    {"read_rate", " READ/s", COLUMN_HIDDEN, SAMPLE_SOURCE_IO,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::IoRate(b, p, p.IoReadRate() / 1024);
+     },
+     [](Process& p, const MemData&) {
+       return p.IoAvailable() ? p.IoReadRate() : -1.0;
+     }},
+    {"write_rate", "WRITE/s", COLUMN_HIDDEN, SAMPLE_SOURCE_IO,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::IoRate(b, p, p.IoWriteRate() / 1024);
+     },
+     [](Process& p, const MemData&) {
+       return p.IoAvailable() ? p.IoWriteRate() : -1.0;
+     }},
+    {"syscall_rate", "SYSC/s", COLUMN_HIDDEN, SAMPLE_SOURCE_IO,
+     [](Process& p, const MemData&, char* b) {
+       if (!p.IoAvailable()) return std::string_view("-");
+       return Detail::View(b, Format::Integer(b, b + COLUMN_BUFFER_SIZE,
+                                              std::llround(p.IoSyscallRate())));
+     },
+     [](Process& p, const MemData&) {
+       return p.IoAvailable() ? p.IoSyscallRate() : -1.0;
+     },
+     1},
+    // Single-threaded processes every tick, the thread sums of the others
+    // in the budgeted passes
+    {"wait", " WAIT%", COLUMN_HIDDEN,
+     SAMPLE_SOURCE_SCHEDSTAT | SAMPLE_SOURCE_TASKS,
+     [](Process& p, const MemData&, char* b) {
+       if (!p.SchedAvailable()) return std::string_view("-");
+       return Detail::View(
+           b, Format::Tenths(b, b + COLUMN_BUFFER_SIZE, p.WaitPercent()));
+     },
+     [](Process& p, const MemData&) {
+       return p.SchedAvailable() ? p.WaitPercent() : -1.0;
+     },
+     1},
+    // The context switch rates are those of the main thread, which is all
+    // that status counts
+    {"vcsw_rate", "VCSW/s", COLUMN_HIDDEN, SAMPLE_SOURCE_STATUS,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::Rate(b, p, p.VoluntaryCtxtRate());
+     },
+     [](Process& p, const MemData&) {
+       return p.CtxtAvailable() ? p.VoluntaryCtxtRate() : -1.0;
+     },
+     1},
+    {"ivcsw_rate", "ICSW/s", COLUMN_HIDDEN, SAMPLE_SOURCE_STATUS,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::Rate(b, p, p.NonvoluntaryCtxtRate());
+     },
+     [](Process& p, const MemData&) {
+       return p.CtxtAvailable() ? p.NonvoluntaryCtxtRate() : -1.0;
+     },
+     1},
+    {"pss", "  PSS", COLUMN_HIDDEN, SAMPLE_SOURCE_SMAPS,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::SmapsMemory(b, p, p.Pss());
+     },
+     [](Process& p, const MemData&) {
+       return p.SmapsAvailable() ? (double)p.Pss() : -1.0;
+     }},
+    {"uss", "  USS", COLUMN_HIDDEN, SAMPLE_SOURCE_SMAPS,
+     [](Process& p, const MemData&, char* b) {
+       return Detail::SmapsMemory(b, p, p.Uss());
+     },
+     [](Process& p, const MemData&) {
+       return p.SmapsAvailable() ? (double)p.Uss() : -1.0;
+     }},
+    {"fds", "  FDS", COLUMN_HIDDEN, SAMPLE_SOURCE_FD,
+     [](Process& p, const MemData&, char* b) {
+       if (!p.FdAvailable()) return std::string_view("-");
+       return Detail::View(
+           b, Format::Integer(b, b + COLUMN_BUFFER_SIZE, p.FdCount()));
+     },
+     [](Process& p, const MemData&) {
+       return p.FdAvailable() ? (double)p.FdCount() : -1.0;
+     }},
+    {"fd_usage", "  FD%", COLUMN_HIDDEN, SAMPLE_SOURCE_FD,
+     [](Process& p, const MemData&, char* b) {
+       if (!p.FdAvailable() || p.FdLimit() == 0) return std::string_view("-");
+       return Detail::View(b, Format::Tenths(b, b + COLUMN_BUFFER_SIZE,
+                                             p.FdUsage() * 100.0));
+     },
+     [](Process& p, const MemData&) {
+       return p.FdAvailable() ? p.FdUsage() * 100.0 : -1.0;
+     },
+     1},
+    {"sockets", " SOCK", COLUMN_HIDDEN, SAMPLE_SOURCE_SOCKETS,
+     [](Process& p, const MemData&, char* b) {
+       if (!p.SocketsAvailable()) return std::string_view("-");
+       return Detail::View(
+           b, Format::Integer(b, b + COLUMN_BUFFER_SIZE, p.SocketCount()));
+     },
+     [](Process& p, const MemData&) {
+       return p.SocketsAvailable() ? (double)p.SocketCount() : -1.0;
+     }},
+    {"command", "COMMAND", COLUMN_LEFT_ALIGNED | COLUMN_ASCENDING,
+     SAMPLE_SOURCE_CMDLINE,
+     [](Process& p, const MemData&, char*) {
+       return std::string_view(p.Command());
+     },
+     nullptr},
+};
+
+inline constexpr int kCount = std::size(kColumns);
+
+// Position of the column called `name` in kColumns, -1 if there is none
+constexpr int Index(std::string_view name) {
+  for (int i = 0; i < kCount; ++i) {
+    if (kColumns[i].name == name) return i;
+  }
+  return -1;
+}
+
+inline constexpr int kPid = Index("pid");
+inline constexpr int kUser = Index("user");
+inline constexpr int kRes = Index("res");
+inline constexpr int kShr = Index("shr");
+inline constexpr int kCpu = Index("cpu");
+inline constexpr int kMem = Index("mem");
+inline constexpr int kCommand = Index("command");
+static_assert(kPid >= 0 && kUser >= 0 && kRes >= 0 && kShr >= 0 &&
+                  kCpu >= 0 && kMem >= 0 && kCommand >= 0,
+              "the process list relies on these columns");
+
+// Resolves a comma separated list of names into `columns`; empty selects
+// the columns shown by default. Prints the offending name on failure.
+bool Parse(std::string_view list, std::vector<int>& columns);
+
+// Union of the sources of `columns`
+uint32_t Sources(const std::vector<int>& columns);
+
+// Sorts by `column` in its natural direction, ties by PID
+void Sort(std::vector<std::shared_ptr<Process>>& processes, int column,
+          const MemData& memData);
+
+}  // namespace Columns
+
+#endif
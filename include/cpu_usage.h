@@ -0,0 +1,49 @@
+#ifndef MONITOR_CPU_USAGE_H
+#define MONITOR_CPU_USAGE_H
+
+#include <cstddef>
+#include <vector>
+
+struct CPUDataWithHistory;
+
+// Shares (0..1) of the time since the previous sample a CPU spent in each
+// state the per-core bars stack; guest time counts as user time
+struct CpuBreakdown {
+  float user;
+  float nice;
+  float system;
+  float irq;
+  float softirq;
+  float steal;
+  float iowait;
+};
+
+/*
+Busy ratios of every CPU of one /proc/stat sample.
+
+The deltas of the counters are first copied into flat arrays, then all
+ratios are computed in one pass over them (four CPUs at a time with SSE2),
+instead of one CPUDataWithHistory::Utilization() call per core. The arrays keep their
+capacity, so updating does not allocate once the CPU count is known.
+*/
+class CpuUsage {
+ public:
+  void Update(const std::vector<CPUDataWithHistory>& cpus);
+  // Same values as CPUDataWithHistory::Utilization(); index 0 is the total
+  const std::vector<float>& Ratios() const { return ratios_; }
+
+  // Split of the same time by state; a separate pass, only needed by views
+  // that stack the states
+  void UpdateBreakdown(const std::vector<CPUDataWithHistory>& cpus);
+  const std::vector<CpuBreakdown>& Breakdown() const { return breakdown_; }
+
+ private:
+  // Ticks since the previous sample as doubles (exact up to 2^53); SSE2 has
+  // no packed 64 bit integer conversion
+  std::vector<double> total_;
+  std::vector<double> busy_;
+  std::vector<float> ratios_;
+  std::vector<CpuBreakdown> breakdown_;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef MONITOR_DATA_SOURCE_H
+#define MONITOR_DATA_SOURCE_H
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct MemData;
+struct CPUDataWithHistory;
+struct CgroupStats;
+class Process;
+class SampleHistory;
+class NetworkStats;
+class DiskStats;
+class PressureStats;
+class InterruptStats;
+namespace LinuxParser {
+struct numaNodeData;
+}
+
+// Everything the UI displays. Implemented by the live System and by the
+// replay of a recording.
+class DataSource {
+ public:
+  virtual ~DataSource() = default;
+
+  // Takes a new sample, or advances the replay, if one is due
+  virtual void Update() = 0;
+  // Takes the first process sample and, shortly after, the second one the
+  // CPU percentages need; the system-wide data is there from construction
+  virtual void Prime() {}
+  // Makes a Prime() running on another thread return soon; the source is
+  // not sampled again afterwards
+  virtual void CancelPrime() {}
+  virtual std::vector<std::shared_ptr<Process>> GetSortedProcesses() = 0;
+  virtual unsigned int getNumOfTasks() = 0;
+  virtual unsigned int getNumOfThreads() = 0;
+  virtual unsigned int getNumOfRunningTasks() = 0;
+
+  virtual const MemData& MemoryUtilization() = 0;
+  virtual unsigned long long UpTime() = 0;
+  virtual std::string LoadAverage() = 0;
+  virtual const std::vector<CPUDataWithHistory>& totalCpuUtilization() = 0;
+  virtual std::string Kernel() = 0;
+  virtual std::string OperatingSystem() = 0;
+  // NUMA node of every CPU, empty when unknown
+  virtual std::vector<int> CpuNodes() { return {}; }
+  // Memory of every NUMA node, nullptr or empty on single node machines
+  virtual const std::vector<LinuxParser::numaNodeData>* NumaMemory() {
+    return nullptr;
+  }
+  // Memory of `pid` on every node in kB; false when not available. Walks
+  // the page tables of the process, so it is only asked on demand.
+  virtual bool ProcessNumaMemory(pid_t, std::vector<uint64_t>&) {
+    return false;
+  }
+
+  // cgroup aggregation; returns false when the source cannot provide it
+  virtual bool SetCgroupTracking(bool) { return false; }
+  virtual std::vector<const CgroupStats*> GetSortedCgroups() { return {}; }
+
+  // SAMPLE_SOURCE_* the UI shows, so optional sources get sampled
+  virtual void SetWantedSources(uint32_t) {}
+  // PIDs of the rows on screen, sampled first where sampling is expensive
+  virtual void SetVisiblePids(std::vector<pid_t>) {}
+  // All of the command line of `pid`, read on demand; empty when not
+  // available, e.g. in a replay
+  virtual std::string ProcessCommandLine(pid_t) { return {}; }
+  // Lists kernel threads among the processes; returns false when the source
+  // cannot provide them
+  virtual bool SetShowKernelThreads(bool) { return false; }
+
+  // Trend of the CPU, memory and load values, nullptr if not kept
+  virtual const SampleHistory* History() { return nullptr; }
+  // Rates of the network interfaces, nullptr if not sampled
+  virtual const NetworkStats* Network() { return nullptr; }
+  // Rates of the disks, nullptr if not sampled
+  virtual const DiskStats* Disks() { return nullptr; }
+  // Pressure stall information, nullptr if not sampled
+  virtual const PressureStats* Pressure() { return nullptr; }
+  // Interrupt and softirq rates per CPU are only sampled while somebody
+  // looks at them; returns false when the source cannot provide them
+  virtual bool SetInterruptTracking(bool) { return false; }
+  virtual const InterruptStats* Interrupts() { return nullptr; }
+
+  // Source specific keys (e.g. replay controls); true if the key was consumed
+  virtual bool HandleKey(int) { return false; }
+  // Short status shown in the upper panel, empty for none
+  virtual std::string StatusText() { return {}; }
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef MONITOR_DISK_STATS_H
+#define MONITOR_DISK_STATS_H
+
+#include <chrono>
+#include <vector>
+
+#include "linux_parser.h"
+
+// Per second values between the last two samples, like iostat -x
+struct DiskRates {
+  double readIops;
+  double writeIops;
+  double readBytes;
+  double writeBytes;
+  double readLatencyMs;  // average time of a completed request
+  double writeLatencyMs;
+  double queueDepth;  // average requests in flight
+  double utilization;  // share of the time with requests in flight (0..1)
+};
+
+struct Disk {
+  LinuxParser::diskStatsData counters;
+  DiskRates rates;
+  bool hasRates;  // false for the first sample of a disk
+};
+
+/*
+Rates of the disks from successive /proc/diskstats samples.
+
+Disks are matched with the previous sample by name, found at the same
+position unless disks came or went. The live system feeds
+LinuxParser::DiskStatistics(), a replay the recorded counters with their
+timestamps.
+*/
+class DiskStats {
+ public:
+  void Update(const std::vector<LinuxParser::diskStatsData>& devices,
+              std::chrono::steady_clock::time_point now);
+  // Forgets the previous sample, e.g. when a replay seeks
+  void Clear();
+  const std::vector<Disk>& Disks() const { return disks_; }
+
+ private:
+  std::vector<Disk> disks_;
+  std::vector<Disk> previous_;
+  std::chrono::steady_clock::time_point time_;
+};
+
+#endif
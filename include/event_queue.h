@@ -19,8 +19,9 @@ class EventQueue
   T pop() {
     std::unique_lock<std::mutex> uLock(_mutex);
     _cond.wait(uLock, [this] { return !_messages.empty();});
-    T msg = std::move(_messages.back());
-    _messages.pop_back();
+    // Oldest first, typed keys must keep their order
+    T msg = std::move(_messages.front());
+    _messages.pop_front();
     return msg;
   }
 
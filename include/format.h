@@ -1,11 +1,58 @@
 #ifndef FORMAT_H
 #define FORMAT_H
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
+
+// Longest line the process list formats, wider terminals are clipped
+#define FORMAT_LINE_BUFFER_SIZE 1024
 
 namespace Format {
 std::string ElapsedTime(double uptime_in_seconds);
 std::string FormatUptime(unsigned long long uptimeSeconds);
+
+// Allocation-free formatting: every function writes at `first`, never past
+// `last`, and returns the end of the text like std::to_chars
+char* Integer(char* first, char* last, long long value);
+// `value` rounded to one decimal, as printed with "%.1f" after rounding
+char* Tenths(char* first, char* last, float value);
+// Same text as ElapsedTime()
+char* ElapsedTime(char* first, char* last, double uptime_in_seconds);
+// "512K", "12M" or "1.5G" with `precision` decimals for M and G
+char* Memory(char* first, char* last, uint64_t kb, int precision = 1);
+
+// One screen line formatted in place
+class LineBuffer {
+ public:
+  // Starts a blank line of `width` columns
+  void Reset(int width) {
+    width_ = std::clamp(width, 0, FORMAT_LINE_BUFFER_SIZE);
+    std::memset(data_, ' ', width_);
+  }
+  std::string_view View() const { return std::string_view(data_, width_); }
+  int Width() const { return width_; }
+
+  // Copies `text` to column `col`, clipped at both edges
+  void Write(int col, std::string_view text) {
+    size_t skip = col < 0 ? (size_t)-(long)col : 0;
+    if (skip >= text.size() || col + (long)skip >= width_) return;
+    int start = col + (int)skip;
+    size_t count = std::min(text.size() - skip, (size_t)(width_ - start));
+    std::memcpy(data_ + start, text.data() + skip, count);
+  }
+  // Right-aligns `text` in the `width` columns starting at `col`; text that
+  // is too long runs into the columns on the left
+  void WriteRight(int col, int width, std::string_view text) {
+    Write(col + width - (int)text.size(), text);
+  }
+
+ private:
+  char data_[FORMAT_LINE_BUFFER_SIZE];
+  int width_ = 0;
+};
 } // namespace Format
 
-#endif
\ No newline at end of file
+#endif
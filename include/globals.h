@@ -1,6 +1,30 @@
 #ifndef MONITOR_GLOBALS_H
 #define MONITOR_GLOBALS_H
 
+#include <chrono>
+#include <cstddef>
+
+// Default refresh interval in milliseconds
 #define GLOBAL_REFRESH_RATE 1500
+// Default number of bytes of a command line kept per process
+#define GLOBAL_CMDLINE_MAX 4096
+
+namespace Globals {
+
+// Refresh interval in milliseconds, GLOBAL_REFRESH_RATE unless changed on the
+// command line. Must be set before the first sample is taken.
+int RefreshRate();
+void SetRefreshRate(int milliseconds);
+
+// Bytes of /proc/<pid>/cmdline read and kept per process; longer command
+// lines are cut, and only read whole on demand
+size_t CmdlineMaxLength();
+void SetCmdlineMaxLength(size_t bytes);
+
+// Cached system readings expire slightly before the next timer driven
+// refresh, so every tick sees fresh counters
+std::chrono::milliseconds CacheDuration();
+
+}  // namespace Globals
 
 #endif
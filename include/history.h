@@ -0,0 +1,96 @@
+#ifndef MONITOR_HISTORY_H
+#define MONITOR_HISTORY_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct MemData;
+struct CPUDataWithHistory;
+
+// Samples kept per series; the oldest one is overwritten once full
+#define HISTORY_CAPACITY 300
+
+// Fixed-size ring of the last N values, stored inline
+template <typename T, size_t N>
+class RingBuffer {
+ public:
+  void Push(T value) {
+    values_[(start_ + size_) % N] = value;
+    if (size_ < N) {
+      ++size_;
+    } else {
+      start_ = (start_ + 1) % N;
+    }
+  }
+  void Clear() { start_ = size_ = 0; }
+  size_t Size() const { return size_; }
+  static constexpr size_t Capacity() { return N; }
+  // 0 is the oldest value, Size() - 1 the newest
+  T operator[](size_t i) const { return values_[(start_ + i) % N]; }
+  T Back() const { return (*this)[size_ - 1]; }
+
+ private:
+  std::array<T, N> values_{};
+  size_t start_ = 0;
+  size_t size_ = 0;
+};
+
+using HistorySeries = RingBuffer<float, HISTORY_CAPACITY>;
+
+/*
+Trend of the system wide values over the last HISTORY_CAPACITY samples.
+
+The per-CPU series are allocated once for the CPU count given to Reset(), so
+the footprint is (CPUs + 12) * HISTORY_CAPACITY floats whatever the uptime, and
+Record() never allocates.
+*/
+class SampleHistory {
+ public:
+  // Drops all samples and sizes the per-CPU series; index 0 is the total
+  void Reset(size_t numCpus);
+  // Drops all samples and keeps the sizes
+  void Clear();
+  size_t NumCpus() const { return cpus_.size(); }
+
+  // Appends one sample; CPUs beyond the Reset() count are ignored
+  void Record(const std::vector<CPUDataWithHistory>& cpus,
+              const MemData& memData, const std::string& loadAverage);
+  // Appends the network totals of the same sample, in bytes per second
+  void RecordNetwork(float rxBytes, float txBytes);
+  // Appends the "some" stall percentages of the interval, see PressureStats
+  void RecordPressure(float cpu, float memory, float io);
+
+  // Busy ratio (0..1) of `cpu`, 0 being the total
+  const HistorySeries& Cpu(size_t cpu) const { return cpus_[cpu]; }
+  // Ratios of MemTotal (0..1), split like the Mem bar
+  const HistorySeries& MemUsed() const { return memUsed_; }
+  const HistorySeries& MemBuffers() const { return memBuffers_; }
+  const HistorySeries& MemCached() const { return memCached_; }
+  // Ratio of SwapTotal (0..1)
+  const HistorySeries& Swap() const { return swap_; }
+  // 1, 5 and 15 minute load average
+  const HistorySeries& Load(size_t period) const { return load_[period]; }
+  // Received and sent bytes per second, empty where not sampled
+  const HistorySeries& NetRx() const { return netRx_; }
+  const HistorySeries& NetTx() const { return netTx_; }
+  // Percent of the interval tasks stalled on PsiResource `resource`, empty
+  // without PSI
+  const HistorySeries& Pressure(size_t resource) const {
+    return pressure_[resource];
+  }
+
+ private:
+  std::vector<HistorySeries> cpus_;
+  HistorySeries memUsed_;
+  HistorySeries memBuffers_;
+  HistorySeries memCached_;
+  HistorySeries swap_;
+  std::array<HistorySeries, 3> load_;
+  HistorySeries netRx_;
+  HistorySeries netTx_;
+  std::array<HistorySeries, 3> pressure_;
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef MONITOR_INTERRUPT_STATS_H
+#define MONITOR_INTERRUPT_STATS_H
+
+#include <chrono>
+#include <vector>
+
+#include "linux_parser.h"
+
+// One line of /proc/interrupts or /proc/softirqs between the last two samples
+struct InterruptSource {
+  LinuxParser::irqLine line;
+  bool softirq;
+  double rate;  // per second, on all CPUs
+  int topCpu;  // id of the CPU that handled most of them
+  double topShare;  // its share of `rate` (0..1); 0 for global counts
+};
+
+/*
+Interrupt and softirq rates per CPU from successive /proc/interrupts and
+/proc/softirqs samples.
+
+Lines are matched with the previous sample by name at the same position,
+which holds unless drivers registered or freed IRQs in between; such lines
+start over. The per-CPU rates are one flat matrix, NumCpus() per source,
+and the tables are reused between samples so that nothing is allocated
+once the set of lines is stable.
+
+The columns of the matrix are the online CPUs, those /proc/interrupts has.
+/proc/softirqs also lists the offline ones, so its columns are matched by
+CPU id, and the columns of offline CPUs are left out.
+*/
+class InterruptStats {
+ public:
+  void Update(const LinuxParser::irqTable& interrupts,
+              const LinuxParser::irqTable& softirqs,
+              std::chrono::steady_clock::time_point now);
+  // Forgets the previous sample, e.g. when the view is opened again
+  void Clear();
+  // False until two samples were taken
+  bool HasRates() const { return hasRates_; }
+  int NumCpus() const { return cpus_.size(); }
+  // The id of every column
+  const std::vector<int>& Cpus() const { return cpus_; }
+  // The lines of /proc/interrupts followed by those of /proc/softirqs
+  const std::vector<InterruptSource>& Sources() const { return sources_; }
+  // NumCpus() per second values of Sources()[index]
+  const double* CpuRates(size_t index) const {
+    return rates_.data() + index * cpus_.size();
+  }
+
+ private:
+  void updateTable(const LinuxParser::irqTable& current,
+                   const LinuxParser::irqTable& previous, bool softirq,
+                   double seconds);
+
+  LinuxParser::irqTable interrupts_{};
+  LinuxParser::irqTable softirqs_{};
+  std::vector<InterruptSource> sources_;
+  std::vector<double> rates_;
+  std::vector<int> cpus_;
+  // Column of the table being updated for every column of the matrix, -1
+  // where it has none
+  std::vector<int> columns_;
+  bool hasRates_ = false;
+  std::chrono::steady_clock::time_point time_;
+};
+
+#endif
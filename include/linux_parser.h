@@ -1,8 +1,12 @@
 #ifndef SYSTEM_PARSER_H
 #define SYSTEM_PARSER_H
 
+#include <sys/types.h>
+
+#include <array>
 #include <chrono>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "mem_data.h"
@@ -15,31 +19,226 @@ std::vector<int> Pids();
 std::string OperatingSystem();
 std::string Kernel();
 
+// PF_KTHREAD of the flags in /proc/<pid>/stat (include/linux/sched.h)
+#define PROC_FLAG_KTHREAD 0x00200000u
+
 struct procStatFileData {
   unsigned long utime;
   unsigned long stime;
   long niceval;
   long priorityval;
   char state;
+  unsigned int flags;  // PF_* of the task
   unsigned long long starttime;
 };
 
 struct procStatusFileData {
   struct ProcessMemUtilization memData;
   unsigned int numThreads;
+  uid_t uid;
+  uint64_t voluntaryCtxtSwitches;
+  uint64_t nonvoluntaryCtxtSwitches;
 };
 
-const std::vector<struct CPUDataWithHistory>& totalCpuUtilization();
+// Cumulative counters of /proc/<pid>/io
+struct procIoFileData {
+  uint64_t readBytes;
+  uint64_t writeBytes;
+  uint64_t cancelledWriteBytes;
+  uint64_t syscr;
+  uint64_t syscw;
+};
+
+// /proc/<pid>/schedstat: time on the CPU and time runnable but waiting for
+// one, in ns, and the number of timeslices
+struct procSchedstatData {
+  uint64_t runNs;
+  uint64_t waitNs;
+  uint64_t timeslices;
+};
+
+// Memory of /proc/<pid>/smaps_rollup in kB; private pages make up the USS
+struct procSmapsRollupData {
+  uint64_t rss;
+  uint64_t pss;
+  uint64_t privateClean;
+  uint64_t privateDirty;
+  uint64_t privateHugetlb;
+  uint64_t swap;
+  uint64_t swapPss;
+};
+
+// `fresh` reads /proc/stat even if the cached sample has not expired, for
+// samples taken sooner than the refresh interval
+const std::vector<struct CPUDataWithHistory>& totalCpuUtilization(
+    bool fresh = false);
 const struct MemData& MemoryUtilization();
 std::string LoadAverage();
 unsigned int numProcessesRunning();
+// NUMA node of every CPU (indexed like cpuN), empty without NUMA support
+std::vector<int> CpuNodes();
+
+// Memory of one NUMA node, from /sys/devices/system/node/node<N>/meminfo
+struct numaNodeData {
+  int node;
+  uint64_t memTotal;  // in kB, like the other memory values
+  uint64_t memFree;
+  uint64_t memUsed;
+};
+
+// Every node, lowest first; empty on machines with a single node, whose
+// memory is that of the whole system
+const std::vector<numaNodeData>& NumaNodes();
+// Pages of `pid` on every node, in kB and indexed by node, from
+// /proc/<pid>/numa_maps; false if the file cannot be read (other users'
+// processes, kernels without NUMA)
+bool NumaMaps(pid_t pid, std::vector<uint64_t>& nodeKb);
+
+// What the monitor itself uses: the CPU time and context switches of all of
+// its threads (getrusage), and its resident memory from /proc/self/status
+struct selfUsageData {
+  uint64_t cpuUs;
+  uint64_t voluntaryCtxtSwitches;
+  uint64_t nonvoluntaryCtxtSwitches;
+  uint64_t residentKb;
+  unsigned int numThreads;
+};
+selfUsageData SelfUsage();
+
+// cgroup v2 counters, read straight from /sys/fs/cgroup/<path>
+struct cgroupFileData {
+  bool valid;
+  uint64_t usageUsec;
+  uint64_t memCurrent;  // in kB, like the other memory values
+  uint64_t memAnon;
+  uint64_t memFile;
+  float cpuPressure;  // "some avg10" of the *.pressure files
+  float memoryPressure;
+  float ioPressure;
+};
+
+cgroupFileData parseCgroupFiles(const std::string& cgroupPath);
+
+// Cumulative counters of one interface in /proc/net/dev
+struct netDevData {
+  char name[16];  // IFNAMSIZ
+  uint64_t rxBytes;
+  uint64_t rxPackets;
+  uint64_t rxErrors;
+  uint64_t rxDrops;
+  uint64_t txBytes;
+  uint64_t txPackets;
+  uint64_t txErrors;
+  uint64_t txDrops;
+};
+
+// One line of a PSI file: share of the time (percent) some or all
+// non-idle tasks were stalled, and the total stall time in microseconds
+struct psiLine {
+  float avg10;
+  float avg60;
+  float avg300;
+  uint64_t total;
+};
+
+struct psiFileData {
+  bool valid;
+  psiLine some;
+  psiLine full;  // all zero for the CPU before Linux 5.13
+};
+
+// Resources of /proc/pressure, in the order Pressure() returns them
+enum PsiResource { PSI_CPU, PSI_MEMORY, PSI_IO, PSI_NUM_RESOURCES };
+
+// /proc/pressure/{cpu,memory,io}; invalid on kernels without PSI (before
+// 4.20 or booted with psi=0), which are not asked again
+const std::array<psiFileData, PSI_NUM_RESOURCES>& Pressure();
+
+// Cumulative counters of one block device in /proc/diskstats
+struct diskStatsData {
+  char name[32];  // DISK_NAME_LEN
+  uint64_t reads;  // completed requests
+  uint64_t readSectors;  // 512 byte units
+  uint64_t readMs;  // time the requests took
+  uint64_t writes;
+  uint64_t writeSectors;
+  uint64_t writeMs;
+  uint64_t inFlight;
+  uint64_t ioMs;  // time with requests in flight
+  uint64_t weightedMs;  // time requests spent in flight, added up
+};
+
+// The disks that have done I/O and do not sit on top of other disks:
+// partitions, device-mapper and md devices are left out, as their I/O is
+// already counted on the disks below them
+const std::vector<diskStatsData>& DiskStatistics();
+
+// A source of interrupts: an IRQ line of /proc/interrupts ("36", "NMI",
+// "LOC") or a softirq of /proc/softirqs ("NET_RX")
+struct irqLine {
+  char name[16];
+  char description[32];  // the device or handler; empty for softirqs
+  bool global;  // one system wide count (ERR, MIS), kept as CPU 0's
+};
+
+// Counters of every line on every CPU, flat: numCpus per line, in the order
+// of the file. The columns are those of the header: the online CPUs in
+// /proc/interrupts, the possible ones in /proc/softirqs.
+struct irqTable {
+  int numCpus;
+  std::vector<int> cpus;  // the id of every column ("CPU<id>")
+  std::vector<irqLine> lines;
+  std::vector<uint64_t> counts;
+};
+
+// /proc/interrupts and /proc/softirqs
+const irqTable& Interrupts();
+const irqTable& SoftIrqs();
+
+// Every interface, in the order of /proc/net/dev
+const std::vector<netDevData>& NetworkDevices();
+// Backed by a device (/sys/class/net/<name>/device), unlike loopback, veth,
+// bridges, tunnels and the like
+bool IsPhysicalInterface(const char* name);
 
 // Processes
-std::string Command(pid_t pid);
+// At most `maxLength` bytes of the command line, arguments separated by
+// spaces; empty for kernel threads, zombies and processes that are gone
+std::string Command(pid_t pid, size_t maxLength);
+// All of the command line, however long
+std::string FullCommand(pid_t pid);
+std::string Cgroup(pid_t pid);
 procStatusFileData parseProcStatusFilePid(int pid);
 std::string Uid(pid_t pid);
+std::string UserName(uid_t uid);
 struct procStatFileData parseProcStatFilePid(pid_t pid);
 
+// Allocation-free parsers over raw file contents, shared by the file based
+// readers above and the batched sampler
+struct procStatFileData parseProcStatBuffer(std::string_view buffer);
+// The command name (comm) between the parentheses of a stat buffer
+std::string_view parseProcStatComm(std::string_view buffer);
+procStatusFileData parseProcStatusBuffer(std::string_view buffer);
+procIoFileData parseProcIoBuffer(std::string_view buffer);
+procSchedstatData parseProcSchedstatBuffer(std::string_view buffer);
+procSmapsRollupData parseProcSmapsRollupBuffer(std::string_view buffer);
+// Adds the pages of one numa_maps line ("7f12c000 default anon=3 N0=2 N1=1
+// kernelpagesize_kB=4") to `nodeKb`, which grows to the highest node
+void parseNumaMapsLine(std::string_view line, std::vector<uint64_t>& nodeKb);
+// "Node 0 MemTotal: ..." lines of a node's meminfo
+numaNodeData parseNodeMeminfoBuffer(std::string_view buffer);
+// Soft "Max open files" of /proc/<pid>/limits, 0 for unlimited or unknown
+uint64_t parseProcLimitsNoFile(std::string_view buffer);
+// Replace the contents of `devices`, whose capacity is reused
+void parseNetDevBuffer(std::string_view buffer,
+                       std::vector<netDevData>& devices);
+void parseDiskStatsBuffer(std::string_view buffer,
+                          std::vector<diskStatsData>& devices);
+// Replace the contents of `table`, whose capacity is reused
+void parseIrqBuffer(std::string_view buffer, irqTable& table);
+// A /proc/pressure or cgroup *.pressure file
+psiFileData parsePsiBuffer(std::string_view buffer);
+
 }  // namespace LinuxParser
 
 #endif
\ No newline at end of file
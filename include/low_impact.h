@@ -0,0 +1,49 @@
+#ifndef MONITOR_LOW_IMPACT_H
+#define MONITOR_LOW_IMPACT_H
+
+#include <string>
+#include <vector>
+
+// Stack touched before the memory is locked, so that the deepest calls do
+// not fault either
+#define LOW_IMPACT_STACK_PREFAULT (256 * 1024)
+
+/*
+Keeps the monitor out of the way of the workloads it watches: it can run
+under SCHED_IDLE or a nice level, on a set of housekeeping CPUs, and with
+its memory locked so that sampling never waits on a page fault.
+
+The policy is applied to the main thread before any other thread starts.
+Threads inherit the scheduling policy, nice value and CPU affinity of the
+thread that creates them, so the sampler, the UI threads and the exporter
+all follow it.
+*/
+namespace LowImpact {
+
+struct Policy {
+  bool idle = false;  // SCHED_IDLE
+  bool setNice = false;
+  int nice = 0;
+  std::vector<int> cpus;  // empty keeps the inherited affinity
+  bool lockMemory = false;
+
+  bool Enabled() const {
+    return idle || setNice || !cpus.empty() || lockMemory;
+  }
+};
+
+// "0,2-3" style CPU list, like taskset -c
+bool ParseCpuList(const std::string& text, std::vector<int>& cpus);
+
+// Must run before any thread is started; prints what failed and returns
+// false if a part of the policy could not be applied
+bool Apply(const Policy& policy);
+
+// The policy in effect, and a short description of it ("idle, cpus 0-1,
+// mlock") for the footprint line
+const Policy& Current();
+std::string Describe();
+
+}  // namespace LowImpact
+
+#endif
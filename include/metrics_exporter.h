@@ -0,0 +1,50 @@
+#ifndef MONITOR_METRICS_EXPORTER_H
+#define MONITOR_METRICS_EXPORTER_H
+
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "output_buffer.h"
+
+class System;
+
+// Per-process series exported when --top is not given
+#define EXPORTER_DEFAULT_TOP_PROCESSES 20
+
+/*
+Embedded HTTP endpoint serving the latest sample in OpenMetrics text format.
+
+The complete response (headers and exposition) is rendered once per tick by
+the sampler and published as an immutable buffer. Every scraper is answered
+straight from the buffer that was current when its request arrived, so the
+cost of a scrape does not depend on the number of scrapers.
+*/
+class MetricsExporter {
+ public:
+  MetricsExporter() = default;
+  ~MetricsExporter();
+  MetricsExporter(const MetricsExporter&) = delete;
+  MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+  // `address` is "[host]:port" (host defaults to 127.0.0.1) or
+  // "unix:/path/to/socket"
+  bool Start(const std::string& address, size_t topProcesses);
+  void Stop();
+
+  // Renders the sample `system` just took; called from the sampler thread
+  void Publish(System& system);
+
+ private:
+  void serve();
+
+  int listenFd_ = -1;
+  int wakePipe_[2] = {-1, -1};
+  std::string unixPath_;
+  size_t topProcesses_ = 0;
+  std::thread thread_;
+  std::shared_ptr<const std::string> response_;
+  OutputBuffer body_;
+};
+
+#endif
@@ -1,11 +1,14 @@
 #ifndef MONITOR_NCURSES_DISPLAY_H
 #define MONITOR_NCURSES_DISPLAY_H
 
-class System;
+#include <vector>
+
+class DataSource;
 
 namespace NCursesDisplay {
 
-void Display(System& system);
+// Runs the UI until 'q'; `columns` are the visible Columns::kColumns indices
+void Display(DataSource& system, const std::vector<int>& columns);
 
 }
 
@@ -0,0 +1,65 @@
+#ifndef MONITOR_NETWORK_STATS_H
+#define MONITOR_NETWORK_STATS_H
+
+#include <chrono>
+#include <vector>
+
+#include "linux_parser.h"
+
+// Which interfaces the totals and the interface list take in
+enum class NetFilter {
+  PHYSICAL,  // backed by a device
+  EXTERNAL,  // everything but loopback
+  ALL
+};
+
+// Per second values between the last two samples
+struct NetRates {
+  double rxBytes;
+  double rxPackets;
+  double rxErrors;
+  double rxDrops;
+  double txBytes;
+  double txPackets;
+  double txErrors;
+  double txDrops;
+};
+
+struct NetInterface {
+  LinuxParser::netDevData counters;
+  NetRates rates;
+  bool hasRates;  // false for the first sample of an interface
+  bool physical;
+  bool loopback;
+};
+
+/*
+Rates of the network interfaces from successive /proc/net/dev samples.
+
+Interfaces are matched with the previous sample by name. The file keeps them
+in a stable order, so the match is at the same position unless interfaces
+came or went, and the sysfs lookup telling physical from virtual interfaces
+only runs for new names. Hundreds of veth interfaces thus cost one read and
+a linear pass per sample; the vectors keep their capacity, so a steady set
+of interfaces does not allocate.
+*/
+class NetworkStats {
+ public:
+  void Update(const std::vector<LinuxParser::netDevData>& devices,
+              std::chrono::steady_clock::time_point now);
+  const std::vector<NetInterface>& Interfaces() const { return interfaces_; }
+
+  static bool Admits(NetFilter filter, const NetInterface& interface);
+  // Sum of the rates of the interfaces `filter` admits
+  NetRates Total(NetFilter filter) const;
+  // What the totals and the history count: the physical interfaces, or all
+  // but loopback where there are none (e.g. in a container)
+  NetFilter DefaultFilter() const;
+
+ private:
+  std::vector<NetInterface> interfaces_;
+  std::vector<NetInterface> previous_;
+  std::chrono::steady_clock::time_point time_;
+};
+
+#endif
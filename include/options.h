@@ -0,0 +1,34 @@
+#ifndef MONITOR_OPTIONS_H
+#define MONITOR_OPTIONS_H
+
+#include <string>
+
+#include "globals.h"
+#include "low_impact.h"
+
+namespace CommandLine {
+
+enum class OutputFormat { JSON, CSV };
+
+struct Options {
+  bool batch = false;
+  int intervalMs = GLOBAL_REFRESH_RATE;
+  long iterations = 0;  // 0 keeps sampling until interrupted
+  size_t topN = 0;      // 0 outputs every process
+  OutputFormat format = OutputFormat::JSON;
+  std::string fields;   // comma separated, empty selects the defaults
+  std::string recordPath;  // record mode when set
+  std::string replayPath;  // replay mode when set
+  std::string listenAddress;  // OpenMetrics endpoint when set
+  std::string benchmark;      // runs the named benchmark and exits
+  size_t cmdlineMax = GLOBAL_CMDLINE_MAX;  // bytes of a command line kept
+  LowImpact::Policy policy;  // scheduling, CPUs and memory of the monitor
+};
+
+// Returns false (after printing usage) if the arguments are invalid or help
+// was requested; `exitCode` tells which
+bool Parse(int argc, char* argv[], Options& options, int& exitCode);
+
+}  // namespace CommandLine
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef MONITOR_OUTPUT_BUFFER_H
+#define MONITOR_OUTPUT_BUFFER_H
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// Growable byte buffer reused across ticks. Numbers are formatted in place
+// with std::to_chars, so appending never allocates once the buffer is warm.
+class OutputBuffer {
+ public:
+  void Clear() { size_ = 0; }
+  size_t Size() const { return size_; }
+  std::string_view View() const { return std::string_view(data_.data(), size_); }
+
+  void Append(std::string_view text) {
+    reserve(text.size());
+    std::memcpy(data_.data() + size_, text.data(), text.size());
+    size_ += text.size();
+  }
+
+  void Append(char c) {
+    reserve(1);
+    data_[size_++] = c;
+  }
+
+  template <typename T>
+  void AppendInteger(T value) {
+    reserve(24);
+    char* begin = data_.data() + size_;
+    size_ = std::to_chars(begin, begin + 24, value).ptr - data_.data();
+  }
+
+  // Fixed notation with `precision` digits after the decimal point
+  void AppendFixed(double value, int precision) {
+    reserve(32);
+    char* begin = data_.data() + size_;
+    auto result = std::to_chars(begin, begin + 32, value,
+                                std::chars_format::fixed, precision);
+    if (result.ec != std::errc()) {
+      // Too large for fixed notation, let to_chars pick the shortest form
+      reserve(64);
+      begin = data_.data() + size_;
+      result = std::to_chars(begin, begin + 64, value);
+    }
+    size_ = result.ptr - data_.data();
+  }
+
+  // Writes the whole buffer to `fd`, retrying on partial writes
+  bool WriteTo(int fd) const {
+    size_t written = 0;
+    while (written < size_) {
+      ssize_t ret = write(fd, data_.data() + written, size_ - written);
+      if (ret < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      written += ret;
+    }
+    return true;
+  }
+
+ private:
+  void reserve(size_t extra) {
+    if (size_ + extra > data_.size()) {
+      data_.resize(std::max(data_.size() * 2, size_ + extra));
+    }
+  }
+
+  std::vector<char> data_;
+  size_t size_ = 0;
+};
+
+#endif
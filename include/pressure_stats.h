@@ -0,0 +1,41 @@
+#ifndef MONITOR_PRESSURE_STATS_H
+#define MONITOR_PRESSURE_STATS_H
+
+#include <array>
+#include <chrono>
+
+#include "linux_parser.h"
+
+// Percent of the time between two samples tasks were stalled
+struct PsiStall {
+  float some;
+  float full;
+};
+
+/*
+System wide pressure stall information. Keeps the last /proc/pressure
+sample, whose avg10/avg60/avg300 the kernel averages itself, and turns the
+growth of the stall totals into the stall share of the last interval.
+*/
+class PressureStats {
+ public:
+  void Update(const std::array<LinuxParser::psiFileData, LinuxParser::PSI_NUM_RESOURCES>&
+                  pressure,
+              std::chrono::steady_clock::time_point now);
+  // False on kernels without PSI
+  bool Available() const { return pressure_[LinuxParser::PSI_CPU].valid; }
+  const LinuxParser::psiFileData& File(LinuxParser::PsiResource resource) const {
+    return pressure_[resource];
+  }
+  // Zero until two samples were taken
+  const PsiStall& Stall(LinuxParser::PsiResource resource) const {
+    return stall_[resource];
+  }
+
+ private:
+  std::array<LinuxParser::psiFileData, LinuxParser::PSI_NUM_RESOURCES> pressure_{};
+  std::array<PsiStall, LinuxParser::PSI_NUM_RESOURCES> stall_{};
+  std::chrono::steady_clock::time_point time_;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef MONITOR_PROC_READER_H
+#define MONITOR_PROC_READER_H
+
+#include <sched.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Thread ids listed per getdents64 call of a task directory walk; a record
+// takes at least 24 bytes
+#define PROC_READER_TASK_IDS 256
+
+/*
+Batched reader for the per-PID procfs files the sampler needs on every tick
+(/proc/<pid>/stat and /proc/<pid>/status). Files are opened relative to a
+/proc directory descriptor and read into preallocated per-slot buffers.
+
+When built with io_uring support and the running kernel accepts it, the opens,
+reads and closes of a whole chunk of PIDs are submitted with two
+io_uring_enter calls. Otherwise every file goes through openat/read/close.
+*/
+
+class ProcBatchReader {
+ public:
+  // Called once per PID with the raw file contents. A view is empty when the
+  // file could not be read (typically because the process already exited).
+  using Callback = std::function<void(size_t index, std::string_view stat,
+                                      std::string_view status)>;
+
+  ProcBatchReader();
+  ~ProcBatchReader();
+  ProcBatchReader(const ProcBatchReader&) = delete;
+  ProcBatchReader& operator=(const ProcBatchReader&) = delete;
+
+  // Stops before the next chunk once `stop` is set
+  void ReadBatch(const std::vector<pid_t>& pids, const Callback& callback,
+                 const std::atomic<bool>* stop = nullptr);
+  bool UsingIoUring() const;
+  int ProcDirFd() const { return procDirFd_; }
+
+  // Synchronous single-file read of /proc/<pid>/<name> into `buffer`
+  static std::string_view ReadFile(int procDirFd, pid_t pid, const char* name,
+                                   char* buffer, size_t size);
+  // Open descriptors of `pid`, counted with raw getdents64 calls on
+  // /proc/<pid>/fd; -1 (errno set) if the directory cannot be listed. With
+  // `sockets`, every link is read to count the sockets among them.
+  static int CountFds(int procDirFd, pid_t pid, int* sockets);
+  // Calls `callback` with /proc/<pid>/task/<tid>/<name> of every thread,
+  // read into `buffer`; false if the task directory cannot be listed.
+  // Threads that exit meanwhile are skipped.
+  template <typename Func>
+  static bool ReadTaskFiles(int procDirFd, pid_t pid, const char* name,
+                            char* buffer, size_t size, Func&& callback);
+
+ private:
+  struct Ring;
+
+  // /proc/<pid>/task, and the next thread ids in it: 0 at the end, -1 if
+  // the directory cannot be read
+  static int openTaskDir(int procDirFd, pid_t pid);
+  static int readTaskIds(int dirFd, pid_t* tids);
+
+  void readChunkSync(const pid_t* pids, size_t count);
+  bool readChunkIoUring(const pid_t* pids, size_t count);
+  void closeSlots(size_t slots);
+
+  int procDirFd_;
+  std::unique_ptr<Ring> ring_;
+  std::vector<char> statBuffers_;
+  std::vector<char> statusBuffers_;
+  std::vector<char> paths_;
+  std::vector<int> fds_;
+  std::vector<int> lengths_;
+};
+
+template <typename Func>
+bool ProcBatchReader::ReadTaskFiles(int procDirFd, pid_t pid, const char* name,
+                                    char* buffer, size_t size,
+                                    Func&& callback) {
+  int dirFd = openTaskDir(procDirFd, pid);
+  if (dirFd < 0) return false;
+  pid_t tids[PROC_READER_TASK_IDS];
+  int count;
+  while ((count = readTaskIds(dirFd, tids)) > 0) {
+    for (int i = 0; i < count; ++i) {
+      std::string_view contents = ReadFile(dirFd, tids[i], name, buffer, size);
+      if (!contents.empty()) callback(contents);
+    }
+  }
+  close(dirFd);
+  return count == 0;
+}
+
+#endif
@@ -3,7 +3,9 @@
 
 #include <sched.h>
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <chrono>
 #include <memory>
 
@@ -14,43 +16,174 @@ It contains relevant attributes as shown below
 
 struct ProcessMemUtilization;
 
+namespace LinuxParser {
+struct procStatFileData;
+struct procStatusFileData;
+struct procIoFileData;
+struct procSchedstatData;
+struct procSmapsRollupData;
+}  // namespace LinuxParser
+
 class Process {
 public:
   pid_t Pid();
-  std::string User();
+  const std::string& User();
   const std::string& Command();
-  float CpuUtilization(bool allowUpdate = true);
+  float CpuUtilization();
   const ProcessMemUtilization& MemUtilization();
   long NiceValue();
   long PriorityValue();
   char State();
   double UpTime();
   unsigned int getNumThreads();
+  unsigned long long StartTime();
+  unsigned long ActiveJiffies();
+  const std::string& Cgroup();
+
+  // Bytes and read/write syscalls per second between the last two reads of
+  // /proc/<pid>/io; only valid with IoAvailable()
+  bool IoAvailable();
+  double IoReadRate();
+  double IoWriteRate();
+  double IoSyscallRate();
+  // The file could not be read for lack of permission; it is not tried again
+  bool IoDenied();
+  void UpdateIo(const LinuxParser::procIoFileData& ioData,
+                std::chrono::steady_clock::time_point now);
+  void DenyIo();
+
+  // Voluntary (blocking) and involuntary (preempted) context switches per
+  // second of the main thread, which is all that status counts; only valid
+  // with CtxtAvailable()
+  bool CtxtAvailable();
+  double VoluntaryCtxtRate();
+  double NonvoluntaryCtxtRate();
+
+  // Time runnable but waiting for a CPU between the last two reads of
+  // schedstat, summed over all threads, in percent of one CPU like
+  // CpuUtilization(); only valid with SchedAvailable(). A thread that exited
+  // in between takes its wait along, so such an interval can read low.
+  // `summed` tells the thread sums apart from main thread reads, which are
+  // not compared with each other.
+  bool SchedAvailable();
+  double WaitPercent();
+  void UpdateSchedstat(const LinuxParser::procSchedstatData& schedData,
+                       bool summed, std::chrono::steady_clock::time_point now);
+
+  // When the pass over SAMPLE_SOURCES_PASS last got to the process
+  std::chrono::steady_clock::time_point PassTime();
+  void SetPassTime(std::chrono::steady_clock::time_point now);
 
-  explicit Process(pid_t pid);
+  // Proportional and unique set size in kB from the last read of
+  // /proc/<pid>/smaps_rollup; only valid with SmapsAvailable()
+  bool SmapsAvailable();
+  uint64_t Pss();
+  uint64_t Uss();
+  // Like IoDenied(), for smaps_rollup
+  bool SmapsDenied();
+  void UpdateSmaps(const LinuxParser::procSmapsRollupData& smapsData);
+  void DenySmaps();
+
+  // Open descriptors and the soft RLIMIT_NOFILE (0 for unlimited) from the
+  // last walk of /proc/<pid>/fd; only valid with FdAvailable()
+  bool FdAvailable();
+  int FdCount();
+  uint64_t FdLimit();
+  // Share of the soft limit in use, 0 without a limit
+  double FdUsage();
+  // Sockets among the descriptors; only valid with SocketsAvailable()
+  bool SocketsAvailable();
+  int SocketCount();
+  // Like IoDenied(), for the fd directory
+  bool FdDenied();
+  // A negative `sockets` keeps the previous socket count
+  void UpdateFds(int count, int sockets, uint64_t limit);
+  void DenyFds();
+
+  // `comm` is the name from stat, shown in brackets as ps does for kernel
+  // threads and processes without a command line (zombies); the others
+  // read up to Globals::CmdlineMaxLength() bytes of theirs
+  Process(pid_t pid, const LinuxParser::procStatFileData& statData,
+          const LinuxParser::procStatusFileData& statusData,
+          unsigned long long totalSystemJiffies,
+          std::chrono::steady_clock::time_point now, std::string_view comm);
+  // PF_KTHREAD was set when the process was created
   bool isKernelProcess();
 
+  // Rebuilds a process from a recording; values are set through Restore()
+  Process(pid_t pid, std::string user, std::string command);
+  void Restore(const LinuxParser::procStatFileData& statData,
+               const LinuxParser::procStatusFileData& statusData,
+               float cpuUtilization);
+
+  // Feed a fresh sample taken by the ProcessManager
+  void Update(const LinuxParser::procStatFileData& statData,
+              const LinuxParser::procStatusFileData& statusData,
+              unsigned long long totalSystemJiffies, int numCpus,
+              std::chrono::steady_clock::time_point now);
+
 private:
   pid_t pid_;
   std::string user_;
   std::string _command;
+  std::string _cgroup;
+  bool _cgroupRead = false;
   unsigned long _lastActiveJiffies;
-  unsigned long _lastTotalSystemJiffies;
+  unsigned long long _lastTotalSystemJiffies;
   float _cpuUtilization;
-  std::chrono::time_point<std::chrono::steady_clock>
-      _lastUpdate;
   std::unique_ptr<ProcessMemUtilization> _memUtilization;
   bool _is_kernel_process = false;
   long _nice_value;
   long _priority_value;
-  bool _isUpdateNeeded();
-  void _updateProcStatFileData();
+  void _updateProcStatFileData(const LinuxParser::procStatFileData& data);
   char _state;
   unsigned long _utime;
   unsigned long _stime;
+  unsigned long long _starttime;
   unsigned int _numThreads;
-  void _updateProcStatusFileData();
-  void _updateCpuUtilization();
+  // /proc/<pid>/io counters of the previous read
+  bool _ioSampled = false;
+  bool _ioAvailable = false;
+  bool _ioDenied = false;
+  std::chrono::steady_clock::time_point _ioTime;
+  uint64_t _ioReadBytes = 0;
+  uint64_t _ioWriteBytes = 0;
+  uint64_t _ioSyscalls = 0;
+  double _ioReadRate = 0;
+  double _ioWriteRate = 0;
+  double _ioSyscallRate = 0;
+  // Context switch counters of the previous status read
+  bool _ctxtAvailable = false;
+  std::chrono::steady_clock::time_point _ctxtTime;
+  uint64_t _voluntaryCtxt = 0;
+  uint64_t _nonvoluntaryCtxt = 0;
+  double _voluntaryCtxtRate = 0;
+  double _nonvoluntaryCtxtRate = 0;
+  void _updateCtxtRates(const LinuxParser::procStatusFileData& data,
+                        std::chrono::steady_clock::time_point now);
+  // /proc/<pid>/schedstat wait time of the previous read
+  bool _schedSampled = false;
+  bool _schedSummed = false;
+  bool _schedAvailable = false;
+  std::chrono::steady_clock::time_point _schedTime;
+  uint64_t _waitNs = 0;
+  double _waitPercent = 0;
+  std::chrono::steady_clock::time_point _passTime;
+  // /proc/<pid>/smaps_rollup values of the last read
+  bool _smapsAvailable = false;
+  bool _smapsDenied = false;
+  uint64_t _pss = 0;
+  uint64_t _uss = 0;
+  // /proc/<pid>/fd and limits of the last read
+  bool _fdAvailable = false;
+  bool _socketsAvailable = false;
+  bool _fdDenied = false;
+  int _fdCount = 0;
+  int _socketCount = 0;
+  uint64_t _fdLimit = 0;
+  void _updateProcStatusFileData(const LinuxParser::procStatusFileData& data);
+  void _updateCpuUtilization(unsigned long long totalSystemJiffies,
+                             int numCpus);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,40 @@
+#ifndef MONITOR_PROCESS_FILTER_H
+#define MONITOR_PROCESS_FILTER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Case-insensitive substring filter over the user and command of every process.
+
+The entries of one snapshot are lowercased into a single contiguous arena, so
+a query is a linear scan over it (16 bytes at a time with SSE2). When a query
+extends the previous one, only the previous matches are scanned again.
+*/
+class ProcessFilter {
+ public:
+  // Starts a new set of entries and drops the previous results
+  void Clear();
+  void Add(std::string_view user, std::string_view command);
+  size_t Size() const { return offsets_.size() - 1; }
+
+  // Indices (in Add() order) of the entries whose user or command contains
+  // `query`, ignoring ASCII case
+  const std::vector<uint32_t>& Apply(std::string_view query);
+
+  // Position of `query` in `text` ignoring ASCII case, or npos
+  static size_t Find(std::string_view text, std::string_view query);
+
+ private:
+  std::vector<char> arena_;
+  // Entry i is arena_[offsets_[i], offsets_[i + 1])
+  std::vector<uint32_t> offsets_{0};
+  std::vector<uint32_t> matches_;
+  std::vector<uint32_t> candidates_;
+  std::string query_;  // lowercased query `matches_` belongs to
+  bool valid_ = false;
+};
+
+#endif
@@ -1,35 +1,116 @@
 #ifndef MONITOR_PROCESS_MANAGER_H
 #define MONITOR_PROCESS_MANAGER_H
 
+#include <atomic>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <chrono>
 
+#include "cgroup_manager.h"
+#include "linux_parser.h"
+#include "proc_reader.h"
+#include "sample_scheduler.h"
+
+// New processes are built on worker threads when a scan finds at least this
+// many (the first one, mostly), with up to PROCESS_SCAN_THREADS of them
+#define PROCESS_PARALLEL_MIN 256
+#define PROCESS_SCAN_THREADS 8
+
 class Process;
 
 // Process manager for efficient parsing
 class ProcessManager {
  public:
-  void UpdateProcesses();
+  // `force` samples even if the last update is less than an interval ago,
+  // with fresh CPU totals; returns whether a new sample was taken. The
+  // first call creates every process.
+  bool UpdateProcesses(bool force = false);
   ProcessManager();
-  std::vector<std::shared_ptr<Process>> GetSortedProcessesForDisplay();
+  // Sorted by CPU utilization; a non-zero `limit` keeps only the top entries
+  std::vector<std::shared_ptr<Process>> GetSortedProcessesForDisplay(
+      size_t limit = 0);
+  static void SortForDisplay(std::vector<std::shared_ptr<Process>>& processes,
+                             size_t limit = 0);
 
   unsigned int getNumOfTasks();
   unsigned int getNumOfThreads();
   unsigned int getNumOfRunningTasks();
 
+  // cgroup aggregation is only sampled while somebody looks at it
+  void SetCgroupTracking(bool enabled);
+  bool IsCgroupTrackingEnabled();
+  const CgroupManager& Cgroups();
+
+  // SAMPLE_SOURCE_* somebody shows; the optional ones are read on the tier
+  // the scheduler assigns them
+  void SetWantedSources(uint32_t sources);
+  // PIDs on screen; slow sources read them before the others
+  void SetVisiblePids(std::vector<pid_t> pids);
+  // Worker threads of the scans that create many processes; 1 builds them
+  // on the calling thread
+  void SetScanThreads(unsigned int threads);
+  // Makes an UpdateProcesses() running on another thread return false
+  // between two batch chunks, and every later call right away; for quitting
+  // during a long first scan
+  void Cancel();
+
+  // Kernel threads are left out unless shown; shown ones only have their
+  // stat and status sampled
+  void SetShowKernelThreads(bool show);
+  bool ShowKernelThreads();
+
  private:
-  void AddProcessIfNotExists(pid_t pid);
   void CleanupStaleProcesses(const std::vector<pid_t>& currentPids);
 
   std::unordered_map<pid_t, std::shared_ptr<Process>> processMap_;    // Store process data by PID
-  unsigned int _numOfTasks;
-  unsigned int _numOfThreads;
-  unsigned int _numOfRunningTasks;
+  // PIDs of hidden kernel threads: they are left out of the batch rather
+  // than probed and thrown away every tick. Every SAMPLE_SLOW_TIER_TICKS
+  // they are read again, and one without PF_KTHREAD was reused by a user
+  // process, which is thus missing for up to that many ticks.
+  std::unordered_set<pid_t> kernelThreads_;
+  std::vector<pid_t> batchPids_;
+  uint64_t kernelThreadTick_ = 0;
+  bool showKernelThreads_ = false;
+  unsigned int _numOfTasks = 0;
+  unsigned int _numOfThreads = 0;
+  unsigned int _numOfRunningTasks = 0;
   void _updateNumOfThreads();
+  void _updateCgroups();
+  void _updateIo(std::chrono::steady_clock::time_point now);
+  void _updateSchedstat(std::chrono::steady_clock::time_point now);
+  void _updatePass(uint32_t sources, bool due,
+                   std::chrono::steady_clock::time_point now);
+  void _readPassSources(Process& process, uint32_t sources,
+                        std::chrono::steady_clock::time_point now);
+
+  // A process the current scan found, built once the batch is read
+  struct NewProcess {
+    pid_t pid;
+    LinuxParser::procStatFileData stat;
+    LinuxParser::procStatusFileData status;
+    std::string comm;
+    std::shared_ptr<Process> process;
+  };
+  void _createProcesses(unsigned long long totalSystemJiffies,
+                        std::chrono::steady_clock::time_point now);
+  std::vector<NewProcess> newProcesses_;
+  unsigned int scanThreads_ = PROCESS_SCAN_THREADS;
+  std::atomic<bool> cancelled_{false};
 
   std::chrono::steady_clock::time_point lastUpdateTime_;
+  ProcBatchReader procReader_;
+  CgroupManager cgroupManager_;
+  bool cgroupTracking_ = false;
+  SampleScheduler scheduler_;
+  std::vector<pid_t> visiblePids_;
+  // The pass over SAMPLE_SOURCES_PASS in progress: PIDs still to read from
+  // passNext_ on
+  std::vector<pid_t> passQueue_;
+  size_t passNext_ = 0;
+  bool passRestart_ = false;
+  std::chrono::steady_clock::time_point passStart_;
 };
 
 #endif
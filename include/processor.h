@@ -27,6 +27,18 @@ struct CPUDataWithHistory {
   void setPrevious(const CPUData &other) {
     previous = other;
   }
+
+  // Busy ratio (0..1) since the previous sample, or since boot without one
+  float Utilization() const {
+    if (previous.has_value()) {
+      uint64_t totaltime_delta = current.totaltime - previous->totaltime;
+      uint64_t idletime_delta = current.idletime - previous->idletime;
+      if (totaltime_delta == 0) return 0.0f;
+      return 1.0f - (double)(idletime_delta) / totaltime_delta;
+    }
+    if (current.totaltime == 0) return 0.0f;
+    return 1.0f - (double)(current.idletime) / current.totaltime;
+  }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,155 @@
+#ifndef MONITOR_RECORDING_H
+#define MONITOR_RECORDING_H
+
+#include <sched.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "data_source.h"
+#include "disk_stats.h"
+#include "history.h"
+#include "mem_data.h"
+#include "options.h"
+#include "output_buffer.h"
+#include "processor.h"
+
+class System;
+
+/*
+Compact binary recording of the sampled data, one frame per tick.
+
+Every frame holds the system counters and the process rows. Values are
+zigzag/varint encoded as deltas against the previous frame; processes that
+did not change are not written at all. Every RECORDING_KEYFRAME_INTERVAL
+frames a keyframe holds the complete state, and an index of all frames is
+appended when the recording is closed, so a replay can seek without decoding
+the whole file. A recording that was never closed is indexed by scanning the
+frame headers.
+*/
+
+namespace Recording {
+
+// Per-process values, in encoding order
+enum ProcessField {
+  STATE,
+  PRIORITY,
+  NICE,
+  START_TIME,
+  ACTIVE_JIFFIES,
+  VIRTUAL_MEM,
+  RESIDENT_MEM,
+  SHARED_MEM,
+  THREADS,
+  CPU_PERMILLE,  // CPU% * 10
+  NUM_PROCESS_FIELDS
+};
+
+struct ProcessRecord {
+  std::string user;
+  std::string command;
+  int64_t fields[NUM_PROCESS_FIELDS];
+};
+
+struct IndexEntry {
+  uint64_t offset;
+  int64_t timestampMs;
+  bool keyframe;
+};
+
+class Recorder {
+ public:
+  ~Recorder();
+  bool Open(const std::string& path, int intervalMs, const std::string& os,
+            const std::string& kernel);
+  // Appends the current state of `system` as one frame
+  bool Append(System& system);
+  // Writes the index; a recording that is not closed stays readable
+  bool Close();
+
+ private:
+  bool writeFrame(char kind);
+
+  int fd_ = -1;
+  uint64_t offset_ = 0;
+  std::vector<int64_t> systemValues_;
+  std::vector<int64_t> previousSystemValues_;
+  std::map<pid_t, ProcessRecord> previousProcesses_;
+  std::vector<std::shared_ptr<Process>> processes_;
+  std::vector<pid_t> removed_;
+  std::vector<pid_t> added_;
+  std::vector<IndexEntry> index_;
+  OutputBuffer changes_;
+  OutputBuffer payload_;
+  OutputBuffer frame_;
+};
+
+// Replays a recording through the regular UI; 'p' pauses, ',' and '.' step
+// one frame, '[' and ']' seek by a minute
+class Player : public DataSource {
+ public:
+  ~Player() override;
+  bool Open(const std::string& path);
+  int IntervalMs() const;
+
+  void Update() override;
+  std::vector<std::shared_ptr<Process>> GetSortedProcesses() override;
+  unsigned int getNumOfTasks() override;
+  unsigned int getNumOfThreads() override;
+  unsigned int getNumOfRunningTasks() override;
+
+  const MemData& MemoryUtilization() override;
+  unsigned long long UpTime() override;
+  std::string LoadAverage() override;
+  const std::vector<CPUDataWithHistory>& totalCpuUtilization() override;
+  std::string Kernel() override;
+  std::string OperatingSystem() override;
+
+  bool HandleKey(int key) override;
+  std::string StatusText() override;
+  const SampleHistory* History() override { return &history_; }
+  const DiskStats* Disks() override { return &disks_; }
+
+ private:
+  bool loadIndex();
+  bool scanFrames();
+  bool decodeFrame(size_t frame);
+  void seek(size_t frame);
+  void applyDecodedState();
+
+  int fd_ = -1;
+  int intervalMs_ = 0;
+  std::string os_;
+  std::string kernel_;
+  uint64_t dataStart_ = 0;
+  uint64_t dataEnd_ = 0;
+  std::vector<IndexEntry> frames_;
+  size_t currentFrame_ = 0;
+  bool paused_ = false;
+  std::chrono::steady_clock::time_point lastAdvance_;
+
+  std::vector<char> payload_;
+  std::vector<int64_t> systemValues_;
+  std::map<pid_t, ProcessRecord> records_;
+  std::unordered_map<pid_t, std::shared_ptr<Process>> processes_;
+
+  MemData memData_{};
+  std::vector<CPUDataWithHistory> cpuData_;
+  std::string loadAverage_;
+  SampleHistory history_;  // frames played since the last seek
+  std::vector<LinuxParser::diskStatsData> diskData_;
+  DiskStats disks_;
+};
+
+// Record mode: samples `system` every interval and appends it to the file
+// given on the command line until interrupted or the iteration count is hit
+int RunRecorder(System& system, const CommandLine::Options& options);
+
+}  // namespace Recording
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef MONITOR_SAMPLE_SCHEDULER_H
+#define MONITOR_SAMPLE_SCHEDULER_H
+
+#include <cstdint>
+
+// /proc/<pid> files the sampler can read
+#define SAMPLE_SOURCE_STAT (1u << 0)
+#define SAMPLE_SOURCE_STATUS (1u << 1)
+#define SAMPLE_SOURCE_CMDLINE (1u << 2)
+#define SAMPLE_SOURCE_IO (1u << 3)
+#define SAMPLE_SOURCE_SMAPS (1u << 4)
+// /proc/<pid>/fd and the soft RLIMIT_NOFILE of /proc/<pid>/limits
+#define SAMPLE_SOURCE_FD (1u << 5)
+// The fd links, to tell sockets apart
+#define SAMPLE_SOURCE_SOCKETS (1u << 6)
+#define SAMPLE_SOURCE_SCHEDSTAT (1u << 7)
+// /proc/<pid>/task/*/schedstat of multi-threaded processes, summed
+#define SAMPLE_SOURCE_TASKS (1u << 8)
+
+// Read on every sampling tick, whether displayed or not
+#define SAMPLE_SOURCES_ALWAYS \
+  (SAMPLE_SOURCE_STAT | SAMPLE_SOURCE_STATUS | SAMPLE_SOURCE_CMDLINE)
+
+// Expensive sources, read in budgeted passes over all processes
+#define SAMPLE_SOURCES_PASS \
+  (SAMPLE_SOURCE_SMAPS | SAMPLE_SOURCE_FD | SAMPLE_SOURCE_SOCKETS | \
+   SAMPLE_SOURCE_TASKS)
+
+// Ticks between two reads of the sources on the slower tiers
+#define SAMPLE_MEDIUM_TIER_TICKS 2
+#define SAMPLE_SLOW_TIER_TICKS 5
+
+// Time a tick may spend on SAMPLE_SOURCES_PASS; a pass over all processes
+// that does not fit continues on the following ticks
+#define SAMPLE_PASS_BUDGET_US 3000
+
+// How often a source is read: every tick, or every SAMPLE_*_TIER_TICKS
+enum class SampleTier { FAST, MEDIUM, SLOW };
+
+/*
+Decides which optional per-process sources are read on a sampling tick.
+Every source has a fixed tier; a source on a slower tier is only read on the
+ticks of that tier, and only while somebody shows it.
+*/
+class SampleScheduler {
+ public:
+  static SampleTier TierOf(uint32_t source);
+
+  // Sources that are shown; the optional ones among them get read
+  void SetWanted(uint32_t sources) { wanted_ = sources | SAMPLE_SOURCES_ALWAYS; }
+  uint32_t Wanted() const { return wanted_; }
+
+  // Advances to the next tick and returns the sources due in it
+  uint32_t NextTick();
+
+ private:
+  uint32_t wanted_ = SAMPLE_SOURCES_ALWAYS;
+  uint64_t tick_ = 0;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef MONITOR_SELF_STATS_H
+#define MONITOR_SELF_STATS_H
+
+#include <chrono>
+
+#include "linux_parser.h"
+
+// The footprint of the monitor itself between its last two samples, so that
+// what it costs the machine it watches stays in sight
+class SelfStats {
+ public:
+  void Update(const LinuxParser::selfUsageData& usage,
+              std::chrono::steady_clock::time_point now);
+  const LinuxParser::selfUsageData& Usage() const { return usage_; }
+  // Percent of one CPU, and context switches per second; zero until two
+  // samples were taken
+  double CpuPercent() const { return cpuPercent_; }
+  double ContextSwitchRate() const { return ctxtRate_; }
+
+ private:
+  LinuxParser::selfUsageData usage_{};
+  double cpuPercent_ = 0;
+  double ctxtRate_ = 0;
+  std::chrono::steady_clock::time_point time_;
+};
+
+#endif
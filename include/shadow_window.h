@@ -0,0 +1,43 @@
+#ifndef MONITOR_SHADOW_WINDOW_H
+#define MONITOR_SHADOW_WINDOW_H
+
+#include <ncurses.h>
+
+#include <string_view>
+#include <vector>
+
+/*
+Off-screen copy of a curses window.
+
+A frame is composed into a back buffer of cells; Flush() compares every row
+with what was handed to curses for the previous frame and only writes the
+changed span of a changed row. Rows that did not change are not touched, so
+curses has nothing to compare or send for them.
+*/
+class ShadowWindow {
+ public:
+  // Adopts a new or resized window; the next Flush() repaints all of it
+  void Reset(WINDOW* window);
+  WINDOW* Window() const { return window_; }
+  int Width() const { return width_; }
+  int Height() const { return height_; }
+
+  // Starts a new frame with a blank back buffer
+  void Clear();
+  // Text is clipped at the right edge and ends at the first NUL
+  void Print(int y, int x, std::string_view text, attr_t attributes = A_NORMAL);
+  void Fill(int y, int x, int count, chtype cell);
+
+  // Writes the changed cells to the window and queues it for doupdate();
+  // returns the number of cells written
+  size_t Flush();
+
+ private:
+  WINDOW* window_ = nullptr;
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<chtype> back_;
+  std::vector<chtype> front_;
+};
+
+#endif
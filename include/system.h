@@ -1,27 +1,81 @@
 #ifndef SYSTEM_H
 #define SYSTEM_H
 
+#include <chrono>
+#include <functional>
 #include <string>
+#include <vector>
 
+#include "data_source.h"
+#include "disk_stats.h"
+#include "history.h"
+#include "interrupt_stats.h"
 #include "mem_data.h"
+#include "network_stats.h"
+#include "pressure_stats.h"
 #include "process_manager.h"
 
-class System {
+// Gap between the two samples of Prime(); long enough for CPU percentages
+// that mean something, short enough not to hold the first full frame up
+#define SYSTEM_PRIMING_MS 100
+
+// Live system, sampled from /proc
+class System : public DataSource {
  public:
-  static const struct MemData& MemoryUtilization();
-  static unsigned long long UpTime();
-  static std::string LoadAverage();
-  static const std::vector<struct CPUDataWithHistory>& totalCpuUtilization();
-  std::string Kernel();
-  std::string OperatingSystem();
+  void Update() override;
+  std::vector<std::shared_ptr<Process>> GetSortedProcesses() override;
+  unsigned int getNumOfTasks() override;
+  unsigned int getNumOfThreads() override;
+  unsigned int getNumOfRunningTasks() override;
+
+  const struct MemData& MemoryUtilization() override;
+  unsigned long long UpTime() override;
+  std::string LoadAverage() override;
+  const std::vector<struct CPUDataWithHistory>& totalCpuUtilization() override;
+  std::string Kernel() override;
+  std::string OperatingSystem() override;
+  std::vector<int> CpuNodes() override;
+  const std::vector<LinuxParser::numaNodeData>* NumaMemory() override;
+  bool ProcessNumaMemory(pid_t pid, std::vector<uint64_t>& nodeKb) override;
+
+  bool SetCgroupTracking(bool enabled) override;
+  std::vector<const CgroupStats*> GetSortedCgroups() override;
+  const SampleHistory* History() override { return &history_; }
+  const NetworkStats* Network() override { return &network_; }
+  const DiskStats* Disks() override { return &disks_; }
+  const PressureStats* Pressure() override { return &pressure_; }
+  bool SetInterruptTracking(bool enabled) override;
+  const InterruptStats* Interrupts() override { return &interrupts_; }
+  void SetWantedSources(uint32_t sources) override;
+  void SetVisiblePids(std::vector<pid_t> pids) override;
+  bool SetShowKernelThreads(bool show) override;
+  std::string ProcessCommandLine(pid_t pid) override;
+
+  void Prime() override;
+  void CancelPrime() override;
+  // Samples /proc unless the last sample is less than an interval old (or
+  // `force` is set) and notifies the observers after a new sample
+  void Sample(bool force);
+  void AddSampleObserver(std::function<void(System&)> observer);
+
   ProcessManager processManager;
 
   System();
 
  private:
+  void recordHistory();
+
+  std::vector<std::function<void(System&)>> observers_;
+  SampleHistory history_;
+  NetworkStats network_;
+  DiskStats disks_;
+  PressureStats pressure_;
+  InterruptStats interrupts_;
+  bool interruptTracking_ = false;
+  std::chrono::steady_clock::time_point devicesSampled_;
   std::string operating_system_;
   std::string kernel_;
   std::unique_ptr<MemData> memData_;
 };
 
-#endif
\ No newline at end of file
+#endif
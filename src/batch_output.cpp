@@ -0,0 +1,270 @@
+#include "batch_output.h"
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "columns.h"
+#include "disk_stats.h"
+#include "linux_parser.h"
+#include "mem_data.h"
+#include "output_buffer.h"
+#include "pressure_stats.h"
+#include "process.h"
+#include "processor.h"
+#include "system.h"
+
+namespace BatchOutput {
+
+static void AppendJsonString(OutputBuffer& out, std::string_view text) {
+  static const char kHex[] = "0123456789abcdef";
+  out.Append('"');
+  for (char c : text) {
+    unsigned char uc = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      out.Append('\\');
+      out.Append(c);
+    } else if (uc < 0x20) {
+      out.Append("\\u00");
+      out.Append(kHex[uc >> 4]);
+      out.Append(kHex[uc & 0xf]);
+    } else {
+      out.Append(c);
+    }
+  }
+  out.Append('"');
+}
+
+static void AppendCsvString(OutputBuffer& out, std::string_view text) {
+  if (text.find_first_of(",\"\n\r") == std::string_view::npos &&
+      text.find('\0') == std::string_view::npos) {
+    out.Append(text);
+    return;
+  }
+  out.Append('"');
+  for (char c : text) {
+    if (c == '"') out.Append('"');
+    out.Append(c == '\0' ? ' ' : c);
+  }
+  out.Append('"');
+}
+
+// Writes the value of column `field`: numbers as the raw sort key, text
+// through `appendString`, and `null` (JSON) or nothing (CSV) where the column
+// shows "-" because the value is not known yet
+template <typename AppendString>
+static void AppendField(OutputBuffer& out, int field, Process& process,
+                        const MemData& memData, AppendString&& appendString,
+                        std::string_view missing) {
+  const Columns::Column& column = Columns::kColumns[field];
+  char buffer[COLUMN_BUFFER_SIZE];
+  if (column.key == nullptr) {
+    appendString(out, column.format(process, memData, buffer));
+    return;
+  }
+  double value = column.key(process, memData);
+  // Unknown values sort last with a negative key
+  if (value < 0 && column.format(process, memData, buffer) == "-") {
+    out.Append(missing);
+  } else if (column.precision == 0) {
+    out.AppendInteger(std::llround(value));
+  } else {
+    out.AppendFixed(value, column.precision);
+  }
+}
+
+static void AppendJsonSnapshot(
+    OutputBuffer& out, System& system, long long timestampMs,
+    const std::vector<std::shared_ptr<Process>>& processes,
+    const std::vector<int>& fields) {
+  const MemData& memData = system.MemoryUtilization();
+  const auto& cpuData = system.totalCpuUtilization();
+  ProcessManager& manager = system.processManager;
+
+  out.Append("{\"ts\":");
+  out.AppendInteger(timestampMs);
+  out.Append(",\"uptime\":");
+  out.AppendInteger(system.UpTime());
+  // /proc/loadavg already holds decimal numbers
+  out.Append(",\"load\":[");
+  std::string loadAverage = system.LoadAverage();
+  for (char& c : loadAverage) {
+    if (c == ' ') c = ',';
+  }
+  out.Append(loadAverage);
+  out.Append("],\"tasks\":");
+  out.AppendInteger(manager.getNumOfTasks());
+  out.Append(",\"threads\":");
+  out.AppendInteger(manager.getNumOfThreads());
+  out.Append(",\"running\":");
+  out.AppendInteger(manager.getNumOfRunningTasks());
+
+  // Total first, then one entry per core
+  out.Append(",\"cpu\":[");
+  for (size_t i = 0; i < cpuData.size(); ++i) {
+    if (i > 0) out.Append(',');
+    out.AppendFixed(cpuData[i].Utilization() * 100.0, 1);
+  }
+
+  out.Append("],\"mem\":{\"total\":");
+  out.AppendInteger(memData.memTotal);
+  out.Append(",\"free\":");
+  out.AppendInteger(memData.memFree);
+  out.Append(",\"available\":");
+  out.AppendInteger(memData.memAvailable);
+  out.Append(",\"buffers\":");
+  out.AppendInteger(memData.buffers);
+  out.Append(",\"cached\":");
+  out.AppendInteger(memData.cached);
+  out.Append(",\"swap_total\":");
+  out.AppendInteger(memData.swapTotal);
+  out.Append(",\"swap_free\":");
+  out.AppendInteger(memData.swapFree);
+
+  // Rates since the previous snapshot; latencies in ms, util in percent
+  out.Append("},\"disks\":[");
+  const std::vector<Disk>& disks = system.Disks()->Disks();
+  for (size_t i = 0; i < disks.size(); ++i) {
+    const DiskRates& rates = disks[i].rates;
+    out.Append(i == 0 ? "{\"name\":" : ",{\"name\":");
+    AppendJsonString(out, disks[i].counters.name);
+    struct {
+      std::string_view name;
+      double value;
+      int precision;
+    } const values[] = {{"read_iops", rates.readIops, 1},
+                        {"write_iops", rates.writeIops, 1},
+                        {"read_bytes", rates.readBytes, 0},
+                        {"write_bytes", rates.writeBytes, 0},
+                        {"read_latency", rates.readLatencyMs, 2},
+                        {"write_latency", rates.writeLatencyMs, 2},
+                        {"queue", rates.queueDepth, 2},
+                        {"util", rates.utilization * 100.0, 1}};
+    for (const auto& entry : values) {
+      out.Append(",\"");
+      out.Append(entry.name);
+      out.Append("\":");
+      out.AppendFixed(entry.value, entry.precision);
+    }
+    out.Append('}');
+  }
+  out.Append(']');
+
+  // Percent of the interval tasks stalled, left out without PSI
+  const PressureStats* pressure = system.Pressure();
+  if (pressure != nullptr && pressure->Available()) {
+    const char* names[] = {"cpu", "memory", "io"};
+    out.Append(",\"pressure\":{");
+    for (int resource = 0; resource < LinuxParser::PSI_NUM_RESOURCES;
+         ++resource) {
+      const PsiStall& stall =
+          pressure->Stall((LinuxParser::PsiResource)resource);
+      if (resource > 0) out.Append(',');
+      out.Append('"');
+      out.Append(names[resource]);
+      out.Append("\":{\"some\":");
+      out.AppendFixed(stall.some, 2);
+      out.Append(",\"full\":");
+      out.AppendFixed(stall.full, 2);
+      out.Append('}');
+    }
+    out.Append('}');
+  }
+
+  out.Append(",\"processes\":[");
+  for (size_t i = 0; i < processes.size(); ++i) {
+    out.Append(i == 0 ? "{" : ",{");
+    for (size_t f = 0; f < fields.size(); ++f) {
+      if (f > 0) out.Append(',');
+      out.Append('"');
+      out.Append(Columns::kColumns[fields[f]].name);
+      out.Append("\":");
+      AppendField(out, fields[f], *processes[i], memData, AppendJsonString,
+                  "null");
+    }
+    out.Append('}');
+  }
+  out.Append("]}\n");
+}
+
+static void AppendCsvHeader(OutputBuffer& out,
+                            const std::vector<int>& fields) {
+  out.Append("ts");
+  for (int field : fields) {
+    out.Append(',');
+    out.Append(Columns::kColumns[field].name);
+  }
+  out.Append('\n');
+}
+
+static void AppendCsvSnapshot(
+    OutputBuffer& out, System& system, long long timestampMs,
+    const std::vector<std::shared_ptr<Process>>& processes,
+    const std::vector<int>& fields) {
+  const MemData& memData = system.MemoryUtilization();
+  for (const auto& process : processes) {
+    out.AppendInteger(timestampMs);
+    for (int field : fields) {
+      out.Append(',');
+      AppendField(out, field, *process, memData, AppendCsvString, "");
+    }
+    out.Append('\n');
+  }
+}
+
+int Run(System& system, const CommandLine::Options& options) {
+  std::vector<int> fields;
+  if (!Columns::Parse(options.fields, fields)) {
+    return 2;
+  }
+  system.SetWantedSources(Columns::Sources(fields));
+
+  OutputBuffer out;
+  if (options.format == CommandLine::OutputFormat::CSV) {
+    AppendCsvHeader(out, fields);
+  }
+
+  // The sample main() primed is the baseline; every snapshot is a full
+  // interval after the previous one so CPU% is meaningful from the start
+  const auto interval = std::chrono::milliseconds(options.intervalMs);
+  auto nextTick = std::chrono::steady_clock::now() + interval;
+
+  for (long iteration = 0;
+       options.iterations == 0 || iteration < options.iterations; ++iteration) {
+    std::this_thread::sleep_until(nextTick);
+
+    system.Sample(true);
+    std::vector<std::shared_ptr<Process>> processes =
+        system.processManager.GetSortedProcessesForDisplay(options.topN);
+    long long timestampMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+
+    if (options.format == CommandLine::OutputFormat::JSON) {
+      AppendJsonSnapshot(out, system, timestampMs, processes, fields);
+    } else {
+      AppendCsvSnapshot(out, system, timestampMs, processes, fields);
+    }
+    if (!out.WriteTo(STDOUT_FILENO)) {
+      perror("error while writing snapshot");
+      return 1;
+    }
+    out.Clear();
+
+    // Never try to catch up on missed ticks, just resume the cadence
+    nextTick += interval;
+    auto now = std::chrono::steady_clock::now();
+    if (nextTick < now) {
+      nextTick = now + interval;
+    }
+  }
+  return 0;
+}
+
+}  // namespace BatchOutput
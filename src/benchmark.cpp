@@ -0,0 +1,399 @@
+#include "benchmark.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "cpu_usage.h"
+#include "format.h"
+#include "mem_data.h"
+#include "process.h"
+#include "process_filter.h"
+#include "processor.h"
+#include "system.h"
+
+namespace Benchmark {
+
+// Rows formatted per measurement, spread over the live processes
+#define BENCHMARK_FORMAT_ROWS 200000
+// A wide terminal; longer rows are clipped like on screen
+#define BENCHMARK_LINE_WIDTH 256
+#define BENCHMARK_FILTER_ENTRIES 100000
+// A 256 thread machine, sampled this many times
+#define BENCHMARK_CPU_CORES 256
+#define BENCHMARK_CPU_SAMPLES 20000
+// Startups measured per scan mode; the fastest counts
+#define BENCHMARK_STARTUP_ROUNDS 3
+
+// The string based row formatting the process list used before the
+// allocation-free one; kept as the baseline and the reference output
+namespace Legacy {
+
+static float truncateTo1Decimal(float value) {
+  return std::round(value * 10) / 10.0f;
+}
+
+template <typename T>
+static std::string to_string_with_precision(const T a_value, const int n = 1) {
+  std::ostringstream out;
+  out.precision(n);
+  out << std::fixed << a_value;
+  return std::move(out).str();
+}
+
+static std::string convertMemoryToStr(uint64_t mem_value_in_kb,
+                                      int precision = 1) {
+  if (mem_value_in_kb < 1024 * 1024) {
+    if (mem_value_in_kb < 1024) {
+      return std::to_string(mem_value_in_kb) + "K";
+    }
+    return to_string_with_precision((float)mem_value_in_kb / 1024.0f,
+                                    precision) + "M";
+  }
+  return to_string_with_precision(
+             (float)mem_value_in_kb / (1024.0f * 1024.0f), precision) + "G";
+}
+
+static std::string ElapsedTime(double uptime) {
+  std::ostringstream oss;
+  if (uptime >= 3600) {
+    int hours = static_cast<int>(uptime) / 3600;
+    int minutes = (static_cast<int>(uptime) % 3600) / 60;
+    int seconds = static_cast<int>(uptime) % 60;
+    oss << std::setw(2) << std::setfill('0') << hours << "h" << ":"
+        << std::setw(2) << std::setfill('0') << minutes << ":"
+        << std::setw(2) << std::setfill('0') << seconds;
+  } else {
+    int minutes = static_cast<int>(uptime) / 60;
+    int seconds = static_cast<int>(uptime) % 60;
+    double fractionalSeconds = uptime - std::floor(uptime);
+    oss << std::setw(2) << std::setfill('0') << minutes << ":"
+        << std::setw(2) << std::setfill('0') << seconds << "."
+        << std::setw(2) << std::setfill('0')
+        << static_cast<int>(fractionalSeconds * 100);
+  }
+  return oss.str();
+}
+
+static std::string Row(Process& process, const MemData& memData) {
+  const ProcessMemUtilization& mem = process.MemUtilization();
+  return std::to_string(process.Pid()) + "|" + process.User().substr(0, 8) +
+         "|" + std::to_string(process.PriorityValue()) + "|" +
+         std::to_string(process.NiceValue()) + "|" +
+         convertMemoryToStr(mem.virtual_mem, 0) + "|" +
+         convertMemoryToStr(mem.resident_mem, 0) + "|" +
+         convertMemoryToStr(mem.shared_mem, 0) + "|" +
+         std::string(1, process.State()) + "|" +
+         to_string_with_precision<float>(
+             truncateTo1Decimal(process.CpuUtilization())) +
+         "|" +
+         to_string_with_precision<float>(truncateTo1Decimal(
+             ((double)mem.resident_mem / memData.memTotal) * 100.0f)) +
+         "|" + ElapsedTime(process.UpTime()) + "|" + process.Command();
+}
+
+}  // namespace Legacy
+
+// The same fields through the Format primitives the process list uses
+static std::string_view Row(Format::LineBuffer& line, Process& process,
+                            const MemData& memData) {
+  char field[32];
+  char* const fieldLast = field + sizeof(field);
+  int col = 0;
+  auto append = [&](const char* fieldEnd, bool separator = true) {
+    std::string_view text(field, fieldEnd - field);
+    line.Write(col, text);
+    col += text.size();
+    if (separator) line.Write(col++, "|");
+  };
+  auto appendText = [&](std::string_view text) {
+    line.Write(col, text);
+    col += text.size();
+    line.Write(col++, "|");
+  };
+
+  const ProcessMemUtilization& mem = process.MemUtilization();
+  line.Reset(BENCHMARK_LINE_WIDTH);
+  append(Format::Integer(field, fieldLast, process.Pid()));
+  appendText(std::string_view(process.User()).substr(0, 8));
+  append(Format::Integer(field, fieldLast, process.PriorityValue()));
+  append(Format::Integer(field, fieldLast, process.NiceValue()));
+  append(Format::Memory(field, fieldLast, mem.virtual_mem, 0));
+  append(Format::Memory(field, fieldLast, mem.resident_mem, 0));
+  append(Format::Memory(field, fieldLast, mem.shared_mem, 0));
+  field[0] = process.State();
+  append(field + 1);
+  append(Format::Tenths(field, fieldLast, process.CpuUtilization()));
+  append(Format::Tenths(
+      field, fieldLast, ((double)mem.resident_mem / memData.memTotal) * 100.0f));
+  append(Format::ElapsedTime(field, fieldLast, process.UpTime()));
+  line.Write(col, process.Command());
+  col += process.Command().size();
+  return line.View().substr(0, std::min(col, line.Width()));
+}
+
+// Compares the primitives with the legacy formatting over value ranges that
+// cover every unit, rounding tie and time layout
+static size_t SweepMismatches(size_t& checked) {
+  char buffer[64];
+  char* const last = buffer + sizeof(buffer);
+  size_t mismatches = 0;
+  auto compare = [&](const std::string& expected, const char* end) {
+    ++checked;
+    if (expected != std::string_view(buffer, end - buffer)) {
+      if (mismatches++ < 5) {
+        printf("  mismatch: \"%s\" vs \"%.*s\"\n", expected.c_str(),
+               (int)(end - buffer), buffer);
+      }
+    }
+  };
+
+  for (uint64_t kb = 0; kb < (16ull << 20); kb += (kb < 4096 ? 1 : 97)) {
+    compare(Legacy::convertMemoryToStr(kb, 0), Format::Memory(buffer, last, kb, 0));
+    compare(Legacy::convertMemoryToStr(kb, 1), Format::Memory(buffer, last, kb, 1));
+  }
+  for (int i = 0; i <= 100000; ++i) {
+    float value = i * 0.001f;
+    compare(Legacy::to_string_with_precision<float>(
+                Legacy::truncateTo1Decimal(value)),
+            Format::Tenths(buffer, last, value));
+  }
+  static const long clockTicks = sysconf(_SC_CLK_TCK);
+  for (long ticks = 0; ticks < 400000; ticks += (ticks < 360000 ? 1 : 1009)) {
+    double uptime = (double)ticks / clockTicks;
+    compare(Legacy::ElapsedTime(uptime),
+            Format::ElapsedTime(buffer, last, uptime));
+  }
+  return mismatches;
+}
+
+static int RunFormat(System& system) {
+  std::vector<std::shared_ptr<Process>> processes = system.GetSortedProcesses();
+  const MemData& memData = system.MemoryUtilization();
+  if (processes.empty()) {
+    fprintf(stderr, "no processes to format\n");
+    return 1;
+  }
+  size_t iterations = std::max<size_t>(1, BENCHMARK_FORMAT_ROWS / processes.size());
+  size_t rows = iterations * processes.size();
+
+  size_t rowMismatches = 0;
+  Format::LineBuffer line;
+  for (const auto& process : processes) {
+    std::string expected = Legacy::Row(*process, memData);
+    if (std::string_view(expected).substr(0, BENCHMARK_LINE_WIDTH) !=
+        Row(line, *process, memData)) {
+      ++rowMismatches;
+    }
+  }
+
+  // Accumulated so the formatting cannot be optimized away
+  size_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    for (const auto& process : processes) {
+      checksum += Legacy::Row(*process, memData).size();
+    }
+  }
+  auto middle = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    for (const auto& process : processes) {
+      checksum += Row(line, *process, memData).size();
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double legacyNs =
+      std::chrono::duration<double, std::nano>(middle - start).count() / rows;
+  double currentNs =
+      std::chrono::duration<double, std::nano>(end - middle).count() / rows;
+  size_t checked = 0;
+  size_t sweepMismatches = SweepMismatches(checked);
+
+  printf("format: %zu processes x %zu iterations (checksum %zu)\n",
+         processes.size(), iterations, checksum);
+  printf("  std::string and ostringstream: %8.1f ns/row\n", legacyNs);
+  printf("  to_chars into fixed buffers:   %8.1f ns/row (%.1fx)\n", currentNs,
+         legacyNs / currentNs);
+  printf("  mismatches: %zu of %zu rows, %zu of %zu sweep values\n",
+         rowMismatches, processes.size(), sweepMismatches, checked);
+  return (rowMismatches == 0 && sweepMismatches == 0) ? 0 : 1;
+}
+
+// Types queries into a filter over synthetic command lines, one keystroke
+// at a time like the '/' prompt does
+static int RunFilter() {
+  static const char* const users[] = {"root", "postgres", "www-data", "nobody",
+                                      "alice"};
+  static const char* const commands[] = {
+      "/usr/bin/python3 /opt/app/worker.py --queue=jobs-%d --concurrency 8",
+      "java -Xmx4g -Dservice.id=%d -jar /srv/payments/service.jar",
+      "nginx: worker process %d",
+      "/usr/lib/postgresql/15/bin/postgres -D /var/lib/pg/%d",
+      "/usr/sbin/sshd -D -o ListenAddress=10.0.%d.1",
+      "node /home/alice/projects/frontend/node_modules/.bin/vite --port %d"};
+  static const char* const queries[] = {"worker.py", "service.jar",
+                                        "ALICE", "jobs-4242"};
+
+  ProcessFilter filter;
+  char command[256];
+  for (int i = 0; i < BENCHMARK_FILTER_ENTRIES; ++i) {
+    snprintf(command, sizeof(command), commands[i % 6], i);
+    filter.Add(users[i % 5], command);
+  }
+
+  printf("filter: %d command lines\n", BENCHMARK_FILTER_ENTRIES);
+  double slowestMs = 0;
+  for (const char* query : queries) {
+    std::string_view full(query);
+    printf("  \"%s\":", query);
+    for (size_t length = 1; length <= full.size(); ++length) {
+      auto start = std::chrono::steady_clock::now();
+      size_t matches = filter.Apply(full.substr(0, length)).size();
+      double ms = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - start).count();
+      slowestMs = std::max(slowestMs, ms);
+      if (length == 1 || length == full.size()) {
+        printf(" %s %.2f ms (%zu)", length == 1 ? "first key" : "last key",
+               ms, matches);
+      }
+    }
+    printf("\n");
+    filter.Apply("");  // the next query starts from scratch
+  }
+  printf("  slowest keystroke: %.2f ms\n", slowestMs);
+  return 0;
+}
+
+// Per-core utilization of synthetic /proc/stat samples, one Utilization()
+// call per core against one CpuUsage pass
+static int RunCpu() {
+  std::vector<CPUDataWithHistory> cpus(BENCHMARK_CPU_CORES + 1);
+  uint64_t seed = 1;
+  auto next = [&seed](uint64_t range) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    return (seed >> 33) % range;
+  };
+  for (CPUDataWithHistory& cpu : cpus) {
+    CPUData previous{};
+    previous.idletime = next(1ull << 30);
+    previous.totaltime = previous.idletime + next(1ull << 30);
+    cpu.setPrevious(previous);
+    cpu.current = previous;
+    cpu.current.idletime += next(100);
+    cpu.current.totaltime += (cpu.current.idletime - previous.idletime) + next(100);
+  }
+  cpus[1].current.totaltime = cpus[1].previous->totaltime;  // no time passed
+  cpus[1].current.idletime = cpus[1].previous->idletime;
+  cpus[2].previous.reset();  // since boot
+
+  CpuUsage usage;
+  usage.Update(cpus);
+  size_t mismatches = 0;
+  for (size_t i = 0; i < cpus.size(); ++i) {
+    if (std::fabs(usage.Ratios()[i] - cpus[i].Utilization()) > 1e-6f) {
+      ++mismatches;
+    }
+  }
+
+  // Accumulated so the computation cannot be optimized away
+  double checksum = 0;
+  std::vector<float> ratios(cpus.size());
+  auto start = std::chrono::steady_clock::now();
+  for (int sample = 0; sample < BENCHMARK_CPU_SAMPLES; ++sample) {
+    for (size_t i = 0; i < cpus.size(); ++i) ratios[i] = cpus[i].Utilization();
+    checksum += ratios[sample % cpus.size()];
+  }
+  auto middle = std::chrono::steady_clock::now();
+  for (int sample = 0; sample < BENCHMARK_CPU_SAMPLES; ++sample) {
+    usage.Update(cpus);
+    checksum += usage.Ratios()[sample % cpus.size()];
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  double perCoreUs = std::chrono::duration<double, std::micro>(middle - start)
+                         .count() / BENCHMARK_CPU_SAMPLES;
+  double flatUs = std::chrono::duration<double, std::micro>(end - middle)
+                      .count() / BENCHMARK_CPU_SAMPLES;
+  printf("cpu: %d cores x %d samples (checksum %.1f)\n", BENCHMARK_CPU_CORES,
+         BENCHMARK_CPU_SAMPLES, checksum);
+  printf("  Utilization() per core:   %8.2f us/sample\n", perCoreUs);
+  printf("  CpuUsage over flat arrays: %7.2f us/sample (%.1fx)\n", flatUs,
+         perCoreUs / flatUs);
+  printf("  mismatches: %zu of %zu cores\n", mismatches, cpus.size());
+  return mismatches == 0 ? 0 : 1;
+}
+
+// Time to the first frame and to the first full sample of a fresh System,
+// with the initial process scan on one thread and on the worker threads
+static int RunStartup() {
+  using Clock = std::chrono::steady_clock;
+  auto ms = [](Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  };
+
+  // Fastest of the rounds, so both modes get a warm dentry cache
+  double frameMs[2] = {1e300, 1e300};
+  double scanMs[2] = {1e300, 1e300};
+  double primedMs[2] = {1e300, 1e300};
+  size_t processes = 0;
+  for (int round = 0; round < BENCHMARK_STARTUP_ROUNDS; ++round) {
+    for (int parallel = 0; parallel < 2; ++parallel) {
+      auto start = Clock::now();
+      System fresh;
+      auto frame = Clock::now();
+      if (!parallel) fresh.processManager.SetScanThreads(1);
+      fresh.processManager.UpdateProcesses(true);
+      auto scanned = Clock::now();
+      std::this_thread::sleep_for(std::chrono::milliseconds(SYSTEM_PRIMING_MS));
+      fresh.Sample(true);
+      auto primed = Clock::now();
+
+      frameMs[parallel] = std::min(frameMs[parallel], ms(frame - start));
+      scanMs[parallel] = std::min(scanMs[parallel], ms(scanned - frame));
+      primedMs[parallel] = std::min(primedMs[parallel], ms(primed - start));
+      processes = fresh.GetSortedProcesses().size();
+    }
+  }
+
+  printf("startup: %zu processes, %u hardware threads, best of %d\n",
+         processes, std::thread::hardware_concurrency(),
+         BENCHMARK_STARTUP_ROUNDS);
+  const char* const labels[] = {"serial scan:  ", "parallel scan:"};
+  for (int parallel = 0; parallel < 2; ++parallel) {
+    printf("  %s first frame %7.2f ms, scan %7.2f ms, primed %7.2f ms\n",
+           labels[parallel], frameMs[parallel], scanMs[parallel],
+           primedMs[parallel]);
+  }
+  printf("  priming sample after %d ms\n", SYSTEM_PRIMING_MS);
+  return processes > 0 ? 0 : 1;
+}
+
+int Run(System& system, const std::string& name) {
+  if (name == "format") {
+    return RunFormat(system);
+  }
+  if (name == "filter") {
+    return RunFilter();
+  }
+  if (name == "cpu") {
+    return RunCpu();
+  }
+  if (name == "startup") {
+    return RunStartup();
+  }
+  fprintf(stderr,
+          "unknown benchmark: %s (available: format, filter, cpu, startup)\n",
+          name.c_str());
+  return 2;
+}
+
+}  // namespace Benchmark
@@ -0,0 +1,68 @@
+#include "cgroup_manager.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "linux_parser.h"
+
+void CgroupManager::Update(
+    const std::unordered_map<std::string, unsigned int>& processCounts) {
+  auto now = std::chrono::steady_clock::now();
+
+  // Forget cgroups without any process left
+  for (auto it = cgroups_.begin(); it != cgroups_.end();) {
+    if (processCounts.find(it->first) == processCounts.end()) {
+      it = cgroups_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  for (const auto& [path, count] : processCounts) {
+    LinuxParser::cgroupFileData data = LinuxParser::parseCgroupFiles(path);
+    auto it = cgroups_.find(path);
+    bool isNew = (it == cgroups_.end());
+    if (isNew) {
+      it = cgroups_.emplace(path, CgroupStats{}).first;
+      it->second.path = path;
+    }
+    CgroupStats& stats = it->second;
+
+    stats.cpuUtilization = 0.0f;
+    if (!isNew && data.usageUsec >= stats.lastUsageUsec) {
+      auto elapsedUsec = std::chrono::duration_cast<std::chrono::microseconds>(
+                             now - stats.lastSample).count();
+      if (elapsedUsec > 0) {
+        stats.cpuUtilization =
+            static_cast<float>(data.usageUsec - stats.lastUsageUsec) /
+            elapsedUsec * 100.0f;
+      }
+    }
+    stats.lastUsageUsec = data.usageUsec;
+    stats.lastSample = now;
+
+    stats.memCurrent = data.memCurrent;
+    stats.memAnon = data.memAnon;
+    stats.memFile = data.memFile;
+    stats.cpuPressure = data.cpuPressure;
+    stats.memoryPressure = data.memoryPressure;
+    stats.ioPressure = data.ioPressure;
+    stats.numProcesses = count;
+  }
+}
+
+std::vector<const CgroupStats*> CgroupManager::GetSortedCgroups() const {
+  std::vector<const CgroupStats*> sortedCgroups;
+  sortedCgroups.reserve(cgroups_.size());
+  for (const auto& it : cgroups_) {
+    sortedCgroups.push_back(&it.second);
+  }
+
+  std::sort(sortedCgroups.begin(), sortedCgroups.end(),
+            [](const CgroupStats* l, const CgroupStats* r) {
+              if (std::abs(l->cpuUtilization - r->cpuUtilization) > 1e-3)
+                return l->cpuUtilization > r->cpuUtilization;
+              return l->path < r->path;
+            });
+  return sortedCgroups;
+}
@@ -0,0 +1,76 @@
+#include "columns.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace Columns {
+
+bool Parse(std::string_view list, std::vector<int>& columns) {
+  columns.clear();
+  if (list.empty()) {
+    for (int i = 0; i < kCount; ++i) {
+      if (!(kColumns[i].flags & COLUMN_HIDDEN)) columns.push_back(i);
+    }
+    return true;
+  }
+
+  while (!list.empty()) {
+    size_t comma = list.find(',');
+    std::string_view name = list.substr(0, comma);
+    list = (comma == std::string_view::npos) ? std::string_view()
+                                             : list.substr(comma + 1);
+    int index = Index(name);
+    if (index < 0) {
+      fprintf(stderr, "unknown field: %.*s\n", (int)name.size(), name.data());
+      return false;
+    }
+    columns.push_back(index);
+  }
+  return true;
+}
+
+uint32_t Sources(const std::vector<int>& columns) {
+  uint32_t sources = 0;
+  for (int column : columns) sources |= kColumns[column].sources;
+  return sources;
+}
+
+void Sort(std::vector<std::shared_ptr<Process>>& processes, int column,
+          const MemData& memData) {
+  const Column& entry = kColumns[column];
+  bool ascending = entry.flags & COLUMN_ASCENDING;
+
+  if (entry.key != nullptr) {
+    // Keys are taken once per process rather than once per comparison
+    std::vector<std::pair<double, size_t>> keys(processes.size());
+    for (size_t i = 0; i < processes.size(); ++i) {
+      keys[i] = {entry.key(*processes[i], memData), i};
+    }
+    std::sort(keys.begin(), keys.end(),
+              [&](const auto& l, const auto& r) {
+                if (l.first != r.first) {
+                  return ascending ? l.first < r.first : l.first > r.first;
+                }
+                return processes[l.second]->Pid() < processes[r.second]->Pid();
+              });
+    std::vector<std::shared_ptr<Process>> sorted(processes.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      sorted[i] = std::move(processes[keys[i].second]);
+    }
+    processes.swap(sorted);
+    return;
+  }
+
+  std::sort(processes.begin(), processes.end(),
+            [&](const std::shared_ptr<Process>& l,
+                const std::shared_ptr<Process>& r) {
+              char leftBuffer[COLUMN_BUFFER_SIZE];
+              char rightBuffer[COLUMN_BUFFER_SIZE];
+              int order = entry.format(*l, memData, leftBuffer)
+                              .compare(entry.format(*r, memData, rightBuffer));
+              if (order != 0) return ascending ? order < 0 : order > 0;
+              return l->Pid() < r->Pid();
+            });
+}
+
+}  // namespace Columns
@@ -0,0 +1,72 @@
+#include "cpu_usage.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "processor.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+void CpuUsage::Update(const std::vector<CPUDataWithHistory>& cpus) {
+  const size_t n = cpus.size();
+  total_.resize(n);
+  busy_.resize(n);
+  ratios_.resize(n);
+
+  // Without a previous sample the ratio is the one since boot. The deltas
+  // go through int64_t, whose conversion is a single instruction.
+  for (size_t i = 0; i < n; ++i) {
+    const CPUDataWithHistory& cpu = cpus[i];
+    uint64_t total = cpu.current.totaltime;
+    uint64_t idle = cpu.current.idletime;
+    if (cpu.previous) {
+      total -= cpu.previous->totaltime;
+      idle -= cpu.previous->idletime;
+    }
+    total_[i] = (double)(int64_t)total;
+    busy_[i] = (double)(int64_t)(total - idle);
+  }
+
+  // busy / total, and 0 when no time passed: max(total, 1) keeps the
+  // division defined because busy is 0 then
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128d one = _mm_set1_pd(1.0);
+  for (; i + 4 <= n; i += 4) {
+    __m128d low = _mm_div_pd(_mm_loadu_pd(&busy_[i]),
+                             _mm_max_pd(_mm_loadu_pd(&total_[i]), one));
+    __m128d high = _mm_div_pd(_mm_loadu_pd(&busy_[i + 2]),
+                              _mm_max_pd(_mm_loadu_pd(&total_[i + 2]), one));
+    _mm_storeu_ps(&ratios_[i],
+                  _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high)));
+  }
+#endif
+  for (; i < n; ++i) {
+    ratios_[i] = busy_[i] / std::max(total_[i], 1.0);
+  }
+}
+
+void CpuUsage::UpdateBreakdown(const std::vector<CPUDataWithHistory>& cpus) {
+  breakdown_.resize(cpus.size());
+  for (size_t i = 0; i < cpus.size(); ++i) {
+    const CPUData& current = cpus[i].current;
+    const CPUData previous = cpus[i].previous.value_or(CPUData{});
+    // Counters can step back when a CPU goes offline and comes back
+    auto delta = [](uint64_t now, uint64_t before) {
+      return now > before ? (double)(now - before) : 0.0;
+    };
+    double total = std::max(delta(current.totaltime, previous.totaltime), 1.0);
+    breakdown_[i] = {
+        (float)((delta(current.usertime, previous.usertime) +
+                 delta(current.guesttime, previous.guesttime)) / total),
+        (float)((delta(current.nicetime, previous.nicetime) +
+                 delta(current.guestnicetime, previous.guestnicetime)) / total),
+        (float)(delta(current.systemtime, previous.systemtime) / total),
+        (float)(delta(current.irqtime, previous.irqtime) / total),
+        (float)(delta(current.softirqtime, previous.softirqtime) / total),
+        (float)(delta(current.stealtime, previous.stealtime) / total),
+        (float)(delta(current.iowaittime, previous.iowaittime) / total)};
+  }
+}
@@ -0,0 +1,63 @@
+#include "disk_stats.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Counters that went backwards belong to a re-attached device
+static uint64_t Delta(uint64_t current, uint64_t previous) {
+  return current >= previous ? current - previous : 0;
+}
+
+void DiskStats::Update(const std::vector<LinuxParser::diskStatsData>& devices,
+                       std::chrono::steady_clock::time_point now) {
+  double seconds = std::chrono::duration<double>(now - time_).count();
+  time_ = now;
+
+  previous_.swap(disks_);
+  disks_.clear();
+  for (size_t i = 0; i < devices.size(); ++i) {
+    const LinuxParser::diskStatsData& counters = devices[i];
+    const Disk* before = nullptr;
+    if (i < previous_.size() &&
+        strcmp(previous_[i].counters.name, counters.name) == 0) {
+      before = &previous_[i];
+    } else {
+      for (const Disk& candidate : previous_) {
+        if (strcmp(candidate.counters.name, counters.name) == 0) {
+          before = &candidate;
+          break;
+        }
+      }
+    }
+
+    Disk& disk = disks_.emplace_back();
+    disk.counters = counters;
+    if (before == nullptr || seconds <= 0) continue;
+
+    const LinuxParser::diskStatsData& last = before->counters;
+    uint64_t reads = Delta(counters.reads, last.reads);
+    uint64_t writes = Delta(counters.writes, last.writes);
+    double elapsedMs = seconds * 1000;
+    DiskRates& rates = disk.rates;
+    rates.readIops = reads / seconds;
+    rates.writeIops = writes / seconds;
+    rates.readBytes = Delta(counters.readSectors, last.readSectors) * 512.0 /
+                      seconds;
+    rates.writeBytes =
+        Delta(counters.writeSectors, last.writeSectors) * 512.0 / seconds;
+    rates.readLatencyMs =
+        reads ? (double)Delta(counters.readMs, last.readMs) / reads : 0.0;
+    rates.writeLatencyMs =
+        writes ? (double)Delta(counters.writeMs, last.writeMs) / writes : 0.0;
+    rates.queueDepth = Delta(counters.weightedMs, last.weightedMs) / elapsedMs;
+    rates.utilization =
+        std::min(1.0, Delta(counters.ioMs, last.ioMs) / elapsedMs);
+    disk.hasRates = true;
+  }
+}
+
+void DiskStats::Clear() {
+  disks_.clear();
+  previous_.clear();
+  time_ = {};
+}
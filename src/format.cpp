@@ -1,5 +1,6 @@
 #include "format.h"
 
+#include <charconv>
 #include <cmath>
 #include <iomanip>
 #include <sstream>
@@ -8,33 +9,9 @@
 using std::string;
 
 std::string Format::ElapsedTime(double uptime) {
-  // Check if uptime is at least one hour
-  if (uptime >= 3600) {
-    // Format as "HHh:MM:SS" for hours
-    int hours = static_cast<int>(uptime) / 3600;
-    int minutes = (static_cast<int>(uptime) % 3600) / 60;
-    int seconds = static_cast<int>(uptime) % 60;
-
-    std::ostringstream oss;
-    oss << std::setw(2) << std::setfill('0') << hours << "h" << ":"
-        << std::setw(2) << std::setfill('0') << minutes << ":"
-        << std::setw(2) << std::setfill('0') << seconds;
-
-    return oss.str();
-
-  } else {
-    // Format as "MM:SS.xx" for minutes and seconds with fractional seconds
-    int minutes = static_cast<int>(uptime) / 60;
-    int seconds = static_cast<int>(uptime) % 60;
-    double fractionalSeconds = uptime - std::floor(uptime);
-
-    std::ostringstream oss;
-    oss << std::setw(2) << std::setfill('0') << minutes << ":"
-        << std::setw(2) << std::setfill('0') << seconds << "."
-        << std::setw(2) << std::setfill('0') << static_cast<int>(fractionalSeconds * 100);
-
-    return oss.str();
-  }
+  char buffer[32];
+  return std::string(buffer,
+                     ElapsedTime(buffer, buffer + sizeof(buffer), uptime));
 }
 
 std::string Format::FormatUptime(unsigned long long uptimeSeconds) {
@@ -57,3 +34,84 @@ std::string Format::FormatUptime(unsigned long long uptimeSeconds) {
 
   return formattedUptime.str();
 }
+
+static char* PutChar(char* first, char* last, char c) {
+  if (first == last) return first;
+  *first = c;
+  return first + 1;
+}
+
+// At least two digits, like std::setw(2) with std::setfill('0')
+static char* TwoDigits(char* first, char* last, int value) {
+  if (value >= 0 && value < 10) first = PutChar(first, last, '0');
+  return Format::Integer(first, last, value);
+}
+
+char* Format::Integer(char* first, char* last, long long value) {
+  std::to_chars_result result = std::to_chars(first, last, value);
+  return result.ec == std::errc() ? result.ptr : first;
+}
+
+char* Format::Tenths(char* first, char* last, float value) {
+  // Rounded in float like the displayed values always were
+  long long tenths = static_cast<long long>(std::round(value * 10));
+  if (tenths < 0) {
+    first = PutChar(first, last, '-');
+    tenths = -tenths;
+  }
+  first = Integer(first, last, tenths / 10);
+  first = PutChar(first, last, '.');
+  return PutChar(first, last, (char)('0' + tenths % 10));
+}
+
+char* Format::ElapsedTime(char* first, char* last, double uptime) {
+  int seconds = static_cast<int>(uptime) % 60;
+  if (uptime >= 3600) {
+    // Format as "HHh:MM:SS" for hours
+    int hours = static_cast<int>(uptime) / 3600;
+    int minutes = (static_cast<int>(uptime) % 3600) / 60;
+    first = TwoDigits(first, last, hours);
+    first = PutChar(first, last, 'h');
+    first = PutChar(first, last, ':');
+    first = TwoDigits(first, last, minutes);
+    first = PutChar(first, last, ':');
+    return TwoDigits(first, last, seconds);
+  }
+
+  // Format as "MM:SS.xx" for minutes and seconds with fractional seconds
+  int minutes = static_cast<int>(uptime) / 60;
+  double fractionalSeconds = uptime - std::floor(uptime);
+  first = TwoDigits(first, last, minutes);
+  first = PutChar(first, last, ':');
+  first = TwoDigits(first, last, seconds);
+  first = PutChar(first, last, '.');
+  return TwoDigits(first, last, static_cast<int>(fractionalSeconds * 100));
+}
+
+char* Format::Memory(char* first, char* last, uint64_t kb, int precision) {
+  if (kb < 1024) {
+    first = Integer(first, last, (long long)kb);
+    return PutChar(first, last, 'K');
+  }
+
+  // Fixed point with `precision` decimals, ties to even like printf
+  static const uint64_t powersOf10[] = {1, 10, 100, 1000};
+  precision = std::clamp(precision, 0, 3);
+  uint64_t scale = powersOf10[precision];
+  uint64_t unit = (kb < 1024 * 1024) ? 1024 : 1024 * 1024;
+  uint64_t scaled = kb * scale / unit;
+  uint64_t remainder = kb * scale % unit;
+  if (2 * remainder > unit || (2 * remainder == unit && scaled % 2 == 1)) {
+    ++scaled;
+  }
+
+  first = Integer(first, last, (long long)(scaled / scale));
+  if (precision > 0) {
+    first = PutChar(first, last, '.');
+    uint64_t fraction = scaled % scale;
+    for (uint64_t digit = scale / 10; digit > 0; digit /= 10) {
+      first = PutChar(first, last, (char)('0' + fraction / digit % 10));
+    }
+  }
+  return PutChar(first, last, unit == 1024 ? 'M' : 'G');
+}
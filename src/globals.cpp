@@ -0,0 +1,20 @@
+#include "globals.h"
+
+namespace Globals {
+
+static int refreshRate = GLOBAL_REFRESH_RATE;
+static size_t cmdlineMaxLength = GLOBAL_CMDLINE_MAX;
+
+int RefreshRate() { return refreshRate; }
+
+void SetRefreshRate(int milliseconds) { refreshRate = milliseconds; }
+
+size_t CmdlineMaxLength() { return cmdlineMaxLength; }
+
+void SetCmdlineMaxLength(size_t bytes) { cmdlineMaxLength = bytes; }
+
+std::chrono::milliseconds CacheDuration() {
+  return std::chrono::milliseconds(refreshRate * 9 / 10);
+}
+
+}  // namespace Globals
@@ -0,0 +1,63 @@
+#include "history.h"
+
+#include <cstdlib>
+
+#include "mem_data.h"
+#include "processor.h"
+
+void SampleHistory::Reset(size_t numCpus) {
+  cpus_.assign(numCpus, HistorySeries());
+  Clear();
+}
+
+void SampleHistory::Clear() {
+  for (HistorySeries& series : cpus_) series.Clear();
+  memUsed_.Clear();
+  memBuffers_.Clear();
+  memCached_.Clear();
+  swap_.Clear();
+  for (HistorySeries& series : load_) series.Clear();
+  netRx_.Clear();
+  netTx_.Clear();
+  for (HistorySeries& series : pressure_) series.Clear();
+}
+
+void SampleHistory::Record(const std::vector<CPUDataWithHistory>& cpus,
+                           const MemData& memData,
+                           const std::string& loadAverage) {
+  for (size_t i = 0; i < cpus_.size(); ++i) {
+    cpus_[i].Push(i < cpus.size() ? cpus[i].Utilization() : 0.0f);
+  }
+
+  // The same split as the Mem bar
+  double total = memData.memTotal ? (double)memData.memTotal : 1.0;
+  uint64_t used = memData.memTotal - memData.memFree;
+  memUsed_.Push((used - memData.buffers - memData.cached) / total);
+  memBuffers_.Push(memData.buffers / total);
+  memCached_.Push(
+      (memData.cached + memData.sReclaimable - memData.shmem) / total);
+  swap_.Push(memData.swapTotal
+                 ? (double)(memData.swapTotal - memData.swapFree) /
+                       memData.swapTotal
+                 : 0.0f);
+
+  // "0.52 0.58 0.59"
+  const char* position = loadAverage.c_str();
+  for (HistorySeries& series : load_) {
+    char* end;
+    float value = strtof(position, &end);
+    series.Push(end != position ? value : 0.0f);
+    position = end;
+  }
+}
+
+void SampleHistory::RecordNetwork(float rxBytes, float txBytes) {
+  netRx_.Push(rxBytes);
+  netTx_.Push(txBytes);
+}
+
+void SampleHistory::RecordPressure(float cpu, float memory, float io) {
+  pressure_[0].Push(cpu);
+  pressure_[1].Push(memory);
+  pressure_[2].Push(io);
+}
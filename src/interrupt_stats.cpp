@@ -0,0 +1,80 @@
+#include "interrupt_stats.h"
+
+#include <algorithm>
+#include <cstring>
+
+void InterruptStats::Clear() {
+  interrupts_.lines.clear();
+  interrupts_.counts.clear();
+  softirqs_.lines.clear();
+  softirqs_.counts.clear();
+  sources_.clear();
+  rates_.clear();
+  hasRates_ = false;
+}
+
+void InterruptStats::updateTable(const LinuxParser::irqTable& current,
+                                 const LinuxParser::irqTable& previous,
+                                 bool softirq, double seconds) {
+  bool comparable = previous.cpus == current.cpus && seconds > 0;
+  columns_.assign(cpus_.size(), -1);
+  for (size_t column = 0; column < cpus_.size(); ++column) {
+    auto found = std::find(current.cpus.begin(), current.cpus.end(),
+                           cpus_[column]);
+    if (found != current.cpus.end()) {
+      columns_[column] = found - current.cpus.begin();
+    }
+  }
+
+  for (size_t line = 0; line < current.lines.size(); ++line) {
+    InterruptSource& source = sources_.emplace_back();
+    source.line = current.lines[line];
+    source.softirq = softirq;
+    source.rate = 0;
+    source.topCpu = 0;
+    source.topShare = 0;
+
+    const uint64_t* counts = current.counts.data() + line * current.numCpus;
+    const uint64_t* before =
+        comparable && line < previous.lines.size() &&
+                strcmp(previous.lines[line].name, current.lines[line].name) == 0
+            ? previous.counts.data() + line * previous.numCpus
+            : nullptr;
+    double top = 0;
+    for (size_t column = 0; column < cpus_.size(); ++column) {
+      int cpu = columns_[column];
+      double rate = 0;
+      if (cpu >= 0 && before != nullptr && counts[cpu] >= before[cpu]) {
+        rate = (counts[cpu] - before[cpu]) / seconds;
+      }
+      rates_.push_back(rate);
+      source.rate += rate;
+      if (rate > top) {
+        top = rate;
+        source.topCpu = cpus_[column];
+      }
+    }
+    if (source.rate > 0 && !source.line.global) {
+      source.topShare = top / source.rate;
+    }
+  }
+}
+
+void InterruptStats::Update(const LinuxParser::irqTable& interrupts,
+                            const LinuxParser::irqTable& softirqs,
+                            std::chrono::steady_clock::time_point now) {
+  double seconds = std::chrono::duration<double>(now - time_).count();
+  hasRates_ = !interrupts_.lines.empty() || !softirqs_.lines.empty();
+
+  // The online CPUs; softirqs alone where /proc/interrupts is unreadable
+  cpus_ = interrupts.numCpus > 0 ? interrupts.cpus : softirqs.cpus;
+  sources_.clear();
+  rates_.clear();
+  updateTable(interrupts, interrupts_, false, seconds);
+  updateTable(softirqs, softirqs_, true, seconds);
+
+  // Copy-assignment keeps the capacity of the previous tables
+  interrupts_ = interrupts;
+  softirqs_ = softirqs;
+  time_ = now;
+}
@@ -1,6 +1,12 @@
 #include "linux_parser.h"
 
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <fstream>
 
 #include "cache.h"
@@ -30,9 +36,20 @@ const std::string kVersionFilename{"/version"};
 const std::string kOSPath{"/etc/os-release"};
 const std::string kPasswordPath{"/etc/passwd"};
 const std::string kLoadAvgPath("loadavg");
-
-static std::chrono::milliseconds cacheDuration =
-    std::chrono::milliseconds(GLOBAL_REFRESH_RATE);
+const std::string kCgroupFilename{"/cgroup"};
+const std::string kCgroupRoot{"/sys/fs/cgroup"};
+const std::string kCgroupHybridRoot{"/sys/fs/cgroup/unified"};
+const std::string kNodeDirectory{"/sys/devices/system/node"};
+const std::string kNumaMapsFilename{"/numa_maps"};
+const std::string kNetDevPath{"/proc/net/dev"};
+const std::string kNetClassDirectory{"/sys/class/net/"};
+const std::string kDiskStatsPath{"/proc/diskstats"};
+const std::string kBlockDirectory{"/sys/block/"};
+const std::string kInterruptsPath{"/proc/interrupts"};
+const std::string kSoftIrqsPath{"/proc/softirqs"};
+const std::string kPressureDirectory{"/proc/pressure"};
+const std::string kPressurePaths[PSI_NUM_RESOURCES] = {
+    "/proc/pressure/cpu", "/proc/pressure/memory", "/proc/pressure/io"};
 
 // Utility function to open a file and handle errors
 std::ifstream OpenFileStream(const std::string& filepath) {
@@ -139,7 +156,7 @@ std::vector<int> Pids() {
 }
 
 const struct MemData& MemoryUtilization() {
-  static Cache<struct MemData> memDataCache(cacheDuration);
+  static Cache<struct MemData> memDataCache(Globals::CacheDuration());
   if (memDataCache.IsCacheValid()) {
     return memDataCache.GetValue();
   }
@@ -187,50 +204,369 @@ const struct MemData& MemoryUtilization() {
   return memDataCache.GetValue();
 }
 
-struct procStatFileData parseProcStatFilePid(
-    pid_t pid) {
-  struct procStatFileData procStatFileData{};
-  std::ifstream filestream =
-      OpenFileStream(kProcDirectory + std::to_string(pid) + kStatFilename);
+// Reads a small procfs file into `buffer` with a single read() call
+static std::string_view ReadToBuffer(const std::string& filepath, char* buffer,
+                                     size_t size) {
+  int fd = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return {};
+  }
+  ssize_t len = read(fd, buffer, size - 1);
+  if (len < 0) {
+    perror(("error while reading file " + filepath).c_str());
+  }
+  close(fd);
+  return len > 0 ? std::string_view(buffer, len) : std::string_view();
+}
 
-  if (filestream.is_open()) {
-    std::string fileline;
-    if (std::getline(filestream, fileline)) {
-      std::istringstream linestream(fileline);
+// Reads a procfs file of any length into `buffer`, which grows to fit and
+// is meant to be kept between calls
+static std::string_view ReadAllToBuffer(const std::string& filepath,
+                                        std::vector<char>& buffer) {
+  int fd = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return {};
+  }
+  if (buffer.size() < 4096) buffer.resize(4096);
+  size_t len = 0;
+  while (true) {
+    if (len == buffer.size()) buffer.resize(buffer.size() * 2);
+    ssize_t count = read(fd, buffer.data() + len, buffer.size() - len);
+    if (count < 0) {
+      perror(("error while reading file " + filepath).c_str());
+      len = 0;
+      break;
+    }
+    if (count == 0) break;
+    len += count;
+  }
+  close(fd);
+  return std::string_view(buffer.data(), len);
+}
 
-      int fieldIndex = 0;
-      std::string field;
+// Skips blanks at `pos` and parses the integer that follows, advancing `pos`
+template <typename T>
+static T ParseNumber(std::string_view buffer, size_t& pos) {
+  while (pos < buffer.size() && (buffer[pos] == ' ' || buffer[pos] == '\t')) {
+    pos++;
+  }
+  T value{};
+  auto result =
+      std::from_chars(buffer.data() + pos, buffer.data() + buffer.size(), value);
+  pos = result.ptr - buffer.data();
+  return value;
+}
 
-      while (linestream >> field) {
-        fieldIndex++;
-        if (fieldIndex == 3) {
-          procStatFileData.state = field[0];
-        } else if (fieldIndex == 14) {
-          procStatFileData.utime = std::stoul(field);
-        } else if (fieldIndex == 15) {
-          procStatFileData.stime = std::stoul(field);
-        } else if (fieldIndex == 18) {
-          procStatFileData.priorityval = std::stol(field);
-        } else if (fieldIndex == 19) {
-          procStatFileData.niceval = std::stol(field);
-        } else if (fieldIndex == 22) {
-          procStatFileData.starttime = std::stoull(field);
-        }
-      }
-    }
+struct procStatFileData parseProcStatBuffer(std::string_view buffer) {
+  struct procStatFileData procStatFileData {};
 
-    if (filestream.bad()) {
-      perror(("error while reading file" + kProcDirectory +
-              std::to_string(pid) + kStatFilename)
-                 .c_str());
+  // The command name (field 2) may contain spaces and parentheses, so the
+  // remaining fields are located from the last closing parenthesis
+  size_t pos = buffer.rfind(')');
+  if (pos == std::string_view::npos || pos + 2 >= buffer.size()) {
+    return procStatFileData;
+  }
+  pos += 2;
+  procStatFileData.state = buffer[pos++];
+
+  for (int fieldIndex = 4; fieldIndex <= 22 && pos < buffer.size();
+       ++fieldIndex) {
+    if (fieldIndex == 9) {
+      procStatFileData.flags = ParseNumber<unsigned int>(buffer, pos);
+    } else if (fieldIndex == 14) {
+      procStatFileData.utime = ParseNumber<unsigned long>(buffer, pos);
+    } else if (fieldIndex == 15) {
+      procStatFileData.stime = ParseNumber<unsigned long>(buffer, pos);
+    } else if (fieldIndex == 18) {
+      procStatFileData.priorityval = ParseNumber<long>(buffer, pos);
+    } else if (fieldIndex == 19) {
+      procStatFileData.niceval = ParseNumber<long>(buffer, pos);
+    } else if (fieldIndex == 22) {
+      procStatFileData.starttime = ParseNumber<unsigned long long>(buffer, pos);
+    } else {
+      // Skip the field we are not interested in
+      pos++;
+      while (pos < buffer.size() && buffer[pos] != ' ') pos++;
     }
   }
 
   return procStatFileData;
 }
 
+std::string_view parseProcStatComm(std::string_view buffer) {
+  size_t open = buffer.find('(');
+  size_t close = buffer.rfind(')');
+  if (open == std::string_view::npos || close == std::string_view::npos ||
+      close < open) {
+    return {};
+  }
+  return buffer.substr(open + 1, close - open - 1);
+}
+
+procStatusFileData parseProcStatusBuffer(std::string_view buffer) {
+  struct procStatusFileData procStatusFileData {};
+  struct ProcessMemUtilization& memData = procStatusFileData.memData;
+
+  size_t lineStart = 0;
+  while (lineStart < buffer.size()) {
+    size_t lineEnd = buffer.find('\n', lineStart);
+    if (lineEnd == std::string_view::npos) lineEnd = buffer.size();
+    std::string_view line = buffer.substr(lineStart, lineEnd - lineStart);
+    lineStart = lineEnd + 1;
+
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos) continue;
+    std::string_view key = line.substr(0, colon);
+    size_t pos = colon + 1;
+
+    if (key == "VmSize") {
+      memData.virtual_mem = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "VmRSS") {
+      memData.resident_mem = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "RssShmem") {
+      memData.shared_mem = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "Threads") {
+      procStatusFileData.numThreads = ParseNumber<unsigned int>(line, pos);
+    } else if (key == "Uid") {
+      procStatusFileData.uid = ParseNumber<uid_t>(line, pos);
+    } else if (key == "voluntary_ctxt_switches") {
+      procStatusFileData.voluntaryCtxtSwitches =
+          ParseNumber<uint64_t>(line, pos);
+    } else if (key == "nonvoluntary_ctxt_switches") {
+      procStatusFileData.nonvoluntaryCtxtSwitches =
+          ParseNumber<uint64_t>(line, pos);
+    }
+  }
+
+  return procStatusFileData;
+}
+
+procIoFileData parseProcIoBuffer(std::string_view buffer) {
+  struct procIoFileData procIoFileData {};
+
+  size_t lineStart = 0;
+  while (lineStart < buffer.size()) {
+    size_t lineEnd = buffer.find('\n', lineStart);
+    if (lineEnd == std::string_view::npos) lineEnd = buffer.size();
+    std::string_view line = buffer.substr(lineStart, lineEnd - lineStart);
+    lineStart = lineEnd + 1;
+
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos) continue;
+    std::string_view key = line.substr(0, colon);
+    size_t pos = colon + 1;
+
+    if (key == "read_bytes") {
+      procIoFileData.readBytes = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "write_bytes") {
+      procIoFileData.writeBytes = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "cancelled_write_bytes") {
+      procIoFileData.cancelledWriteBytes = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "syscr") {
+      procIoFileData.syscr = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "syscw") {
+      procIoFileData.syscw = ParseNumber<uint64_t>(line, pos);
+    }
+  }
+
+  return procIoFileData;
+}
+
+procSchedstatData parseProcSchedstatBuffer(std::string_view buffer) {
+  struct procSchedstatData procSchedstatData {};
+  size_t pos = 0;
+  procSchedstatData.runNs = ParseNumber<uint64_t>(buffer, pos);
+  procSchedstatData.waitNs = ParseNumber<uint64_t>(buffer, pos);
+  procSchedstatData.timeslices = ParseNumber<uint64_t>(buffer, pos);
+  return procSchedstatData;
+}
+
+procSmapsRollupData parseProcSmapsRollupBuffer(std::string_view buffer) {
+  struct procSmapsRollupData procSmapsRollupData {};
+
+  // The first line is the address range of the "[rollup]" mapping
+  size_t lineStart = buffer.find('\n');
+  lineStart = (lineStart == std::string_view::npos) ? buffer.size()
+                                                    : lineStart + 1;
+  while (lineStart < buffer.size()) {
+    size_t lineEnd = buffer.find('\n', lineStart);
+    if (lineEnd == std::string_view::npos) lineEnd = buffer.size();
+    std::string_view line = buffer.substr(lineStart, lineEnd - lineStart);
+    lineStart = lineEnd + 1;
+
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos) continue;
+    std::string_view key = line.substr(0, colon);
+    size_t pos = colon + 1;
+
+    if (key == "Rss") {
+      procSmapsRollupData.rss = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "Pss") {
+      procSmapsRollupData.pss = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "Private_Clean") {
+      procSmapsRollupData.privateClean = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "Private_Dirty") {
+      procSmapsRollupData.privateDirty = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "Private_Hugetlb") {
+      procSmapsRollupData.privateHugetlb = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "Swap") {
+      procSmapsRollupData.swap = ParseNumber<uint64_t>(line, pos);
+    } else if (key == "SwapPss") {
+      procSmapsRollupData.swapPss = ParseNumber<uint64_t>(line, pos);
+    }
+  }
+
+  return procSmapsRollupData;
+}
+
+uint64_t parseProcLimitsNoFile(std::string_view buffer) {
+  static constexpr std::string_view kKey = "Max open files";
+  size_t start = buffer.find(kKey);
+  if (start == std::string_view::npos) return 0;
+  // "unlimited" parses as 0
+  size_t pos = start + kKey.size();
+  return ParseNumber<uint64_t>(buffer, pos);
+}
+
+void parseNetDevBuffer(std::string_view buffer,
+                       std::vector<netDevData>& devices) {
+  devices.clear();
+
+  // "  eth0: rxbytes packets errs drop fifo frame compressed multicast
+  //  txbytes packets errs drop fifo colls carrier compressed"; the two
+  // header lines have no colon
+  size_t lineStart = 0;
+  while (lineStart < buffer.size()) {
+    size_t lineEnd = buffer.find('\n', lineStart);
+    if (lineEnd == std::string_view::npos) lineEnd = buffer.size();
+    std::string_view line = buffer.substr(lineStart, lineEnd - lineStart);
+    lineStart = lineEnd + 1;
+
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos) continue;
+    size_t nameStart = line.find_first_not_of(' ');
+    std::string_view name = line.substr(nameStart, colon - nameStart);
+
+    netDevData& device = devices.emplace_back();
+    name.copy(device.name, std::min(name.size(), sizeof(device.name) - 1));
+    size_t pos = colon + 1;
+    device.rxBytes = ParseNumber<uint64_t>(line, pos);
+    device.rxPackets = ParseNumber<uint64_t>(line, pos);
+    device.rxErrors = ParseNumber<uint64_t>(line, pos);
+    device.rxDrops = ParseNumber<uint64_t>(line, pos);
+    for (int field = 0; field < 4; ++field) {
+      ParseNumber<uint64_t>(line, pos);  // fifo frame compressed multicast
+    }
+    device.txBytes = ParseNumber<uint64_t>(line, pos);
+    device.txPackets = ParseNumber<uint64_t>(line, pos);
+    device.txErrors = ParseNumber<uint64_t>(line, pos);
+    device.txDrops = ParseNumber<uint64_t>(line, pos);
+  }
+}
+
+void parseDiskStatsBuffer(std::string_view buffer,
+                          std::vector<diskStatsData>& devices) {
+  devices.clear();
+
+  // " 254  0 vda reads merged sectors ms writes merged sectors ms inflight
+  //  io_ms weighted_ms" and, on newer kernels, discard and flush fields
+  size_t lineStart = 0;
+  while (lineStart < buffer.size()) {
+    size_t lineEnd = buffer.find('\n', lineStart);
+    if (lineEnd == std::string_view::npos) lineEnd = buffer.size();
+    std::string_view line = buffer.substr(lineStart, lineEnd - lineStart);
+    lineStart = lineEnd + 1;
+
+    size_t pos = 0;
+    ParseNumber<unsigned int>(line, pos);  // major
+    ParseNumber<unsigned int>(line, pos);  // minor
+    size_t nameStart = line.find_first_not_of(' ', pos);
+    if (nameStart == std::string_view::npos) continue;
+    size_t nameEnd = std::min(line.find(' ', nameStart), line.size());
+    std::string_view name = line.substr(nameStart, nameEnd - nameStart);
+
+    diskStatsData& device = devices.emplace_back();
+    name.copy(device.name, std::min(name.size(), sizeof(device.name) - 1));
+    pos = nameEnd;
+    device.reads = ParseNumber<uint64_t>(line, pos);
+    ParseNumber<uint64_t>(line, pos);  // merged
+    device.readSectors = ParseNumber<uint64_t>(line, pos);
+    device.readMs = ParseNumber<uint64_t>(line, pos);
+    device.writes = ParseNumber<uint64_t>(line, pos);
+    ParseNumber<uint64_t>(line, pos);  // merged
+    device.writeSectors = ParseNumber<uint64_t>(line, pos);
+    device.writeMs = ParseNumber<uint64_t>(line, pos);
+    device.inFlight = ParseNumber<uint64_t>(line, pos);
+    device.ioMs = ParseNumber<uint64_t>(line, pos);
+    device.weightedMs = ParseNumber<uint64_t>(line, pos);
+  }
+}
+
+void parseIrqBuffer(std::string_view buffer, irqTable& table) {
+  table.numCpus = 0;
+  table.cpus.clear();
+  table.lines.clear();
+  table.counts.clear();
+
+  // "           CPU0       CPU1" then "  36:  182200  0  PCI-MSIX-0000:00:02.0
+  // 1-edge      virtio1-req.0" or " NMI:  0  0  Non-maskable interrupts";
+  // ERR and MIS have a single count
+  size_t lineEnd = buffer.find('\n');
+  if (lineEnd == std::string_view::npos) return;
+  std::string_view header = buffer.substr(0, lineEnd);
+  for (size_t pos = header.find("CPU"); pos != std::string_view::npos;
+       pos = header.find("CPU", pos)) {
+    pos += 3;
+    table.cpus.push_back(ParseNumber<int>(header, pos));
+  }
+  table.numCpus = table.cpus.size();
+
+  size_t lineStart = lineEnd + 1;
+  while (lineStart < buffer.size()) {
+    lineEnd = buffer.find('\n', lineStart);
+    if (lineEnd == std::string_view::npos) lineEnd = buffer.size();
+    std::string_view line = buffer.substr(lineStart, lineEnd - lineStart);
+    lineStart = lineEnd + 1;
+
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos) continue;
+    size_t nameStart = line.find_first_not_of(' ');
+    std::string_view name = line.substr(nameStart, colon - nameStart);
+
+    irqLine& entry = table.lines.emplace_back();
+    memset(&entry, 0, sizeof(entry));
+    name.copy(entry.name, std::min(name.size(), sizeof(entry.name) - 1));
+    size_t pos = colon + 1;
+    for (int cpu = 0; cpu < table.numCpus; ++cpu) {
+      size_t before = pos;
+      table.counts.push_back(ParseNumber<uint64_t>(line, pos));
+      if (cpu == 1 && pos == before) entry.global = true;
+    }
+
+    std::string_view rest = line.substr(std::min(pos, line.size()));
+    size_t first = rest.find_first_not_of(' ');
+    if (first == std::string_view::npos) continue;
+    rest = rest.substr(first);
+    // Numbered IRQs list chip, hwirq and trigger before the devices
+    bool numbered = name.find_first_not_of("0123456789") == std::string_view::npos;
+    size_t gap = rest.rfind("  ");
+    if (numbered && gap != std::string_view::npos) {
+      rest = rest.substr(rest.find_first_not_of(' ', gap));
+    }
+    rest.copy(entry.description,
+              std::min(rest.size(), sizeof(entry.description) - 1));
+  }
+}
+
+struct procStatFileData parseProcStatFilePid(pid_t pid) {
+  char buffer[1024];
+  return parseProcStatBuffer(ReadToBuffer(
+      kProcDirectory + std::to_string(pid) + kStatFilename, buffer,
+      sizeof(buffer)));
+}
+
 unsigned long long UpTime() {
-  static Cache<unsigned long long> uptimeCache(cacheDuration);
+  static Cache<unsigned long long> uptimeCache(Globals::CacheDuration());
 
   if (uptimeCache.IsCacheValid()) {
     return uptimeCache.GetValue();
@@ -256,7 +592,7 @@ unsigned long long UpTime() {
 }
 
 unsigned int numProcessesRunning() {
-  static Cache<unsigned int> numProcessesRunningCache(cacheDuration);
+  static Cache<unsigned int> numProcessesRunningCache(Globals::CacheDuration());
 
   if (numProcessesRunningCache.IsCacheValid()) {
     return numProcessesRunningCache.GetValue();
@@ -289,11 +625,111 @@ unsigned int numProcessesRunning() {
   return numProcessesRunningCache.GetValue();
 }
 
-const std::vector<struct CPUDataWithHistory>& totalCpuUtilization() {
-  static Cache<std::vector<struct CPUDataWithHistory>> cpuCache(cacheDuration);
+std::vector<int> CpuNodes() {
+  std::vector<int> nodes;
+  std::error_code error;
+  for (const auto& entry : fs::directory_iterator(kNodeDirectory, error)) {
+    std::string name = entry.path().filename().string();
+    if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+        !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+      continue;
+    }
+    int node = std::stoi(name.substr(4));
+
+    // "0-3,8-11"
+    char buffer[4096];
+    std::string_view cpulist =
+        ReadToBuffer(entry.path().string() + "/cpulist", buffer, sizeof(buffer));
+    size_t pos = 0;
+    while (pos < cpulist.size() && isdigit(cpulist[pos])) {
+      size_t first = ParseNumber<size_t>(cpulist, pos);
+      size_t last = first;
+      if (pos < cpulist.size() && cpulist[pos] == '-') {
+        last = std::max(first, ParseNumber<size_t>(cpulist, ++pos));
+      }
+      if (last >= nodes.size()) nodes.resize(last + 1, -1);
+      std::fill(nodes.begin() + first, nodes.begin() + last + 1, node);
+      if (pos < cpulist.size() && cpulist[pos] == ',') pos++;
+    }
+  }
+  return nodes;
+}
+
+const std::vector<netDevData>& NetworkDevices() {
+  static Cache<std::vector<netDevData>> netDevCache(Globals::CacheDuration());
+
+  if (netDevCache.IsCacheValid()) {
+    return netDevCache.GetValue();
+  }
+
+  // Both keep their capacity, so a steady set of interfaces costs no
+  // allocation however many veth pairs there are
+  static std::vector<char> buffer;
+  static std::vector<netDevData> devices;
+  parseNetDevBuffer(ReadAllToBuffer(kNetDevPath, buffer), devices);
+
+  netDevCache.UpdateCache(devices);
+  return netDevCache.GetValue();
+}
+
+// A whole disk (partitions only appear under their disk in /sys/block)
+// without slaves, which device-mapper and md devices have
+static bool IsPhysicalDisk(const char* name) {
+  std::string path = kBlockDirectory + name;
+  // "cciss/c0d0" is "cciss!c0d0" in sysfs
+  std::replace(path.begin() + kBlockDirectory.size(), path.end(), '/', '!');
+  if (access(path.c_str(), F_OK) != 0) return false;
+  std::error_code error;
+  bool noSlaves = fs::is_empty(path + "/slaves", error);
+  return noSlaves || error;
+}
+
+const std::vector<diskStatsData>& DiskStatistics() {
+  static Cache<std::vector<diskStatsData>> diskCache(Globals::CacheDuration());
+
+  if (diskCache.IsCacheValid()) {
+    return diskCache.GetValue();
+  }
+
+  static std::vector<char> buffer;
+  static std::vector<diskStatsData> devices;
+  static std::vector<diskStatsData> disks;
+  // IsPhysicalDisk() of the device on every line; the order of the file is
+  // stable, so sysfs is only asked about devices that are new at a line
+  struct Verdict {
+    char name[sizeof(diskStatsData::name)];
+    bool physical;
+  };
+  static std::vector<Verdict> verdicts;
+
+  parseDiskStatsBuffer(ReadAllToBuffer(kDiskStatsPath, buffer), devices);
+  verdicts.resize(devices.size());
+  disks.clear();
+  for (size_t i = 0; i < devices.size(); ++i) {
+    const diskStatsData& device = devices[i];
+    Verdict& verdict = verdicts[i];
+    if (strcmp(verdict.name, device.name) != 0) {
+      memcpy(verdict.name, device.name, sizeof(verdict.name));
+      verdict.physical = IsPhysicalDisk(device.name);
+    }
+    if (verdict.physical && device.reads + device.writes > 0) {
+      disks.push_back(device);
+    }
+  }
+
+  diskCache.UpdateCache(disks);
+  return diskCache.GetValue();
+}
+
+bool IsPhysicalInterface(const char* name) {
+  return access((kNetClassDirectory + name + "/device").c_str(), F_OK) == 0;
+}
+
+const std::vector<struct CPUDataWithHistory>& totalCpuUtilization(bool fresh) {
+  static Cache<std::vector<struct CPUDataWithHistory>> cpuCache(Globals::CacheDuration());
 
   // Check if cache is valid
-  if (cpuCache.IsCacheValid()) {
+  if (!fresh && cpuCache.IsCacheValid()) {
     return cpuCache.GetValue();  // Return cached data if valid
   }
 
@@ -359,105 +795,402 @@ const std::vector<struct CPUDataWithHistory>& totalCpuUtilization() {
   return cpuCache.GetValue();
 }
 
-std::string Command(pid_t pid) {
-  std::string filepath =
-      kProcDirectory + std::to_string(pid) + kCmdlineFilename;
-  std::ifstream filestream = OpenFileStream(filepath);
-  std::string cmd;
-
-  std::getline(filestream, cmd);
+// The arguments of cmdline are NUL terminated; they are joined with spaces
+// and the trailing separators dropped
+static void JoinArguments(std::string& command) {
+  std::replace(command.begin(), command.end(), '\0', ' ');
+  size_t end = command.find_last_not_of(' ');
+  command.resize(end == std::string::npos ? 0 : end + 1);
+}
 
-  if (filestream.bad()) {
-    perror(("error while reading file" + filepath).c_str());
+std::string Command(pid_t pid, size_t maxLength) {
+  std::string command;
+  // Gone or unreadable processes are common and not worth a message
+  int fd = open((kProcDirectory + std::to_string(pid) + kCmdlineFilename)
+                    .c_str(),
+                O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return command;
+  // Read into a reused buffer, so that the string only takes the bytes of
+  // this command line, not the whole cap
+  thread_local std::vector<char> buffer;
+  buffer.resize(maxLength);
+  size_t len = 0;
+  while (len < maxLength) {
+    ssize_t count = read(fd, buffer.data() + len, maxLength - len);
+    if (count <= 0) break;
+    len += count;
   }
+  close(fd);
+  command.assign(buffer.data(), len);
+  JoinArguments(command);
+  return command;
+}
 
-  filestream.close();
-  return cmd;
+std::string FullCommand(pid_t pid) {
+  std::vector<char> buffer;
+  std::string_view contents = ReadAllToBuffer(
+      kProcDirectory + std::to_string(pid) + kCmdlineFilename, buffer);
+  std::string command(contents);
+  JoinArguments(command);
+  return command;
 }
 
-procStatusFileData parseProcStatusFilePid(int pid) {
-  struct ProcessMemUtilization processMemUtilization {};
-  struct procStatusFileData procStatusFileData {};
-  std::string filepath = kProcDirectory + std::to_string(pid) + kStatusFilename;
-  auto filestream = OpenFileStream(filepath);
+std::string Cgroup(pid_t pid) {
+  char buffer[1024];
+  std::string_view contents = ReadToBuffer(
+      kProcDirectory + std::to_string(pid) + kCgroupFilename, buffer,
+      sizeof(buffer));
+
+  // The unified hierarchy is the "0::<path>" line
+  size_t lineStart = 0;
+  while (lineStart < contents.size()) {
+    size_t lineEnd = contents.find('\n', lineStart);
+    if (lineEnd == std::string_view::npos) lineEnd = contents.size();
+    std::string_view line = contents.substr(lineStart, lineEnd - lineStart);
+    if (line.substr(0, 3) == "0::") {
+      return std::string(line.substr(3));
+    }
+    lineStart = lineEnd + 1;
+  }
+  return {};
+}
 
-  if (filestream.is_open()) {
-    std::string line, key;
-    uint64_t value;
+psiFileData parsePsiBuffer(std::string_view buffer) {
+  struct psiFileData data {};
+
+  // "some avg10=3.07 avg60=2.89 avg300=3.79 total=186481539"
+  size_t lineStart = 0;
+  while (lineStart < buffer.size()) {
+    size_t lineEnd = buffer.find('\n', lineStart);
+    if (lineEnd == std::string_view::npos) lineEnd = buffer.size();
+    std::string_view line = buffer.substr(lineStart, lineEnd - lineStart);
+    lineStart = lineEnd + 1;
+
+    std::string_view kind = line.substr(0, 5);
+    psiLine* target =
+        kind == "some " ? &data.some : kind == "full " ? &data.full : nullptr;
+    if (target == nullptr) continue;
+    data.valid = true;
+
+    size_t pos = kind.size();
+    while (pos < line.size()) {
+      size_t equals = line.find('=', pos);
+      if (equals == std::string_view::npos) break;
+      std::string_view key = line.substr(pos, equals - pos);
+      pos = equals + 1;
+      if (key == "total") {
+        target->total = ParseNumber<uint64_t>(line, pos);
+      } else {
+        float value = 0.0f;
+        auto result = std::from_chars(line.data() + pos,
+                                      line.data() + line.size(), value);
+        pos = result.ptr - line.data();
+        if (key == "avg10") {
+          target->avg10 = value;
+        } else if (key == "avg60") {
+          target->avg60 = value;
+        } else if (key == "avg300") {
+          target->avg300 = value;
+        }
+      }
+      while (pos < line.size() && line[pos] == ' ') pos++;
+    }
+  }
 
-    while (std::getline(filestream, line)) {
-      std::istringstream linestream(line);
-      linestream >> key >> value;
+  return data;
+}
 
-      // Remove the trailing ':' from key
-      key = key.substr(0, key.size() - 1);
+numaNodeData parseNodeMeminfoBuffer(std::string_view buffer) {
+  numaNodeData data{};
+  size_t pos = buffer.find("Node ");
+  if (pos == std::string_view::npos) return data;
+  pos += 5;
+  data.node = ParseNumber<int>(buffer, pos);
+
+  auto value = [&](std::string_view key) -> uint64_t {
+    size_t at = buffer.find(key);
+    if (at == std::string_view::npos) return 0;
+    at += key.size();
+    return ParseNumber<uint64_t>(buffer, at);
+  };
+  data.memTotal = value(" MemTotal:");
+  data.memFree = value(" MemFree:");
+  data.memUsed = value(" MemUsed:");
+  return data;
+}
 
-      if (key == "VmSize") {
-        processMemUtilization.virtual_mem = value;
-      } else if (key == "VmRSS") {
-        processMemUtilization.resident_mem = value;
-      } else if (key == "RssShmem") {
-        processMemUtilization.shared_mem = value;
-      } else if (key == "Threads") {
-        procStatusFileData.numThreads = value;
+selfUsageData SelfUsage() {
+  selfUsageData data{};
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    data.cpuUs = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ull +
+                 usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    data.voluntaryCtxtSwitches = usage.ru_nvcsw;
+    data.nonvoluntaryCtxtSwitches = usage.ru_nivcsw;
+  }
+  // The context switches in status are those of the main thread only
+  char buffer[4096];
+  procStatusFileData status = parseProcStatusBuffer(
+      ReadToBuffer(kProcDirectory + "self" + kStatusFilename, buffer,
+                   sizeof(buffer)));
+  data.residentKb = status.memData.resident_mem;
+  data.numThreads = status.numThreads;
+  return data;
+}
+
+const std::vector<numaNodeData>& NumaNodes() {
+  static Cache<std::vector<numaNodeData>> nodesCache(Globals::CacheDuration());
+  // Nodes do not come and go while we run
+  static const std::vector<std::string> paths = [] {
+    std::vector<int> nodes;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(kNodeDirectory, error)) {
+      std::string name = entry.path().filename().string();
+      if (name.compare(0, 4, "node") == 0 && name.size() > 4 &&
+          std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+        nodes.push_back(std::stoi(name.substr(4)));
       }
     }
-    if (filestream.bad()) {
-      perror(("error while reading file" + filepath).c_str());
+    std::sort(nodes.begin(), nodes.end());
+    std::vector<std::string> paths;
+    if (nodes.size() < 2) return paths;
+    for (int node : nodes) {
+      paths.push_back(kNodeDirectory + "/node" + std::to_string(node) +
+                      kMeminfoFilename);
     }
+    return paths;
+  }();
+
+  if (paths.empty() || nodesCache.IsCacheValid()) {
+    return nodesCache.GetValue();
   }
-  procStatusFileData.memData = processMemUtilization;
 
-  return procStatusFileData;
+  static std::vector<numaNodeData> nodes;
+  // A node's meminfo has some 30 lines
+  char buffer[4096];
+  nodes.clear();
+  for (const std::string& path : paths) {
+    nodes.push_back(parseNodeMeminfoBuffer(
+        ReadToBuffer(path, buffer, sizeof(buffer))));
+  }
+
+  nodesCache.UpdateCache(nodes);
+  return nodesCache.GetValue();
 }
 
-std::string Uid(pid_t pid) {
-  std::string filepath = kProcDirectory + std::to_string(pid) + kStatusFilename;
-  std::ifstream filestream = OpenFileStream(filepath);
+void parseNumaMapsLine(std::string_view line, std::vector<uint64_t>& nodeKb) {
+  // The page size follows the node counts, and is 4 kB unless the mapping
+  // is backed by huge pages
+  uint64_t pageKb = 4;
+  size_t at = line.find("kernelpagesize_kB=");
+  if (at != std::string_view::npos) {
+    at += 18;
+    pageKb = ParseNumber<uint64_t>(line, at);
+  }
 
-  // lambda to process each line and extract UID
-  uid_t user_uid;
-  ProcessFileLines(filestream, filepath,
-                   [&](std::istringstream& curr_line) -> bool {
-                     std::string key, value;
-                     curr_line >> key;
-                     if (key == "Uid:") {
-                       curr_line >> value;
-                       user_uid = stoi(value);
-                       return true;
-                     }
-                     return false;
-                   });
+  for (size_t pos = line.find(" N"); pos != std::string_view::npos;
+       pos = line.find(" N", pos + 2)) {
+    size_t cursor = pos + 2;
+    if (cursor >= line.size() || !isdigit(line[cursor])) continue;
+    size_t node = ParseNumber<size_t>(line, cursor);
+    if (cursor >= line.size() || line[cursor] != '=') continue;
+    cursor++;
+    uint64_t pages = ParseNumber<uint64_t>(line, cursor);
+    if (node >= nodeKb.size()) nodeKb.resize(node + 1, 0);
+    nodeKb[node] += pages * pageKb;
+  }
+}
 
-  filestream.close();
-  filestream = OpenFileStream(kPasswordPath);
+bool NumaMaps(pid_t pid, std::vector<uint64_t>& nodeKb) {
+  nodeKb.clear();
+  int fd = open((kProcDirectory + std::to_string(pid) + kNumaMapsFilename)
+                    .c_str(),
+                O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+
+  // Large processes have tens of thousands of mappings, so the file is
+  // parsed a chunk at a time rather than read whole; a line cut at the end
+  // of a chunk moves to the front for the next read
+  char buffer[16384];
+  size_t kept = 0;
+  bool ok = true;
+  while (true) {
+    ssize_t count = read(fd, buffer + kept, sizeof(buffer) - kept);
+    if (count < 0) {
+      ok = false;
+      break;
+    }
+    size_t len = kept + count;
+    std::string_view chunk(buffer, len);
+    size_t lineStart = 0;
+    size_t lineEnd;
+    while ((lineEnd = chunk.find('\n', lineStart)) != std::string_view::npos) {
+      parseNumaMapsLine(chunk.substr(lineStart, lineEnd - lineStart), nodeKb);
+      lineStart = lineEnd + 1;
+    }
+    if (count == 0) {
+      if (lineStart < len) parseNumaMapsLine(chunk.substr(lineStart), nodeKb);
+      break;
+    }
+    kept = len - lineStart;
+    // A line longer than the buffer (a very long file path) is skipped
+    if (kept == sizeof(buffer)) kept = 0;
+    memmove(buffer, buffer + lineStart, kept);
+  }
+  close(fd);
+  return ok;
+}
+
+// Tables are kept in place rather than copied into a Cache, as they are
+// re-read at every sample the interrupt view takes
+static const irqTable& ReadIrqTable(const std::string& path, irqTable& table,
+                                    std::vector<char>& buffer,
+                                    std::chrono::steady_clock::time_point& read) {
+  auto now = std::chrono::steady_clock::now();
+  if (read.time_since_epoch().count() != 0 &&
+      now - read < Globals::CacheDuration()) {
+    return table;
+  }
+  parseIrqBuffer(ReadAllToBuffer(path, buffer), table);
+  read = now;
+  return table;
+}
+
+const irqTable& Interrupts() {
+  static irqTable table{};
+  static std::vector<char> buffer;
+  static std::chrono::steady_clock::time_point read;
+  return ReadIrqTable(kInterruptsPath, table, buffer, read);
+}
+
+const irqTable& SoftIrqs() {
+  static irqTable table{};
+  static std::vector<char> buffer;
+  static std::chrono::steady_clock::time_point read;
+  return ReadIrqTable(kSoftIrqsPath, table, buffer, read);
+}
+
+const std::array<psiFileData, PSI_NUM_RESOURCES>& Pressure() {
+  static Cache<std::array<psiFileData, PSI_NUM_RESOURCES>> pressureCache(
+      Globals::CacheDuration());
+  static const bool available = access(kPressureDirectory.c_str(), F_OK) == 0;
+
+  if (!available || pressureCache.IsCacheValid()) {
+    return pressureCache.GetValue();
+  }
 
+  std::array<psiFileData, PSI_NUM_RESOURCES> pressure;
+  char buffer[256];
+  for (int resource = 0; resource < PSI_NUM_RESOURCES; ++resource) {
+    pressure[resource] = parsePsiBuffer(
+        ReadToBuffer(kPressurePaths[resource], buffer, sizeof(buffer)));
+  }
+
+  pressureCache.UpdateCache(pressure);
+  return pressureCache.GetValue();
+}
+
+// Returns the value following `key` at the start of a "key value" line
+static uint64_t ParseKeyedValue(std::string_view contents,
+                                std::string_view key) {
+  size_t pos = 0;
+  while ((pos = contents.find(key, pos)) != std::string_view::npos) {
+    if ((pos == 0 || contents[pos - 1] == '\n') &&
+        pos + key.size() < contents.size() && contents[pos + key.size()] == ' ') {
+      pos += key.size();
+      return ParseNumber<uint64_t>(contents, pos);
+    }
+    pos += key.size();
+  }
+  return 0;
+}
+
+// Pure cgroup v2 hosts mount the unified hierarchy at /sys/fs/cgroup, hybrid
+// setups below it in "unified"
+static const std::string& CgroupRoot() {
+  static const std::string root =
+      access((kCgroupRoot + "/cgroup.controllers").c_str(), F_OK) != 0 &&
+              access(kCgroupHybridRoot.c_str(), F_OK) == 0
+          ? kCgroupHybridRoot
+          : kCgroupRoot;
+  return root;
+}
+
+cgroupFileData parseCgroupFiles(const std::string& cgroupPath) {
+  struct cgroupFileData data {};
+  std::string base = CgroupRoot() + cgroupPath;
+  char buffer[4096];
+  size_t pos = 0;
+
+  std::string_view contents =
+      ReadToBuffer(base + "/cpu.stat", buffer, sizeof(buffer));
+  if (contents.empty()) {
+    return data;
+  }
+  data.valid = true;
+  data.usageUsec = ParseKeyedValue(contents, "usage_usec");
+
+  contents = ReadToBuffer(base + "/memory.current", buffer, sizeof(buffer));
+  data.memCurrent = ParseNumber<uint64_t>(contents, pos) / 1024;
+
+  contents = ReadToBuffer(base + "/memory.stat", buffer, sizeof(buffer));
+  data.memAnon = ParseKeyedValue(contents, "anon") / 1024;
+  data.memFile = ParseKeyedValue(contents, "file") / 1024;
+
+  data.cpuPressure = parsePsiBuffer(
+      ReadToBuffer(base + "/cpu.pressure", buffer, sizeof(buffer))).some.avg10;
+  data.memoryPressure = parsePsiBuffer(ReadToBuffer(
+      base + "/memory.pressure", buffer, sizeof(buffer))).some.avg10;
+  data.ioPressure = parsePsiBuffer(
+      ReadToBuffer(base + "/io.pressure", buffer, sizeof(buffer))).some.avg10;
+
+  return data;
+}
+
+procStatusFileData parseProcStatusFilePid(int pid) {
+  char buffer[4096];
+  return parseProcStatusBuffer(ReadToBuffer(
+      kProcDirectory + std::to_string(pid) + kStatusFilename, buffer,
+      sizeof(buffer)));
+}
+
+std::string Uid(pid_t pid) {
+  return UserName(parseProcStatusFilePid(pid).uid);
+}
+
+std::string UserName(uid_t uid) {
   static std::unordered_map<uid_t, std::string> mapOfUIDs;
-  if (mapOfUIDs.find(user_uid) != mapOfUIDs.end()) {
-    return mapOfUIDs[user_uid];
+  auto it = mapOfUIDs.find(uid);
+  if (it != mapOfUIDs.end()) {
+    return it->second;
   }
 
+  std::ifstream filestream = OpenFileStream(kPasswordPath);
   std::string user;
+  bool found = false;
   ProcessFileLines(filestream, kPasswordPath,
                    [&](std::istringstream& curr_line) -> bool {
                      std::string uid_in_file, passwd;
                      std::getline(curr_line, user, ':');
                      std::getline(curr_line, passwd, ':');
                      std::getline(curr_line, uid_in_file, ':');
-                     if (stoi(uid_in_file) == static_cast<int>(user_uid)) {
-                       return true;
-                     }
-                     return false;
+                     unsigned long parsed = 0;
+                     std::from_chars(uid_in_file.data(),
+                                     uid_in_file.data() + uid_in_file.size(),
+                                     parsed);
+                     found = (parsed == uid && !uid_in_file.empty());
+                     return found;
                    });
 
-  mapOfUIDs.emplace(user_uid, user);
-
+  if (!found) {
+    user = std::to_string(uid);
+  }
   filestream.close();
-  return mapOfUIDs[user_uid];
+  return mapOfUIDs.emplace(uid, user).first->second;
 }
 
 std::string LoadAverage() {
-  static Cache<std::string> loadAvgCache(cacheDuration);
+  static Cache<std::string> loadAvgCache(Globals::CacheDuration());
   if (loadAvgCache.IsCacheValid()) {
     return loadAvgCache.GetValue();
   }
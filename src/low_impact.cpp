@@ -0,0 +1,133 @@
+#include "low_impact.h"
+
+#include <malloc.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace LowImpact {
+
+static Policy current;
+
+bool ParseCpuList(const std::string& text, std::vector<int>& cpus) {
+  cpus.clear();
+  const char* pos = text.c_str();
+  while (*pos != '\0') {
+    char* end = nullptr;
+    long first = strtol(pos, &end, 10);
+    if (end == pos || first < 0) return false;
+    long last = first;
+    if (*end == '-') {
+      pos = end + 1;
+      last = strtol(pos, &end, 10);
+      if (end == pos || last < first) return false;
+    }
+    if (last >= CPU_SETSIZE) return false;
+    for (long cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    if (*end == ',') ++end;
+    else if (*end != '\0') return false;
+    pos = end;
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return !cpus.empty();
+}
+
+// Faults in the pages below the current frame, which mlockall() then keeps
+__attribute__((noinline)) static void prefaultStack() {
+  volatile char stack[LOW_IMPACT_STACK_PREFAULT];
+  long pageSize = sysconf(_SC_PAGESIZE);
+  for (size_t i = 0; i < sizeof(stack); i += pageSize) stack[i] = 0;
+}
+
+static bool lockMemory() {
+  // Freed heap memory stays mapped (and locked) for the next sample instead
+  // of going back to the kernel and being faulted in again
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+  prefaultStack();
+
+  // Everything mapped now is faulted in and locked. Later mappings are
+  // locked as they fault: locking them up front would fault in the whole
+  // stack of every thread.
+  if (mlockall(MCL_CURRENT) != 0) {
+    perror("failed to lock memory");
+    return false;
+  }
+#ifdef MCL_ONFAULT
+  int futureFlags = MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT;
+#else
+  int futureFlags = MCL_CURRENT | MCL_FUTURE;
+#endif
+  if (mlockall(futureFlags) != 0) {
+    perror("failed to lock memory");
+    return false;
+  }
+  return true;
+}
+
+bool Apply(const Policy& policy) {
+  if (policy.idle) {
+    struct sched_param param {};
+    if (sched_setscheduler(0, SCHED_IDLE, &param) != 0) {
+      perror("failed to switch to SCHED_IDLE");
+      return false;
+    }
+  }
+  // On Linux this only sets the calling thread, which is why it has to run
+  // before the others are started
+  if (policy.setNice && setpriority(PRIO_PROCESS, 0, policy.nice) != 0) {
+    perror("failed to set the nice level");
+    return false;
+  }
+  if (!policy.cpus.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : policy.cpus) CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+      perror("failed to set the CPU affinity");
+      return false;
+    }
+  }
+  if (policy.lockMemory && !lockMemory()) {
+    return false;
+  }
+  current = policy;
+  return true;
+}
+
+const Policy& Current() { return current; }
+
+std::string Describe() {
+  std::string text;
+  auto add = [&text](const std::string& part) {
+    if (!text.empty()) text += ", ";
+    text += part;
+  };
+  if (current.idle) add("idle");
+  if (current.setNice) add("nice " + std::to_string(current.nice));
+  if (!current.cpus.empty()) {
+    std::string list;
+    for (size_t i = 0; i < current.cpus.size();) {
+      size_t j = i;
+      while (j + 1 < current.cpus.size() &&
+             current.cpus[j + 1] == current.cpus[j] + 1) {
+        ++j;
+      }
+      if (!list.empty()) list += ",";
+      list += std::to_string(current.cpus[i]);
+      if (j > i) list += "-" + std::to_string(current.cpus[j]);
+      i = j + 1;
+    }
+    add("cpus " + list);
+  }
+  if (current.lockMemory) add("mlock");
+  return text;
+}
+
+}  // namespace LowImpact
@@ -1,7 +1,75 @@
+#include "batch_output.h"
+#include "benchmark.h"
+#include "columns.h"
+#include "globals.h"
+#include "low_impact.h"
+#include "metrics_exporter.h"
+#include "options.h"
+#include "recording.h"
 #include "system.h"
 #include "ncurses_display.h"
 
-int main() {
+int main(int argc, char* argv[]) {
+  CommandLine::Options options;
+  int exitCode;
+  if (!CommandLine::Parse(argc, argv, options, exitCode)) {
+    return exitCode;
+  }
+
+  // The UI shows the --fields as columns
+  std::vector<int> columns;
+  bool display = !options.batch && options.recordPath.empty() &&
+                 options.benchmark.empty();
+  if (display && !Columns::Parse(options.fields, columns)) {
+    return 2;
+  }
+
+  // Before the first thread starts, so that they all inherit it
+  if (options.policy.Enabled() && !LowImpact::Apply(options.policy)) {
+    return 1;
+  }
+
+  if (!options.replayPath.empty()) {
+    // Play back at the speed it was recorded
+    Recording::Player player;
+    if (!player.Open(options.replayPath)) {
+      return 1;
+    }
+    Globals::SetRefreshRate(player.IntervalMs());
+    NCursesDisplay::Display(player, columns);
+    return 0;
+  }
+
+  Globals::SetRefreshRate(options.intervalMs);
+  Globals::SetCmdlineMaxLength(options.cmdlineMax);
   System system;
-  NCursesDisplay::Display(system);
-}
\ No newline at end of file
+  // The UI draws its first frame before the process scan is done; everything
+  // else starts from a primed sample
+  if (!display) {
+    system.Prime();
+  }
+
+  MetricsExporter exporter;
+  if (!options.listenAddress.empty()) {
+    size_t topProcesses =
+        options.topN ? options.topN : EXPORTER_DEFAULT_TOP_PROCESSES;
+    if (!exporter.Start(options.listenAddress, topProcesses)) {
+      return 1;
+    }
+    // Serve the first sample until the next one is in
+    exporter.Publish(system);
+    system.AddSampleObserver(
+        [&exporter](System& sampled) { exporter.Publish(sampled); });
+  }
+
+  if (!options.benchmark.empty()) {
+    return Benchmark::Run(system, options.benchmark);
+  }
+  if (options.batch) {
+    return BatchOutput::Run(system, options);
+  }
+  if (!options.recordPath.empty()) {
+    return Recording::RunRecorder(system, options);
+  }
+  NCursesDisplay::Display(system, columns);
+}
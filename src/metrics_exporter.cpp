@@ -0,0 +1,520 @@
+#include "metrics_exporter.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "disk_stats.h"
+#include "mem_data.h"
+#include "pressure_stats.h"
+#include "process.h"
+#include "processor.h"
+#include "system.h"
+
+#define EXPORTER_MAX_CLIENTS 64
+#define EXPORTER_REQUEST_SIZE 2048
+#define EXPORTER_CLIENT_TIMEOUT_MS 10000
+#define EXPORTER_COMMAND_LABEL_SIZE 128
+
+static const char kNotFound[] =
+    "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+static const char kUnavailable[] =
+    "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n"
+    "Connection: close\r\n\r\n";
+
+// Family header; OpenMetrics requires TYPE before the samples
+static void AppendFamily(OutputBuffer& out, std::string_view name,
+                         std::string_view type, std::string_view help) {
+  out.Append("# TYPE ");
+  out.Append(name);
+  out.Append(' ');
+  out.Append(type);
+  out.Append("\n# HELP ");
+  out.Append(name);
+  out.Append(' ');
+  out.Append(help);
+  out.Append('\n');
+}
+
+static void AppendLabelValue(OutputBuffer& out, std::string_view value) {
+  out.Append('"');
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      out.Append('\\');
+      out.Append(c);
+    } else if (c == '\n') {
+      out.Append("\\n");
+    } else {
+      out.Append(c);
+    }
+  }
+  out.Append('"');
+}
+
+// Executable of the command line, which keeps the label cardinality sane
+static std::string_view CommandLabel(const std::string& command) {
+  std::string_view label(command);
+  label = label.substr(0, label.find(' '));
+  return label.substr(0, EXPORTER_COMMAND_LABEL_SIZE);
+}
+
+static void AppendProcessLabels(OutputBuffer& out, Process& process) {
+  out.Append("{pid=\"");
+  out.AppendInteger(process.Pid());
+  out.Append("\",user=");
+  AppendLabelValue(out, process.User());
+  out.Append(",command=");
+  AppendLabelValue(out, CommandLabel(process.Command()));
+  out.Append("} ");
+}
+
+static void RenderExposition(OutputBuffer& out, System& system,
+                             size_t topProcesses) {
+  static const long clockTicks = sysconf(_SC_CLK_TCK);
+  const MemData& mem = system.MemoryUtilization();
+  const auto& cpuData = system.totalCpuUtilization();
+
+  AppendFamily(out, "monitor_cpu_utilization_ratio", "gauge",
+               "Busy share of the CPU since the previous sample.");
+  for (size_t i = 0; i < cpuData.size(); ++i) {
+    out.Append("monitor_cpu_utilization_ratio{cpu=\"");
+    if (i == 0) {
+      out.Append("total");
+    } else {
+      out.AppendInteger(i - 1);
+    }
+    out.Append("\"} ");
+    out.AppendFixed(cpuData[i].Utilization(), 4);
+    out.Append('\n');
+  }
+
+  AppendFamily(out, "monitor_cpu_time_seconds", "counter",
+               "Time the CPUs spent in each mode.");
+  for (size_t i = 1; i < cpuData.size(); ++i) {
+    const CPUData& cpu = cpuData[i].current;
+    const std::pair<std::string_view, uint64_t> modes[] = {
+        {"user", cpu.usertime},       {"nice", cpu.nicetime},
+        {"system", cpu.systemtime},   {"idle", cpu.idletime},
+        {"iowait", cpu.iowaittime},   {"irq", cpu.irqtime},
+        {"softirq", cpu.softirqtime}, {"steal", cpu.stealtime}};
+    for (const auto& [mode, jiffies] : modes) {
+      out.Append("monitor_cpu_time_seconds_total{cpu=\"");
+      out.AppendInteger(i - 1);
+      out.Append("\",mode=\"");
+      out.Append(mode);
+      out.Append("\"} ");
+      out.AppendFixed((double)jiffies / clockTicks, 2);
+      out.Append('\n');
+    }
+  }
+
+  AppendFamily(out, "monitor_memory_bytes", "gauge",
+               "Memory and swap usage from /proc/meminfo.");
+  const std::pair<std::string_view, uint64_t> memory[] = {
+      {"total", mem.memTotal},         {"free", mem.memFree},
+      {"available", mem.memAvailable}, {"buffers", mem.buffers},
+      {"cached", mem.cached},          {"shmem", mem.shmem},
+      {"swap_total", mem.swapTotal},   {"swap_free", mem.swapFree}};
+  for (const auto& [type, kb] : memory) {
+    out.Append("monitor_memory_bytes{type=\"");
+    out.Append(type);
+    out.Append("\"} ");
+    out.AppendInteger(kb * 1024);
+    out.Append('\n');
+  }
+
+  // /proc/loadavg already holds decimal numbers
+  AppendFamily(out, "monitor_load_average", "gauge",
+               "Load average over 1, 5 and 15 minutes.");
+  std::string loadAverage = system.LoadAverage();
+  std::string_view load(loadAverage);
+  for (std::string_view period : {"1m", "5m", "15m"}) {
+    size_t space = load.find(' ');
+    out.Append("monitor_load_average{period=\"");
+    out.Append(period);
+    out.Append("\"} ");
+    out.Append(load.substr(0, space));
+    out.Append('\n');
+    load = (space == std::string_view::npos) ? std::string_view()
+                                             : load.substr(space + 1);
+  }
+
+  AppendFamily(out, "monitor_uptime_seconds", "gauge", "System uptime.");
+  out.Append("monitor_uptime_seconds ");
+  out.AppendInteger(system.UpTime());
+  out.Append('\n');
+
+  AppendFamily(out, "monitor_tasks", "gauge", "Number of user processes.");
+  out.Append("monitor_tasks ");
+  out.AppendInteger(system.getNumOfTasks());
+  out.Append('\n');
+  AppendFamily(out, "monitor_threads", "gauge",
+               "Number of threads of the user processes.");
+  out.Append("monitor_threads ");
+  out.AppendInteger(system.getNumOfThreads());
+  out.Append('\n');
+  AppendFamily(out, "monitor_running_tasks", "gauge",
+               "Number of runnable tasks.");
+  out.Append("monitor_running_tasks ");
+  out.AppendInteger(system.getNumOfRunningTasks());
+  out.Append('\n');
+
+  // The counters of /proc/diskstats as they are, plus the two values that
+  // need the time between samples
+  const std::vector<Disk>& disks = system.Disks()->Disks();
+  auto appendDisk = [&](std::string_view name, const Disk& disk,
+                        std::string_view op) {
+    out.Append(name);
+    out.Append("{device=");
+    AppendLabelValue(out, disk.counters.name);
+    if (!op.empty()) {
+      out.Append(",op=\"");
+      out.Append(op);
+      out.Append('"');
+    }
+    out.Append("} ");
+  };
+  AppendFamily(out, "monitor_disk_operations", "counter",
+               "Completed read and write requests of the disk.");
+  for (const Disk& disk : disks) {
+    appendDisk("monitor_disk_operations_total", disk, "read");
+    out.AppendInteger(disk.counters.reads);
+    out.Append('\n');
+    appendDisk("monitor_disk_operations_total", disk, "write");
+    out.AppendInteger(disk.counters.writes);
+    out.Append('\n');
+  }
+  AppendFamily(out, "monitor_disk_bytes", "counter",
+               "Bytes read from and written to the disk.");
+  for (const Disk& disk : disks) {
+    appendDisk("monitor_disk_bytes_total", disk, "read");
+    out.AppendInteger(disk.counters.readSectors * 512);
+    out.Append('\n');
+    appendDisk("monitor_disk_bytes_total", disk, "write");
+    out.AppendInteger(disk.counters.writeSectors * 512);
+    out.Append('\n');
+  }
+  AppendFamily(out, "monitor_disk_request_time_seconds", "counter",
+               "Time the completed requests of the disk took, added up.");
+  for (const Disk& disk : disks) {
+    appendDisk("monitor_disk_request_time_seconds_total", disk, "read");
+    out.AppendFixed(disk.counters.readMs / 1000.0, 3);
+    out.Append('\n');
+    appendDisk("monitor_disk_request_time_seconds_total", disk, "write");
+    out.AppendFixed(disk.counters.writeMs / 1000.0, 3);
+    out.Append('\n');
+  }
+  AppendFamily(out, "monitor_disk_utilization_ratio", "gauge",
+               "Share of the time the disk had requests in flight since the "
+               "previous sample.");
+  for (const Disk& disk : disks) {
+    appendDisk("monitor_disk_utilization_ratio", disk, "");
+    out.AppendFixed(disk.rates.utilization, 4);
+    out.Append('\n');
+  }
+  AppendFamily(out, "monitor_disk_queue_depth", "gauge",
+               "Average requests in flight since the previous sample.");
+  for (const Disk& disk : disks) {
+    appendDisk("monitor_disk_queue_depth", disk, "");
+    out.AppendFixed(disk.rates.queueDepth, 2);
+    out.Append('\n');
+  }
+
+  // Left out on kernels without PSI; "full" of the CPU is zero before 5.13
+  const PressureStats* pressure = system.Pressure();
+  if (pressure != nullptr && pressure->Available()) {
+    const char* names[] = {"cpu", "memory", "io"};
+    AppendFamily(out, "monitor_pressure_stall_seconds", "counter",
+                 "Time some or all non-idle tasks were stalled on the "
+                 "resource.");
+    for (int resource = 0; resource < LinuxParser::PSI_NUM_RESOURCES;
+         ++resource) {
+      const LinuxParser::psiFileData& file =
+          pressure->File((LinuxParser::PsiResource)resource);
+      for (bool full : {false, true}) {
+        out.Append("monitor_pressure_stall_seconds_total{resource=\"");
+        out.Append(names[resource]);
+        out.Append(full ? "\",kind=\"full\"} " : "\",kind=\"some\"} ");
+        out.AppendFixed((full ? file.full : file.some).total / 1e6, 6);
+        out.Append('\n');
+      }
+    }
+  }
+
+  std::vector<std::shared_ptr<Process>> processes =
+      system.processManager.GetSortedProcessesForDisplay(topProcesses);
+
+  AppendFamily(out, "monitor_process_cpu_percent", "gauge",
+               "CPU utilization of the process in percent of one CPU.");
+  for (const auto& process : processes) {
+    out.Append("monitor_process_cpu_percent");
+    AppendProcessLabels(out, *process);
+    out.AppendFixed(process->CpuUtilization(), 1);
+    out.Append('\n');
+  }
+  AppendFamily(out, "monitor_process_cpu_seconds", "counter",
+               "CPU time consumed by the process.");
+  for (const auto& process : processes) {
+    out.Append("monitor_process_cpu_seconds_total");
+    AppendProcessLabels(out, *process);
+    out.AppendFixed(process->UpTime(), 2);
+    out.Append('\n');
+  }
+  AppendFamily(out, "monitor_process_resident_memory_bytes", "gauge",
+               "Resident set size of the process.");
+  for (const auto& process : processes) {
+    out.Append("monitor_process_resident_memory_bytes");
+    AppendProcessLabels(out, *process);
+    out.AppendInteger(process->MemUtilization().resident_mem * 1024);
+    out.Append('\n');
+  }
+  AppendFamily(out, "monitor_process_virtual_memory_bytes", "gauge",
+               "Virtual memory size of the process.");
+  for (const auto& process : processes) {
+    out.Append("monitor_process_virtual_memory_bytes");
+    AppendProcessLabels(out, *process);
+    out.AppendInteger(process->MemUtilization().virtual_mem * 1024);
+    out.Append('\n');
+  }
+  AppendFamily(out, "monitor_process_threads", "gauge",
+               "Number of threads of the process.");
+  for (const auto& process : processes) {
+    out.Append("monitor_process_threads");
+    AppendProcessLabels(out, *process);
+    out.AppendInteger(process->getNumThreads());
+    out.Append('\n');
+  }
+
+  out.Append("# EOF\n");
+}
+
+void MetricsExporter::Publish(System& system) {
+  body_.Clear();
+  RenderExposition(body_, system, topProcesses_);
+
+  char header[256];
+  int headerSize = snprintf(
+      header, sizeof(header),
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: application/openmetrics-text; version=1.0.0; "
+      "charset=utf-8\r\n"
+      "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+      body_.Size());
+
+  auto response = std::make_shared<std::string>();
+  response->reserve(headerSize + body_.Size());
+  response->append(header, headerSize);
+  response->append(body_.View());
+  std::atomic_store(&response_,
+                    std::shared_ptr<const std::string>(std::move(response)));
+}
+
+// Parses "unix:/path" or "[host]:port" and binds a listening socket
+static int OpenListener(const std::string& address, std::string& unixPath) {
+  int fd;
+  if (address.rfind("unix:", 0) == 0) {
+    unixPath = address.substr(5);
+    struct sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    if (unixPath.empty() || unixPath.size() >= sizeof(addr.sun_path)) {
+      fprintf(stderr, "invalid unix socket path: %s\n", unixPath.c_str());
+      return -1;
+    }
+    std::memcpy(addr.sun_path, unixPath.c_str(), unixPath.size());
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    unlink(unixPath.c_str());
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+      perror(("error while binding " + address).c_str());
+      if (fd >= 0) close(fd);
+      unixPath.clear();
+      return -1;
+    }
+  } else {
+    size_t colon = address.rfind(':');
+    std::string host = (colon == std::string::npos) ? "" : address.substr(0, colon);
+    std::string port = address.substr(colon == std::string::npos ? 0 : colon + 1);
+    if (host.empty() || host == "localhost") host = "127.0.0.1";
+    if (host.size() > 2 && host.front() == '[' && host.back() == ']') {
+      host = host.substr(1, host.size() - 2);
+    }
+    int portNumber = atoi(port.c_str());
+    if (portNumber <= 0 || portNumber > 65535) {
+      fprintf(stderr, "invalid port: %s\n", port.c_str());
+      return -1;
+    }
+
+    struct sockaddr_storage storage {};
+    socklen_t length;
+    auto* addr4 = reinterpret_cast<sockaddr_in*>(&storage);
+    auto* addr6 = reinterpret_cast<sockaddr_in6*>(&storage);
+    if (inet_pton(AF_INET, host.c_str(), &addr4->sin_addr) == 1) {
+      addr4->sin_family = AF_INET;
+      addr4->sin_port = htons(portNumber);
+      length = sizeof(*addr4);
+    } else if (inet_pton(AF_INET6, host.c_str(), &addr6->sin6_addr) == 1) {
+      addr6->sin6_family = AF_INET6;
+      addr6->sin6_port = htons(portNumber);
+      length = sizeof(*addr6);
+    } else {
+      fprintf(stderr, "invalid listen address: %s\n", host.c_str());
+      return -1;
+    }
+
+    fd = socket(storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    int reuse = 1;
+    if (fd >= 0) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&storage), length) < 0) {
+      perror(("error while binding " + address).c_str());
+      if (fd >= 0) close(fd);
+      return -1;
+    }
+  }
+
+  if (listen(fd, EXPORTER_MAX_CLIENTS) < 0) {
+    perror(("error while listening on " + address).c_str());
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+MetricsExporter::~MetricsExporter() { Stop(); }
+
+bool MetricsExporter::Start(const std::string& address, size_t topProcesses) {
+  topProcesses_ = topProcesses;
+  listenFd_ = OpenListener(address, unixPath_);
+  if (listenFd_ < 0) return false;
+  if (pipe2(wakePipe_, O_CLOEXEC) < 0) {
+    perror("error while creating pipe");
+    close(listenFd_);
+    listenFd_ = -1;
+    return false;
+  }
+  thread_ = std::thread(&MetricsExporter::serve, this);
+  return true;
+}
+
+void MetricsExporter::Stop() {
+  if (thread_.joinable()) {
+    char stop = 'q';
+    write(wakePipe_[1], &stop, 1);
+    thread_.join();
+  }
+  for (int* fd : {&listenFd_, &wakePipe_[0], &wakePipe_[1]}) {
+    if (*fd >= 0) close(*fd);
+    *fd = -1;
+  }
+  if (!unixPath_.empty()) {
+    unlink(unixPath_.c_str());
+    unixPath_.clear();
+  }
+}
+
+struct ExporterClient {
+  int fd;
+  std::chrono::steady_clock::time_point accepted;
+  char request[EXPORTER_REQUEST_SIZE];
+  size_t requestSize;
+  // Set once the request is complete; points into the published buffer
+  std::shared_ptr<const std::string> response;
+  std::string_view pending;
+};
+
+void MetricsExporter::serve() {
+  std::vector<std::unique_ptr<ExporterClient>> clients;
+  std::vector<pollfd> pollFds;
+
+  while (true) {
+    pollFds.clear();
+    pollFds.push_back({wakePipe_[0], POLLIN, 0});
+    pollFds.push_back(
+        {listenFd_, static_cast<short>(clients.size() < EXPORTER_MAX_CLIENTS ? POLLIN : 0), 0});
+    for (const auto& client : clients) {
+      pollFds.push_back(
+          {client->fd, static_cast<short>(client->pending.empty() ? POLLIN : POLLOUT), 0});
+    }
+
+    if (poll(pollFds.data(), pollFds.size(), 1000) < 0 && errno != EINTR) {
+      perror("error while polling exporter sockets");
+      break;
+    }
+    if (pollFds[0].revents) break;
+
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < clients.size(); ++i) {
+      ExporterClient& client = *clients[i];
+      short revents = pollFds[i + 2].revents;
+      bool done = (revents & (POLLERR | POLLHUP)) ||
+                  now - client.accepted >
+                      std::chrono::milliseconds(EXPORTER_CLIENT_TIMEOUT_MS);
+
+      if (!done && (revents & POLLIN)) {
+        ssize_t len = recv(client.fd, client.request + client.requestSize,
+                           sizeof(client.request) - 1 - client.requestSize, 0);
+        if (len <= 0) {
+          done = true;
+        } else {
+          client.requestSize += len;
+          client.request[client.requestSize] = '\0';
+          if (strstr(client.request, "\r\n\r\n") || strstr(client.request, "\n\n")) {
+            // Serve the buffer that is current right now, without copying it
+            if (strncmp(client.request, "GET /metrics ", 13) == 0 ||
+                strncmp(client.request, "GET / ", 6) == 0) {
+              client.response = std::atomic_load(&response_);
+              client.pending = client.response
+                                   ? std::string_view(*client.response)
+                                   : std::string_view(kUnavailable);
+            } else {
+              client.pending = kNotFound;
+            }
+          } else if (client.requestSize == sizeof(client.request) - 1) {
+            client.pending = kNotFound;
+          }
+        }
+      }
+
+      if (!done && (revents & POLLOUT)) {
+        ssize_t len = send(client.fd, client.pending.data(),
+                           client.pending.size(), MSG_NOSIGNAL);
+        if (len < 0 && errno != EAGAIN && errno != EINTR) {
+          done = true;
+        } else if (len > 0) {
+          client.pending.remove_prefix(len);
+          done = client.pending.empty();
+        }
+      }
+
+      if (done) {
+        close(client.fd);
+        clients[i].reset();
+      }
+    }
+    clients.erase(std::remove(clients.begin(), clients.end(), nullptr),
+                  clients.end());
+
+    if (pollFds[1].revents & POLLIN) {
+      int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd >= 0) {
+        auto client = std::make_unique<ExporterClient>();
+        client->fd = fd;
+        client->accepted = now;
+        client->requestSize = 0;
+        clients.push_back(std::move(client));
+      }
+    }
+  }
+
+  for (const auto& client : clients) {
+    close(client->fd);
+  }
+}
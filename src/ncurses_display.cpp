@@ -1,32 +1,41 @@
 #include "ncurses_display.h"
 
 #include <cmath>
+#include <condition_variable>
 #include <thread>
 #include <ncurses.h>
 #include "format.h"
 #include <mutex>
 #include <csignal>
 #include <sstream>
-#include "system.h"
+#include <unordered_map>
+#include <unordered_set>
+#include "data_source.h"
+#include "mem_data.h"
 #include "process.h"
+#include "cgroup_manager.h"
+#include "columns.h"
 #include "globals.h"
 #include "processor.h"
+#include "cpu_usage.h"
+#include "disk_stats.h"
 #include "event_queue.h"
+#include "history.h"
+#include "interrupt_stats.h"
+#include "low_impact.h"
+#include "network_stats.h"
+#include "pressure_stats.h"
+#include "process_filter.h"
+#include "process_manager.h"
+#include "self_stats.h"
+#include "shadow_window.h"
 #include <unistd.h>
+#include <fcntl.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 
-#define PID_INDEX        0
-#define USER_INDEX       1
-#define PRI_INDEX        2
-#define NI_INDEX         3
-#define VIRT_INDEX       4
-#define RES_INDEX        5
-#define SHR_INDEX        6
-#define S_INDEX          7
-#define CPU_INDEX        8
-#define MEM_INDEX        9
-#define TIME_INDEX       10
-#define COMMAND_INDEX    11
-
+// Rows of the upper panel without the pressure row and disk bars
 #define UPPER_PANEL_HEIGHT 10
 #define MIN_UPPER_PANEL_BAR_WIDTH 6
 #define PADDING_BETWEEN_BARS 2
@@ -36,6 +45,35 @@
 #define LOWER_PANEL_WIDTH 2
 #define UPPER_PANEL_BARS_PER_COLUMN 4
 #define UPPER_PANEL_SPACING_BETWEEN_COLUMNS 1
+// More cores than this are drawn as a heatmap with one cell per core
+#define CPU_HEATMAP_THRESHOLD 32
+// "N12 100.0%" and a space
+#define CPU_SUMMARY_WIDTH 11
+// Density ramp of the history graphs, lowest first; plain ASCII so it renders
+// with the narrow curses library in any locale
+#define SPARKLINE_RAMP ".:-=+*#%@"
+// Interface names are at most 15 characters, and a space
+#define NETWORK_NAME_WIDTH 16
+// Throughput graphs are never scaled below this many bytes per second
+#define NETWORK_MIN_SCALE 1024
+// Stall graphs are never scaled below this many percent
+#define PSI_MIN_SCALE 10.0f
+// Disks get a row each below the history, up to this many
+#define DISK_MAX_BARS 4
+// Longer disk names are cut
+#define DISK_MAX_LABEL 8
+// Descriptor counts from this share of the soft RLIMIT_NOFILE on stand out
+#define FD_WARN_USAGE 0.8
+// Columns of the interrupt view before the per-CPU rates
+#define IRQ_NAME_WIDTH 9
+#define IRQ_DESCRIPTION_WIDTH 21
+#define IRQ_CPU_WIDTH 8
+// Interrupt sources this busy that one CPU handles this share of stand out,
+// as candidates for spreading with smp_affinity or RPS
+#define IRQ_HOT_RATE 100.0
+#define IRQ_CONCENTRATED_SHARE 0.9
+// numa_maps of the process shown with 'N' is read again after this long
+#define NUMA_MAPS_REFRESH_MS 5000
 
 namespace NCursesDisplay {
 
@@ -47,7 +85,9 @@ enum class ColorPairs {
   cyan_black_pair,
   white_black_pair,
   blue_black_pair,
-  black_cyan_pair
+  black_cyan_pair,
+  black_yellow_pair,
+  magenta_black_pair
 };
 
 class Bar {
@@ -62,17 +102,13 @@ private:
   ColorPairs _bracketsColorPair;
   ColorPairs _rightLabelColorPair;
   ColorPairs _leftLabelColorPair;
-  WINDOW *_owningPanel;
+  ShadowWindow *_owningPanel;
 public:
   void drawBar() {
-
-    wattron(_owningPanel, COLOR_PAIR(_leftLabelColorPair));
-    mvwprintw(_owningPanel, _startY, _startX, "%s", _leftLabel.c_str());
-    wattroff(_owningPanel, COLOR_PAIR(_leftLabelColorPair));
-
-    wattron(_owningPanel, COLOR_PAIR(_bracketsColorPair) | A_BOLD);
-    mvwprintw(_owningPanel, _startY, _startX + _leftLabel.size(), "[");
-    wattroff(_owningPanel, COLOR_PAIR(_bracketsColorPair) | A_BOLD);
+    _owningPanel->Print(_startY, _startX, _leftLabel,
+                        COLOR_PAIR(_leftLabelColorPair));
+    _owningPanel->Print(_startY, _startX + _leftLabel.size(), "[",
+                        COLOR_PAIR(_bracketsColorPair) | A_BOLD);
 
     int accumulatedLenOfBars = 0;
 
@@ -82,34 +118,23 @@ public:
           ((float)_barLength - 2 - _rightLabel.size() - _leftLabel.size()) *
           _ratios[i];
 
-      wattron(_owningPanel, COLOR_PAIR(currColorPair));
-
       // Draw the bar for this ratio
-      for (int col = 0; col < cols_in_bar_to_fill; ++col) {
-        mvwaddch(_owningPanel, _startY, _startX + accumulatedLenOfBars + 1
-                                            + _leftLabel.size() + col, '|');
-      }
+      _owningPanel->Fill(_startY,
+                         _startX + accumulatedLenOfBars + 1 + _leftLabel.size(),
+                         cols_in_bar_to_fill, '|' | COLOR_PAIR(currColorPair));
 
       accumulatedLenOfBars += cols_in_bar_to_fill;
-      wattroff(_owningPanel, COLOR_PAIR(currColorPair));
-
     }
 
-    wattron(_owningPanel, COLOR_PAIR(_rightLabelColorPair) | A_BOLD);
-    mvwprintw(_owningPanel, _startY,
-              _startX + _barLength - 1 - _rightLabel.size(), "%s",
-              _rightLabel.c_str());
-    wattroff(_owningPanel, COLOR_PAIR(_rightLabelColorPair));
-
-    wattron(_owningPanel, COLOR_PAIR(_bracketsColorPair));
-    mvwprintw(_owningPanel, _startY, _startX + _barLength - 1, "]");
-    wattroff(_owningPanel, COLOR_PAIR(_bracketsColorPair) | A_BOLD);
-
+    _owningPanel->Print(_startY, _startX + _barLength - 1 - _rightLabel.size(),
+                        _rightLabel, COLOR_PAIR(_rightLabelColorPair) | A_BOLD);
+    _owningPanel->Print(_startY, _startX + _barLength - 1, "]",
+                        COLOR_PAIR(_bracketsColorPair) | A_BOLD);
   }
 
   Bar(int startX, int startY, int barLength, std::string& leftLabel,
       std::string& rightLabel, std::vector<ColorPairs>& colorPairs,
-      std::vector<float>& ratios, WINDOW *owningPanel,
+      std::vector<float>& ratios, ShadowWindow *owningPanel,
       ColorPairs bracketsColorPair = ColorPairs::white_black_pair,
       ColorPairs leftLabelColorPair = ColorPairs::cyan_black_pair,
       ColorPairs rightLabelColorPair = ColorPairs::white_black_pair) :
@@ -123,15 +148,13 @@ public:
   }
 };
 
-static std::vector<std::string> headers = {"    PID", "USER    ", "PRI",
-                                           " NI", "  VIRT", "  RES", "  SHR",
-                                           "S", "  CPU%", "  MEM%", "   TIME+ ", "COMMAND"};
+// UPPER_PANEL_HEIGHT, the pressure row and a row per disk bar
+static int upper_panel_height = UPPER_PANEL_HEIGHT;
 
-static std::vector<int> column_positions;
-
-static float truncateTo1Decimal(float value) {
-  return std::round(value * 10) / 10.0f;
-}
+// Indices into Columns::kColumns in screen order, and where each of them
+// starts (-1 when hidden)
+static std::vector<int> visible_columns;
+static int column_positions[Columns::kCount];
 
 template <typename T>
 static std::string to_string_with_precision(const T a_value, const int n = 1) {
@@ -141,201 +164,372 @@ static std::string to_string_with_precision(const T a_value, const int n = 1) {
   return std::move(out).str();
 }
 
-#define KB_TO_MB(kb) ((float)(kb) / 1024.0f)
-#define KB_TO_GB(kb) ((float)(kb) / (1024.0f * 1024.0f))
-#define IS_LESS_THAN_1MB(kb) ((kb) < 1024)
-#define IS_LESS_THAN_1GB(kb) ((kb) < (1024 * 1024))
-
 static std::string convertMemoryToStr(uint64_t mem_value_in_kb,
                                       int precision = 1) {
-  std::string memStr;
-  if (IS_LESS_THAN_1GB(mem_value_in_kb)) {
-    if (IS_LESS_THAN_1MB(mem_value_in_kb)) {
-      return std::to_string(mem_value_in_kb) + "K";
-    }
-    memStr = to_string_with_precision(KB_TO_MB(mem_value_in_kb), precision) + "M";
-    return memStr;
+  char buffer[32];
+  return std::string(buffer, Format::Memory(buffer, buffer + sizeof(buffer),
+                                            mem_value_in_kb, precision));
+}
+
+// The sort column stands out
+static void displayTableHeader(ShadowWindow& headerWindow, int sortColumn) {
+  attr_t attributes = COLOR_PAIR(ColorPairs::black_green_pair);
+  headerWindow.Fill(0, 0, headerWindow.Width(), ' ' | attributes);
+
+  for (int column : visible_columns) {
+    headerWindow.Print(0, column_positions[column],
+                       Columns::kColumns[column].header,
+                       column == sortColumn
+                           ? COLOR_PAIR(ColorPairs::black_cyan_pair)
+                           : attributes);
   }
-  memStr = to_string_with_precision(KB_TO_GB(mem_value_in_kb), precision) + "G";
-  return memStr;
 }
 
-static void displayTableHeader(WINDOW* headerWindow) {
-  wattron(headerWindow, COLOR_PAIR(ColorPairs::black_green_pair));
-  int width = getmaxx(headerWindow);
+// Calculate column positions based on header lengths and spacing
+static void calculateColumnPositions(const std::vector<int>& columns) {
+  visible_columns = columns;
+  std::fill(std::begin(column_positions), std::end(column_positions), -1);
+  int col_position = 0;
 
-  for (int col = 0; col < width; ++col) {
-    mvwaddch(headerWindow, 0, col, ' ');
+  for (int column : columns) {
+    column_positions[column] = col_position;
+    col_position += Columns::kColumns[column].header.size() +
+                    UPPER_PANEL_SPACING_BETWEEN_COLUMNS;
   }
+}
 
-  for (size_t i = 0; i < headers.size(); ++i) {
-    /*if (i == CPU_INDEX || i == MEM_INDEX) {
-      mvwprintw(headerWindow, 0, column_positions[i], "%s",
-                headers[i].substr(0, headers[i].size() - 1).c_str());
-    } else {*/
-    mvwprintw(headerWindow, 0, column_positions[i],
-                "%s", headers[i].c_str());
+// Places `text` as the value of `column`; left aligned values start `indent`
+// columns in
+static void writeColumn(Format::LineBuffer& line, int column,
+                        std::string_view text, int indent = 0) {
+  int position = column_positions[column];
+  if (position < 0) return;
+  const Columns::Column& entry = Columns::kColumns[column];
+  int width = entry.header.size();
+  if (entry.flags & COLUMN_LEFT_ALIGNED) {
+    if (column != visible_columns.back()) {
+      text = text.substr(0, std::max(0, width - indent));
+    }
+    line.Write(position + indent, text);
+    return;
   }
-
-  wattroff(headerWindow, COLOR_PAIR(ColorPairs::black_green_pair));
+  if (entry.flags & COLUMN_CLIPPED) text = text.substr(0, width);
+  line.WriteRight(position, width, text);
 }
 
-// Calculate column positions based on header lengths and spacing
-static void calculateColumnPositions() {
-  int col_position = 0;
+// A line of the process list: either a process or, in cgroup mode, the
+// aggregated header of a cgroup
+struct ListRow {
+  const CgroupStats* cgroup;
+  std::shared_ptr<Process> process;
+  bool expanded;
+};
 
-  for (const auto& header : headers) {
-    column_positions.push_back(col_position);
-    col_position += header.size() + UPPER_PANEL_SPACING_BETWEEN_COLUMNS;
+// Formats a process into `line` without allocating
+static void displayProcessRow(Format::LineBuffer& line, Process& process,
+                              const MemData& memData, int command_indent) {
+  char buffer[COLUMN_BUFFER_SIZE];
+  for (int column : visible_columns) {
+    writeColumn(line, column,
+                Columns::kColumns[column].format(process, memData, buffer),
+                command_indent);
   }
 }
 
-// Helper to right-align text
-static int rightAlignPosition(int start_position, int field_width,
-                              const std::string& text) {
-  return start_position + field_width - text.size();
+// cgroup header row: process count in the PID column, the cgroup's own
+// counters in RES/CPU%/MEM% and its path, memory split and pressure as command
+static void displayCgroupRow(Format::LineBuffer& line,
+                             const CgroupStats& cgroup, bool expanded,
+                             const MemData& memData) {
+  char field[32];
+  char* const fieldLast = field + sizeof(field);
+  auto writeField = [&](int column, const char* fieldEnd) {
+    writeColumn(line, column, std::string_view(field, fieldEnd - field));
+  };
+
+  writeField(Columns::kPid,
+             Format::Integer(field, fieldLast, cgroup.numProcesses));
+  writeField(Columns::kRes,
+             Format::Memory(field, fieldLast, cgroup.memCurrent, 0));
+  writeField(Columns::kCpu,
+             Format::Tenths(field, fieldLast, cgroup.cpuUtilization));
+  writeField(Columns::kMem,
+             Format::Tenths(field, fieldLast,
+                            ((double)cgroup.memCurrent / memData.memTotal) *
+                                100.0f));
+
+  char anon[16];
+  char file[16];
+  *Format::Memory(anon, anon + sizeof(anon) - 1, cgroup.memAnon) = '\0';
+  *Format::Memory(file, file + sizeof(file) - 1, cgroup.memFile) = '\0';
+  char description[FORMAT_LINE_BUFFER_SIZE];
+  int len = snprintf(description, sizeof(description),
+                     "%s%s  anon %s file %s  psi cpu %.1f mem %.1f io %.1f",
+                     expanded ? "[-] " : "[+] ",
+                     cgroup.path.empty() ? "/" : cgroup.path.c_str(), anon,
+                     file, cgroup.cpuPressure, cgroup.memoryPressure,
+                     cgroup.ioPressure);
+  writeColumn(line, Columns::kCommand,
+              std::string_view(description,
+                               std::min<size_t>(len, sizeof(description) - 1)));
 }
 
-static void printRightAligned(WINDOW* window, int row, int col_start,
-                              int col_width, const std::string& text) {
-  int pos = rightAlignPosition(col_start, col_width, text);
-  mvwprintw(window, row, pos, "%s", text.c_str());
+// Marks the first match of the filter in the user and command columns
+static void highlightMatches(ShadowWindow& processesWin, int i,
+                             Process& process, int command_indent,
+                             std::string_view query) {
+  attr_t highlight = COLOR_PAIR(ColorPairs::black_yellow_pair);
+
+  int userColumn = column_positions[Columns::kUser];
+  int userWidth = Columns::kColumns[Columns::kUser].header.size();
+  std::string_view user = std::string_view(process.User()).substr(0, userWidth);
+  size_t pos = ProcessFilter::Find(user, query);
+  if (userColumn >= 0 && pos != std::string_view::npos) {
+    int userStart = userColumn + userWidth - user.size();
+    processesWin.Print(i, userStart + pos, user.substr(pos, query.size()),
+                       highlight);
+  }
+
+  int commandColumn = column_positions[Columns::kCommand];
+  std::string_view command = process.Command();
+  pos = ProcessFilter::Find(command, query);
+  if (commandColumn >= 0 && pos != std::string_view::npos) {
+    processesWin.Print(i, commandColumn + command_indent + pos,
+                       command.substr(pos, query.size()), highlight);
+  }
+}
+
+// Processes close to running out of descriptors get their FD columns in red
+static void highlightFdUsage(ShadowWindow& processesWin, int i,
+                             Process& process, const MemData& memData) {
+  if (!process.FdAvailable() || process.FdUsage() < FD_WARN_USAGE) return;
+  static const int columns[] = {Columns::Index("fds"),
+                                Columns::Index("fd_usage")};
+  char buffer[COLUMN_BUFFER_SIZE];
+  for (int column : columns) {
+    int position = column_positions[column];
+    if (position < 0) continue;
+    const Columns::Column& entry = Columns::kColumns[column];
+    std::string_view text = entry.format(process, memData, buffer);
+    processesWin.Print(i, position + entry.header.size() - text.size(), text,
+                       COLOR_PAIR(ColorPairs::red_black_pair) | A_BOLD);
+  }
 }
 
 static void displayProcesses(
-    WINDOW* processesWin,
-    const std::vector<std::shared_ptr<Process>>& processes,
+    ShadowWindow& processesWin, const std::vector<ListRow>& rows,
     const MemData& memData, int max_rows,
-    int current_selection, int scroll_offset) {
-  int window_width = getmaxx(processesWin);
+    int current_selection, int scroll_offset, bool cgroupMode,
+    std::string_view highlight) {
+  Format::LineBuffer line;
+  // Without a command column the cgroup rows are not set apart
+  int commandColumn = column_positions[Columns::kCommand];
+  if (commandColumn < 0) commandColumn = processesWin.Width();
 
   for (int i = 0; i < max_rows; ++i) {
-    move(i, 0);
-    wclrtoeol(processesWin);
-    int process_index = scroll_offset + i;
-    if (process_index > (ssize_t)processes.size() - 1) {
+    int row_index = scroll_offset + i;
+    if (row_index > (ssize_t)rows.size() - 1) {
       break;
     }
-    if (process_index == current_selection) {
-      wattron(processesWin, COLOR_PAIR(ColorPairs::black_cyan_pair));
-    }
-
-    std::string pid = std::to_string(processes[process_index]->Pid());
-    printRightAligned(processesWin, i, column_positions[PID_INDEX],
-                      headers[PID_INDEX].size(), pid);
-
-    std::string user =
-        processes[process_index]->User().substr(0, headers[USER_INDEX].size());
-    printRightAligned(processesWin, i, column_positions[USER_INDEX],
-                      headers[USER_INDEX].size(), user);
-
-    std::string priority = std::to_string(processes[process_index]->PriorityValue());
-    printRightAligned(processesWin, i, column_positions[PRI_INDEX],
-                      headers[PRI_INDEX].size(), priority);
-
-    std::string nice = std::to_string(processes[process_index]->NiceValue());
-    printRightAligned(processesWin, i, column_positions[NI_INDEX],
-                      headers[NI_INDEX].size(), nice);
-
-    const struct ProcessMemUtilization &memUtilization = processes[process_index]->MemUtilization();
-    std::string virt_memory_str = convertMemoryToStr(memUtilization.virtual_mem, 0);
-    printRightAligned(processesWin, i, column_positions[VIRT_INDEX],
-                      headers[VIRT_INDEX].size(), virt_memory_str);
-
-    std::string res_memory_str = convertMemoryToStr(memUtilization.resident_mem, 0);
-    printRightAligned(processesWin, i, column_positions[RES_INDEX],
-                      headers[RES_INDEX].size(), res_memory_str);
-
-    std::string shr_memory_str = convertMemoryToStr(memUtilization.shared_mem, 0);
-    printRightAligned(processesWin, i, column_positions[SHR_INDEX],
-                      headers[SHR_INDEX].size(), shr_memory_str);
-
-    printRightAligned(processesWin, i, column_positions[S_INDEX],
-                      headers[S_INDEX].size(), std::string(1, processes[process_index]->State()));
-
-    float cpu_utilization_f =
-        truncateTo1Decimal(processes[process_index]->CpuUtilization());
-    std::string cpu_utilization =
-        to_string_with_precision<float>(cpu_utilization_f);
-    printRightAligned(processesWin, i, column_positions[CPU_INDEX],
-                      headers[CPU_INDEX].size(), cpu_utilization);
-
-    float mem_utilization_f = truncateTo1Decimal(((double)processes[process_index]->MemUtilization().resident_mem
-                                                 / memData.memTotal) * 100.0f);
-    std::string mem_utilization_str = to_string_with_precision<float>(mem_utilization_f);
-    printRightAligned(processesWin, i, column_positions[MEM_INDEX],
-                      headers[MEM_INDEX].size(), mem_utilization_str);
-
-    double uptime = processes[process_index]->UpTime();
-    std::string uptime_str = Format::ElapsedTime(uptime);
-    printRightAligned(processesWin, i, column_positions[TIME_INDEX],
-                      headers[TIME_INDEX].size(), uptime_str);
-
-    std::string command = processes[process_index]->Command().substr(
-        0, window_width - column_positions[COMMAND_INDEX]);
-    mvwprintw(processesWin, i, column_positions[COMMAND_INDEX], "%s",
-              command.c_str());
-
-    if (process_index == current_selection) {
-      for (int col = 0; col < getmaxx(processesWin); ++col) {
-        chtype ch = mvwinch(processesWin, i, col);
-        char character = ch & A_CHARTEXT;
-        if (character == ' ')
-          mvwaddch(processesWin, i, col, ' ');
+    attr_t attributes = A_NORMAL;
+    if (row_index == current_selection) {
+      // The selection bar spans the whole width
+      attributes = COLOR_PAIR(ColorPairs::black_cyan_pair);
+      processesWin.Fill(i, 0, processesWin.Width(), ' ' | attributes);
+    }
+
+    line.Reset(processesWin.Width());
+    const ListRow& row = rows[row_index];
+    if (row.cgroup != nullptr) {
+      displayCgroupRow(line, *row.cgroup, row.expanded, memData);
+      // The description of a cgroup stands out
+      processesWin.Print(i, 0, line.View().substr(0, commandColumn),
+                         attributes);
+      if (line.Width() > commandColumn) {
+        processesWin.Print(i, commandColumn,
+                           line.View().substr(commandColumn),
+                           attributes | A_BOLD);
+      }
+    } else {
+      displayProcessRow(line, *row.process, memData, cgroupMode ? 4 : 0);
+      processesWin.Print(i, 0, line.View(), attributes);
+      highlightFdUsage(processesWin, i, *row.process, memData);
+      if (!highlight.empty()) {
+        highlightMatches(processesWin, i, *row.process, cgroupMode ? 4 : 0,
+                         highlight);
       }
-      wattroff(processesWin, COLOR_PAIR(ColorPairs::black_cyan_pair));
     }
   }
 }
 
+static ColorPairs utilizationColor(float utilization) {
+  return (utilization < 0.5f)
+             ? ColorPairs::green_black_pair
+             : (utilization < 0.8f ? ColorPairs::yellow_black_pair
+                                   : ColorPairs::red_black_pair);
+}
+
+// Segments of the per-core bars: user, nice, system, irq, softirq, steal
+// and iowait, which add up to the busy share in the label
 static void drawSingleCpuBar(
-    WINDOW* upperPanel, int start_y, int start_x, int core_idx, int bar_length,
-    const std::vector<struct CPUDataWithHistory>& cpu_data) {
-  const struct CPUData& currCoreData = cpu_data[core_idx].current;
+    ShadowWindow& upperPanel, int start_y, int start_x, int core_idx, int bar_length,
+    const std::vector<float>& ratios, const std::vector<CpuBreakdown>& breakdown,
+    ColorPairs leftLabelCol = ColorPairs::cyan_black_pair) {
   std::vector<float> utilizationVec;
   std::vector<ColorPairs> colorPairsVec;
-  float utilization =
-      (1.0f - (double)(currCoreData.idletime) / currCoreData.totaltime);
-
-  if (cpu_data[core_idx].previous.has_value()) {
-    const struct CPUData& prevCoreData =
-        cpu_data[core_idx].previous.value();
-    uint64_t totaltime_delta = currCoreData.totaltime - prevCoreData.totaltime;
-    uint64_t idletime_delta = currCoreData.idletime - prevCoreData.idletime;
-    utilization = (1.0f - (double)(idletime_delta) / totaltime_delta);
-  }
+  float utilization = ratios[core_idx];
 
   std::string rightLabel = to_string_with_precision<float>(utilization * 100.0f) + "%";
 
-  utilizationVec.push_back(utilization);
-
-  // Set color based on utilization level
-  ColorPairs color_pair = (utilization < 0.5f)
-                       ? ColorPairs::green_black_pair
-                       : (utilization < 0.8f ? ColorPairs::yellow_black_pair
-                                             : ColorPairs::red_black_pair);
-  colorPairsVec.push_back(color_pair);
+  if (core_idx < (ssize_t)breakdown.size()) {
+    const CpuBreakdown& states = breakdown[core_idx];
+    utilizationVec = {states.user,    states.nice,  states.system, states.irq,
+                      states.softirq, states.steal, states.iowait};
+    colorPairsVec = {ColorPairs::green_black_pair, ColorPairs::blue_black_pair,
+                     ColorPairs::red_black_pair,   ColorPairs::yellow_black_pair,
+                     ColorPairs::magenta_black_pair, ColorPairs::cyan_black_pair,
+                     ColorPairs::white_black_pair};
+  } else {
+    utilizationVec.push_back(utilization);
+    // Set color based on utilization level
+    colorPairsVec.push_back(utilizationColor(utilization));
+  }
 
   std::string leftLabel = std::to_string(core_idx - 1);
   if (core_idx == 0) {
     leftLabel = "CPU";
   }
-  ColorPairs leftLabelCol = ColorPairs::cyan_black_pair;
   ColorPairs bracketsCol = ColorPairs::white_black_pair;
   ColorPairs rightLabelCol = ColorPairs::white_black_pair;
   Bar barToDraw(start_x, start_y, bar_length, leftLabel, rightLabel, colorPairsVec,
-                utilizationVec, upperPanel, bracketsCol, leftLabelCol, rightLabelCol);
+                utilizationVec, &upperPanel, bracketsCol, leftLabelCol, rightLabelCol);
   barToDraw.drawBar();
 }
 
-static void drawCpuBars(WINDOW* upperPanel, const std::vector<struct CPUDataWithHistory>& cpu_data) {
-  int window_width = getmaxx(upperPanel);
-  int num_cores = std::max((int)cpu_data.size() - 1, 1);
-  werase(upperPanel);
+// One cell per core (or per group of neighbouring cores when they do not fit,
+// showing the busiest one) in the rows of the bars, with the total and the
+// average of every NUMA node listed on the right. Cores busy mostly with
+// interrupts are magenta.
+static void drawCpuHeatmap(ShadowWindow& upperPanel,
+                           const std::vector<float>& ratios,
+                           const std::vector<CpuBreakdown>& breakdown,
+                           const std::vector<int>& cpuNodes) {
+  static const char ramp[] = SPARKLINE_RAMP;
+  const int levels = sizeof(ramp) - 2;
+  const int rows = UPPER_PANEL_BARS_PER_COLUMN;
+  const int num_cores = ratios.size() - 1;
+
+  // Average per node; cores the topology does not know are left out
+  int num_nodes = 0;
+  for (int i = 0; i < num_cores && i < (int)cpuNodes.size(); ++i) {
+    num_nodes = std::max(num_nodes, cpuNodes[i] + 1);
+  }
+  std::vector<float> nodeSums(num_nodes);
+  std::vector<int> nodeCores(num_nodes);
+  if (num_nodes > 1) {
+    for (int i = 0; i < num_cores && i < (int)cpuNodes.size(); ++i) {
+      if (cpuNodes[i] < 0) continue;
+      nodeSums[cpuNodes[i]] += ratios[i + 1];
+      nodeCores[cpuNodes[i]]++;
+    }
+  }
+
+  int entries = 1 + (num_nodes > 1 ? num_nodes : 0);
+  int summary_width = (entries + rows - 1) / rows * CPU_SUMMARY_WIDTH;
+  int summary_x = upperPanel.Width() - UPPER_PANEL_RIGHT_PADDING - summary_width;
+  char text[CPU_SUMMARY_WIDTH + 8];
+  for (int entry = 0; entry < entries; ++entry) {
+    int y = UPPER_PANEL_UP_PADDING + entry % rows;
+    int x = summary_x + entry / rows * CPU_SUMMARY_WIDTH;
+    int node = entry - 1;
+    float utilization = ratios[0];
+    if (node >= 0) {
+      utilization = nodeCores[node] ? nodeSums[node] / nodeCores[node] : 0.0f;
+      snprintf(text, sizeof(text), "N%d", node);
+    } else {
+      snprintf(text, sizeof(text), "CPU");
+    }
+    upperPanel.Print(y, x, text, COLOR_PAIR(ColorPairs::cyan_black_pair));
+    snprintf(text, sizeof(text), "%5.1f%%", utilization * 100.0f);
+    upperPanel.Print(y, x + CPU_SUMMARY_WIDTH - 7, text,
+                     COLOR_PAIR(utilizationColor(utilization)) | A_BOLD);
+  }
+
+  // Row labels are the number of the first core in the row
+  const int label_width = 4;
+  int grid_x = UPPER_PANEL_LEFT_PADDING - 2 + label_width + 1;
+  int grid_width = std::max(1, summary_x - 1 - grid_x);
+  int cores_per_cell = (num_cores + rows * grid_width - 1) / (rows * grid_width);
+  int cells = (num_cores + cores_per_cell - 1) / cores_per_cell;
+  int cells_per_row = (cells + rows - 1) / rows;
+
+  for (int cell = 0; cell < cells; ++cell) {
+    int row = cell / cells_per_row;
+    int col = cell % cells_per_row;
+    int first = cell * cores_per_cell;
+    if (col == 0) {
+      snprintf(text, sizeof(text), "%*d", label_width, first);
+      upperPanel.Print(UPPER_PANEL_UP_PADDING + row, grid_x - label_width - 1,
+                       text, COLOR_PAIR(ColorPairs::cyan_black_pair));
+    }
+    float utilization = 0.0f;
+    int busiest = first + 1;
+    for (int i = first; i < std::min(num_cores, first + cores_per_cell); ++i) {
+      if (ratios[i + 1] > utilization) {
+        utilization = ratios[i + 1];
+        busiest = i + 1;
+      }
+    }
+    utilization = std::clamp(utilization, 0.0f, 1.0f);
+    ColorPairs color = utilizationColor(utilization);
+    if (busiest < (int)breakdown.size() &&
+        breakdown[busiest].irq + breakdown[busiest].softirq >
+            utilization * 0.5f) {
+      color = ColorPairs::magenta_black_pair;
+    }
+    upperPanel.Fill(UPPER_PANEL_UP_PADDING + row, grid_x + col, 1,
+                    ramp[(int)std::lround(utilization * levels)] |
+                        COLOR_PAIR(color));
+  }
+}
+
+static void drawCpuBars(ShadowWindow& upperPanel, const std::vector<float>& ratios,
+                        const std::vector<CpuBreakdown>& breakdown,
+                        const std::vector<int>& cpuNodes) {
+  int window_width = upperPanel.Width();
+  int num_cores = std::max((int)ratios.size() - 1, 1);
+  if (num_cores > CPU_HEATMAP_THRESHOLD) {
+    drawCpuHeatmap(upperPanel, ratios, breakdown, cpuNodes);
+    return;
+  }
+
+  // Cores of a NUMA node fill columns of their own, lowest node first, with
+  // the labels of every other node in yellow; without NUMA this is the
+  // order of the cores
+  std::vector<std::vector<int>> columns;
+  std::vector<int> columnNodes;
+  int num_nodes = 0;
+  for (int i = 0; i < num_cores && i < (int)cpuNodes.size(); ++i) {
+    num_nodes = std::max(num_nodes, cpuNodes[i] + 1);
+  }
+  for (int node = (num_nodes > 1 ? 0 : -1); node < std::max(num_nodes, 1);
+       ++node) {
+    bool started = false;
+    for (int i = 0; i < num_cores; ++i) {
+      int core_node = i < (int)cpuNodes.size() ? cpuNodes[i] : -1;
+      // Cores of no known node go with node 0
+      if (node >= 0 && std::max(core_node, 0) != node) continue;
+      if (!started || columns.back().size() == UPPER_PANEL_BARS_PER_COLUMN) {
+        columns.emplace_back();
+        columnNodes.push_back(node);
+        started = true;
+      }
+      columns.back().push_back(i + 1);
+    }
+  }
 
   // calculate number of columns (independent of window width)
-  int num_columns = std::max(1, (num_cores + UPPER_PANEL_BARS_PER_COLUMN - 1) /
-                                    UPPER_PANEL_BARS_PER_COLUMN);
+  int num_columns = std::max<int>(1, columns.size());
   if (num_cores == 1) {
     int bar_width =
         std::max(MIN_UPPER_PANEL_BAR_WIDTH + PADDING_BETWEEN_BARS,
@@ -344,14 +538,16 @@ static void drawCpuBars(WINDOW* upperPanel, const std::vector<struct CPUDataWith
     int curr_start_x = UPPER_PANEL_LEFT_PADDING - 2;
     int curr_start_y = UPPER_PANEL_UP_PADDING + 2;
     drawSingleCpuBar(upperPanel, curr_start_y, curr_start_x, 0,
-                     bar_width - PADDING_BETWEEN_BARS, cpu_data);
+                     bar_width - PADDING_BETWEEN_BARS, ratios, breakdown);
   } else {
     for (int curr_col = 0; curr_col < num_columns; ++curr_col) {
-      for (int curr_row = 0; curr_row < UPPER_PANEL_BARS_PER_COLUMN;
+      ColorPairs labelColor = columnNodes[curr_col] % 2 == 1
+                                  ? ColorPairs::yellow_black_pair
+                                  : ColorPairs::cyan_black_pair;
+      for (int curr_row = 0; curr_row < (int)columns[curr_col].size();
            ++curr_row) {
-        int curr_core_idx =
-            curr_col * UPPER_PANEL_BARS_PER_COLUMN + curr_row + 1;
-        if (curr_core_idx > (ssize_t)cpu_data.size() - 1) {
+        int curr_core_idx = columns[curr_col][curr_row];
+        if (curr_core_idx > (ssize_t)ratios.size() - 1) {
           break;
         }
         int bar_width =
@@ -362,7 +558,8 @@ static void drawCpuBars(WINDOW* upperPanel, const std::vector<struct CPUDataWith
         int curr_start_x = bar_width * curr_col + UPPER_PANEL_LEFT_PADDING;
         int curr_start_y = curr_row + UPPER_PANEL_UP_PADDING;
         drawSingleCpuBar(upperPanel, curr_start_y, curr_start_x, curr_core_idx,
-                         bar_width - PADDING_BETWEEN_BARS, cpu_data);
+                         bar_width - PADDING_BETWEEN_BARS, ratios, breakdown,
+                         labelColor);
       }
     }
   }
@@ -389,10 +586,10 @@ static std::string swapUtilizationStr(const struct MemData& mem_data) {
   return swapStr;
 }
 
-static void drawMemUtilization(WINDOW* upperPanel,
+static void drawMemUtilization(ShadowWindow& upperPanel,
                                const struct MemData& mem_data) {
   /* Draw memory utilization bar */
-  int window_width = getmaxx(upperPanel);
+  int window_width = upperPanel.Width();
   std::string bar_label = "Mem";
   std::string mem_utilization_str = memoryUtilizationStr(mem_data);
   int bar_width = std::max(
@@ -417,7 +614,7 @@ static void drawMemUtilization(WINDOW* upperPanel,
                                            ColorPairs::yellow_black_pair};
   std::vector<float> ratiosVec = {non_cache_buffer_mem_r, buffers_mem_r, cached_mem_r};
   Bar memBar(start_x, start_y, bar_width, bar_label, mem_utilization_str,
-             colorPairsVec, ratiosVec, upperPanel);
+             colorPairsVec, ratiosVec, &upperPanel);
   memBar.drawBar();
 
   /* Draw Swp Utilization bar */
@@ -430,10 +627,232 @@ static void drawMemUtilization(WINDOW* upperPanel,
   float swap_used_r = (double)(swap_used) / swap_total;
   ratiosVec = {swap_used_r};
   Bar swpBar(start_x, start_y, bar_width, bar_label, swap_utilization_str,
-             colorPairsVec, ratiosVec, upperPanel);
+             colorPairsVec, ratiosVec, &upperPanel);
   swpBar.drawBar();
 }
 
+// One row graph of the newest samples of `series` over `scale`, newest on
+// the right, framed like a Bar of the same width
+static void drawSparkline(ShadowWindow& upperPanel, int start_y, int start_x,
+                          int width, std::string_view label,
+                          const HistorySeries& series, float scale,
+                          std::string_view rightLabel) {
+  int graph_x = start_x + label.size() + 1;
+  int graph_width = width - 3 - (int)label.size() - (int)rightLabel.size();
+  if (graph_width <= 0) return;
+
+  upperPanel.Print(start_y, start_x, label,
+                   COLOR_PAIR(ColorPairs::cyan_black_pair));
+  upperPanel.Print(start_y, graph_x - 1, "[",
+                   COLOR_PAIR(ColorPairs::white_black_pair) | A_BOLD);
+
+  static const char ramp[] = SPARKLINE_RAMP;
+  const int levels = sizeof(ramp) - 2;
+  int samples = std::min<int>(graph_width, series.Size());
+  int first = series.Size() - samples;
+  for (int i = 0; i < samples; ++i) {
+    float ratio = std::clamp(series[first + i] / scale, 0.0f, 1.0f);
+    upperPanel.Fill(start_y, graph_x + graph_width - samples + i, 1,
+                    ramp[(int)std::lround(ratio * levels)] |
+                        COLOR_PAIR(utilizationColor(ratio)));
+  }
+
+  upperPanel.Print(start_y, start_x + width - 1 - rightLabel.size(),
+                   rightLabel,
+                   COLOR_PAIR(ColorPairs::white_black_pair) | A_BOLD);
+  upperPanel.Print(start_y, start_x + width - 1, "]",
+                   COLOR_PAIR(ColorPairs::white_black_pair) | A_BOLD);
+}
+
+// CPU, memory and swap trends below the Mem and Swp bars
+static void drawHistory(ShadowWindow& upperPanel, const SampleHistory& history) {
+  if (history.NumCpus() == 0) return;
+  int window_width = upperPanel.Width();
+  int width = std::max(
+      MIN_UPPER_PANEL_BAR_WIDTH + PADDING_BETWEEN_BARS,
+      (window_width - UPPER_PANEL_LEFT_PADDING - UPPER_PANEL_RIGHT_PADDING) /
+          2);
+  int start_y = UPPER_PANEL_UP_PADDING + UPPER_PANEL_BARS_PER_COLUMN + 2;
+  int start_x = UPPER_PANEL_LEFT_PADDING - 2;
+
+  char label[16];
+  char* const labelLast = label + sizeof(label) - 1;
+  const HistorySeries* series[] = {&history.Cpu(0), &history.MemUsed(),
+                                   &history.Swap()};
+  const char* names[] = {"CPU", "Mem", "Swp"};
+  for (int i = 0; i < 3; ++i) {
+    if (series[i]->Size() == 0) continue;
+    char* end = Format::Tenths(label, labelLast, series[i]->Back() * 100.0f);
+    *end++ = '%';
+    drawSparkline(upperPanel, start_y + i, start_x, width, names[i],
+                  *series[i], 1.0f, std::string_view(label, end - label));
+  }
+}
+
+// "12.3M/s", bytes per second shown in the units of the memory values
+static char* formatByteRate(char* first, char* last, double bytes) {
+  first = Format::Memory(first, last, (uint64_t)std::llround(bytes / 1024));
+  if (last - first >= 2) {
+    *first++ = '/';
+    *first++ = 's';
+  }
+  return first;
+}
+
+// Below the history: the stall share of the last intervals for CPU, memory
+// and I/O, and the kernel's 10s averages of "some" and "full" stalls
+static void drawPressure(ShadowWindow& upperPanel, const PressureStats& stats,
+                         const SampleHistory* history, int y) {
+  int window_width = upperPanel.Width();
+  int start_x = UPPER_PANEL_LEFT_PADDING - 2;
+  int width = std::max(MIN_UPPER_PANEL_BAR_WIDTH + PADDING_BETWEEN_BARS,
+                       (window_width - UPPER_PANEL_LEFT_PADDING -
+                        UPPER_PANEL_RIGHT_PADDING) /
+                           2);
+  const char* names[] = {"cpu", "mem", "io"};
+
+  if (history != nullptr) {
+    char label[16];
+    char* const labelLast = label + sizeof(label) - 1;
+    int graph_width = width / LinuxParser::PSI_NUM_RESOURCES;
+    for (int resource = 0; resource < LinuxParser::PSI_NUM_RESOURCES;
+         ++resource) {
+      const HistorySeries& series = history->Pressure(resource);
+      if (series.Size() == 0) continue;
+      float scale = PSI_MIN_SCALE;
+      for (size_t i = 0; i < series.Size(); ++i) {
+        scale = std::max(scale, series[i]);
+      }
+      char* end = Format::Tenths(label, labelLast, series.Back());
+      *end++ = '%';
+      drawSparkline(upperPanel, y, start_x + resource * graph_width,
+                    graph_width - (resource + 1 < LinuxParser::PSI_NUM_RESOURCES),
+                    names[resource], series, scale,
+                    std::string_view(label, end - label));
+    }
+  }
+
+  char text[128];
+  int len = snprintf(text, sizeof(text), "PSI avg10");
+  for (int resource = 0; resource < LinuxParser::PSI_NUM_RESOURCES;
+       ++resource) {
+    const LinuxParser::psiFileData& file =
+        stats.File((LinuxParser::PsiResource)resource);
+    len += snprintf(text + len, sizeof(text) - len, " %s %.1f/%.1f",
+                    names[resource], file.some.avg10, file.full.avg10);
+  }
+  snprintf(text + len, sizeof(text) - len, " (some/full)");
+  upperPanel.Print(y, window_width / 2, text,
+                   COLOR_PAIR(ColorPairs::cyan_black_pair));
+}
+
+// A utilization bar per disk below the history, the busiest ones when there
+// are more disks than rows, with IOPS, throughput, average latency and queue
+// depth on the right
+static void drawDiskBars(ShadowWindow& upperPanel, const DiskStats& stats,
+                         int first_row) {
+  int rows = upperPanel.Height() - first_row;
+  std::vector<const Disk*> disks;
+  for (const Disk& disk : stats.Disks()) disks.push_back(&disk);
+  if ((int)disks.size() > rows) {
+    std::partial_sort(disks.begin(), disks.begin() + rows, disks.end(),
+                      [](const Disk* l, const Disk* r) {
+                        return l->rates.utilization > r->rates.utilization;
+                      });
+    disks.resize(std::max(0, rows));
+  }
+  // Shown in the order of /proc/diskstats, so rows only move when the
+  // busiest disks change
+  std::sort(disks.begin(), disks.end());
+
+  int label_width = 3;
+  for (const Disk* disk : disks) {
+    label_width = std::max<int>(label_width, strlen(disk->counters.name));
+  }
+  label_width = std::min(label_width, DISK_MAX_LABEL);
+
+  // Ends where the Mem bar and the sparklines end
+  int window_width = upperPanel.Width();
+  int bar_end = UPPER_PANEL_LEFT_PADDING - 2 +
+                std::max(MIN_UPPER_PANEL_BAR_WIDTH + PADDING_BETWEEN_BARS,
+                         (window_width - UPPER_PANEL_LEFT_PADDING -
+                          UPPER_PANEL_RIGHT_PADDING) /
+                             2);
+  int start_x = std::max(0, UPPER_PANEL_LEFT_PADDING + 1 - label_width);
+
+  char text[160];
+  char read[32];
+  char write[32];
+  for (size_t i = 0; i < disks.size(); ++i) {
+    const Disk& disk = *disks[i];
+    const DiskRates& rates = disk.rates;
+    int y = first_row + i;
+
+    std::string_view name(disk.counters.name);
+    std::string label(label_width - std::min<int>(name.size(), label_width),
+                      ' ');
+    label.append(name.substr(0, label_width));
+    std::string rightLabel =
+        to_string_with_precision<float>(rates.utilization * 100.0f) + "%";
+    std::vector<ColorPairs> colorPairsVec = {
+        utilizationColor(rates.utilization)};
+    std::vector<float> ratiosVec = {(float)rates.utilization};
+    Bar diskBar(start_x, y, bar_end - start_x, label, rightLabel,
+                colorPairsVec, ratiosVec, &upperPanel);
+    diskBar.drawBar();
+
+    *formatByteRate(read, read + sizeof(read) - 1, rates.readBytes) = '\0';
+    *formatByteRate(write, write + sizeof(write) - 1, rates.writeBytes) = '\0';
+    snprintf(text, sizeof(text),
+             "r %.0f/s %s %.1fms  w %.0f/s %s %.1fms  queue %.2f",
+             rates.readIops, read, rates.readLatencyMs, rates.writeIops, write,
+             rates.writeLatencyMs, rates.queueDepth);
+    upperPanel.Print(y, window_width / 2, text,
+                     COLOR_PAIR(ColorPairs::cyan_black_pair));
+  }
+}
+
+// One bar per NUMA node side by side: the memory the node has in use
+static void drawNumaMemory(ShadowWindow& upperPanel,
+                           const std::vector<LinuxParser::numaNodeData>& nodes,
+                           int y) {
+  int width = upperPanel.Width() - UPPER_PANEL_LEFT_PADDING -
+              UPPER_PANEL_RIGHT_PADDING;
+  int bar_width = std::max(MIN_UPPER_PANEL_BAR_WIDTH + PADDING_BETWEEN_BARS,
+                           width / std::max<int>(1, nodes.size()));
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const LinuxParser::numaNodeData& node = nodes[i];
+    int start_x = UPPER_PANEL_LEFT_PADDING - 2 + bar_width * i;
+    if (start_x + bar_width > upperPanel.Width()) break;
+    std::string label = "N" + std::to_string(node.node);
+    std::string rightLabel = convertMemoryToStr(node.memUsed) + "/" +
+                             convertMemoryToStr(node.memTotal);
+    float used = node.memTotal ? (double)node.memUsed / node.memTotal : 0.0f;
+    std::vector<ColorPairs> colorPairsVec = {ColorPairs::green_black_pair};
+    std::vector<float> ratiosVec = {used};
+    Bar nodeBar(start_x, y, bar_width - PADDING_BETWEEN_BARS, label, rightLabel,
+                colorPairsVec, ratiosVec, &upperPanel);
+    nodeBar.drawBar();
+  }
+}
+
+// What the monitor costs, with the policy it runs under, in low impact mode
+static void drawSelfStats(ShadowWindow& upperPanel, const SelfStats& stats,
+                          int y) {
+  const LinuxParser::selfUsageData& usage = stats.Usage();
+  char text[192];
+  snprintf(text, sizeof(text),
+           "monitor: cpu %.1f%% (%.2f s)  ctxsw %.0f/s (%llu vol, %llu invol)"
+           "  rss %s  %u threads  [%s]",
+           stats.CpuPercent(), usage.cpuUs / 1e6, stats.ContextSwitchRate(),
+           (unsigned long long)usage.voluntaryCtxtSwitches,
+           (unsigned long long)usage.nonvoluntaryCtxtSwitches,
+           convertMemoryToStr(usage.residentKb).c_str(), usage.numThreads,
+           LowImpact::Describe().c_str());
+  upperPanel.Print(y, UPPER_PANEL_LEFT_PADDING - 2, text,
+                   COLOR_PAIR(ColorPairs::yellow_black_pair));
+}
+
 static void initColors() {
   init_pair(static_cast<short>(ColorPairs::black_green_pair),
             COLOR_BLACK, COLOR_GREEN);
@@ -451,25 +870,327 @@ static void initColors() {
             COLOR_RED, COLOR_BLACK);
   init_pair(static_cast<short>(ColorPairs::black_cyan_pair),
             COLOR_BLACK, COLOR_CYAN);
+  init_pair(static_cast<short>(ColorPairs::black_yellow_pair),
+            COLOR_BLACK, COLOR_YELLOW);
+  init_pair(static_cast<short>(ColorPairs::magenta_black_pair),
+            COLOR_MAGENTA, COLOR_BLACK);
 }
 
-static void drawGlobalSystemStats(WINDOW *upperPanel, System& system) {
-  int window_width = getmaxx(upperPanel);
+static void drawGlobalSystemStats(ShadowWindow& upperPanel, DataSource& system) {
+  int window_width = upperPanel.Width();
   int start_y = UPPER_PANEL_UP_PADDING + UPPER_PANEL_BARS_PER_COLUMN;
   int start_x = window_width / 2;
-  unsigned int numTasks = system.processManager.getNumOfTasks();
-  unsigned int numThreads = system.processManager.getNumOfThreads();
-  unsigned int numRunning = system.processManager.getNumOfRunningTasks();
+  unsigned int numTasks = system.getNumOfTasks();
+  unsigned int numThreads = system.getNumOfThreads();
+  unsigned int numRunning = system.getNumOfRunningTasks();
+
+  std::string status = system.StatusText();
+  if (!status.empty()) {
+    upperPanel.Print(0, UPPER_PANEL_LEFT_PADDING, status,
+                     COLOR_PAIR(ColorPairs::yellow_black_pair) | A_BOLD);
+  }
 
-  wattron(upperPanel, COLOR_PAIR(ColorPairs::cyan_black_pair));
-  mvwprintw(upperPanel, start_y, start_x, "%s", ("OS: " + system.OperatingSystem()).c_str());
-  mvwprintw(upperPanel, start_y + 1, start_x, "%s", ("Kernel: " + system.Kernel()).c_str());
-  mvwprintw(upperPanel, start_y + 2, start_x, "Tasks: %u, %u thr; %u running", numTasks, numThreads - numTasks,
-            numRunning);
-  mvwprintw(upperPanel, start_y + 3, start_x, "Load average: %s", System::LoadAverage().c_str());
-  mvwprintw(upperPanel, start_y + 4, start_x, "Uptime: %s",
-           Format::FormatUptime(System::UpTime()).c_str());
-  wattroff(upperPanel, COLOR_PAIR(ColorPairs::cyan_black_pair));
+  attr_t attributes = COLOR_PAIR(ColorPairs::cyan_black_pair);
+  char tasks[96];
+  snprintf(tasks, sizeof(tasks), "Tasks: %u, %u thr; %u running", numTasks,
+           numThreads - numTasks, numRunning);
+  upperPanel.Print(start_y, start_x, "OS: " + system.OperatingSystem(),
+                   attributes);
+  upperPanel.Print(start_y + 1, start_x, "Kernel: " + system.Kernel(),
+                   attributes);
+  upperPanel.Print(start_y + 2, start_x, tasks, attributes);
+  std::string load = "Load average: " + system.LoadAverage();
+  upperPanel.Print(start_y + 3, start_x, load, attributes);
+  const SampleHistory* history = system.History();
+  if (history && history->Load(0).Size() > 0) {
+    // The 1 minute load trend, full scale at one runnable task per CPU
+    const HistorySeries& series = history->Load(0);
+    float scale = std::max<float>(1, history->NumCpus() - 1);
+    for (size_t i = 0; i < series.Size(); ++i) {
+      scale = std::max(scale, series[i]);
+    }
+    int graph_x = start_x + load.size() + 1;
+    drawSparkline(upperPanel, start_y + 3, graph_x,
+                  window_width - UPPER_PANEL_RIGHT_PADDING - graph_x, "",
+                  series, scale, "");
+  }
+  upperPanel.Print(start_y + 4, start_x,
+                   "Uptime: " + Format::FormatUptime(system.UpTime()),
+                   attributes);
+}
+
+// Columns of the network view after the interface name
+static constexpr std::string_view kNetworkHeaders[] = {
+    "   RX/s", "   TX/s", "RXpkt/s", "TXpkt/s",
+    "RXdrp/s", "TXdrp/s", "RXerr/s", "TXerr/s"};
+
+static const char* networkFilterName(NetFilter filter) {
+  switch (filter) {
+    case NetFilter::PHYSICAL: return "physical";
+    case NetFilter::EXTERNAL: return "all but loopback";
+    case NetFilter::ALL: return "all";
+  }
+  return "";
+}
+
+static void displayNetworkHeader(ShadowWindow& headerWindow) {
+  attr_t attributes = COLOR_PAIR(ColorPairs::black_green_pair);
+  headerWindow.Fill(0, 0, headerWindow.Width(), ' ' | attributes);
+  headerWindow.Print(0, 0, "IFACE", attributes);
+  int x = NETWORK_NAME_WIDTH;
+  for (std::string_view header : kNetworkHeaders) {
+    headerWindow.Print(0, x, header, attributes);
+    x += header.size() + UPPER_PANEL_SPACING_BETWEEN_COLUMNS;
+  }
+}
+
+// Formats an interface, or the total, into `line` without allocating
+static void displayNetworkRow(Format::LineBuffer& line, std::string_view name,
+                              const NetRates& rates) {
+  char field[32];
+  char* const fieldLast = field + sizeof(field);
+  const double values[] = {rates.rxBytes,   rates.txBytes, rates.rxPackets,
+                           rates.txPackets, rates.rxDrops, rates.txDrops,
+                           rates.rxErrors,  rates.txErrors};
+
+  line.Write(0, name.substr(0, NETWORK_NAME_WIDTH - 1));
+  int x = NETWORK_NAME_WIDTH;
+  for (size_t i = 0; i < std::size(kNetworkHeaders); ++i) {
+    int width = kNetworkHeaders[i].size();
+    char* end = i < 2 ? Format::Memory(field, fieldLast,
+                                       (uint64_t)std::llround(values[i] / 1024))
+                      : Format::Integer(field, fieldLast,
+                                        std::llround(values[i]));
+    line.WriteRight(x, width, std::string_view(field, end - field));
+    x += width + UPPER_PANEL_SPACING_BETWEEN_COLUMNS;
+  }
+}
+
+// Throughput trend scaled to its peak, the newest rate on the right
+static void drawThroughput(ShadowWindow& window, int y, int x, int width,
+                           std::string_view label,
+                           const HistorySeries& series) {
+  if (series.Size() == 0) return;
+  float scale = NETWORK_MIN_SCALE;
+  for (size_t i = 0; i < series.Size(); ++i) {
+    scale = std::max(scale, series[i]);
+  }
+  char rate[32];
+  char* end = formatByteRate(rate, rate + sizeof(rate), series.Back());
+  drawSparkline(window, y, x, width, label, series, scale,
+                std::string_view(rate, end - rate));
+}
+
+// Replaces the process list: the RX/TX trend of the totals, the totals of
+// the interfaces `filter` admits and those interfaces, busiest first
+static void displayNetwork(ShadowWindow& window, const NetworkStats& network,
+                           const SampleHistory* history, NetFilter filter,
+                           int& scroll_offset) {
+  int width = window.Width();
+  if (history != nullptr) {
+    int half = width / 2;
+    drawThroughput(window, 0, 0, half - 1, "RX", history->NetRx());
+    drawThroughput(window, 0, half, width - half, "TX", history->NetTx());
+  }
+
+  std::vector<const NetInterface*> interfaces;
+  for (const NetInterface& interface : network.Interfaces()) {
+    if (NetworkStats::Admits(filter, interface)) {
+      interfaces.push_back(&interface);
+    }
+  }
+  std::sort(interfaces.begin(), interfaces.end(),
+            [](const NetInterface* l, const NetInterface* r) {
+              double left = l->rates.rxBytes + l->rates.txBytes;
+              double right = r->rates.rxBytes + r->rates.txBytes;
+              if (left != right) return left > right;
+              return strcmp(l->counters.name, r->counters.name) < 0;
+            });
+
+  char summary[128];
+  snprintf(summary, sizeof(summary),
+           "%zu of %zu interfaces: %s (v: change)", interfaces.size(),
+           network.Interfaces().size(), networkFilterName(filter));
+  window.Print(1, 0, summary, COLOR_PAIR(ColorPairs::cyan_black_pair));
+
+  Format::LineBuffer line;
+  line.Reset(width);
+  displayNetworkRow(line, "total", network.Total(filter));
+  window.Print(2, 0, line.View(), A_BOLD);
+
+  int rows = std::max(0, window.Height() - 3);
+  scroll_offset = std::clamp(scroll_offset, 0,
+                             std::max(0, (int)interfaces.size() - rows));
+  for (int i = 0; i < rows; ++i) {
+    size_t index = scroll_offset + i;
+    if (index >= interfaces.size()) break;
+    line.Reset(width);
+    displayNetworkRow(line, interfaces[index]->counters.name,
+                      interfaces[index]->rates);
+    window.Print(3 + i, 0, line.View(), A_NORMAL);
+  }
+}
+
+// Columns of the interrupt view after the name and device; the per-CPU
+// rates follow
+static constexpr std::string_view kInterruptHeaders[] = {"TOTAL/s", "  TOP",
+                                                         "SHARE"};
+
+// The CPU columns are labelled with their ids, which skip offline CPUs
+static void displayInterruptHeader(ShadowWindow& headerWindow,
+                                   const std::vector<int>& cpus) {
+  attr_t attributes = COLOR_PAIR(ColorPairs::black_green_pair);
+  headerWindow.Fill(0, 0, headerWindow.Width(), ' ' | attributes);
+  headerWindow.Print(0, 0, "IRQ", attributes);
+  headerWindow.Print(0, IRQ_NAME_WIDTH, "DEVICE", attributes);
+  int x = IRQ_NAME_WIDTH + IRQ_DESCRIPTION_WIDTH;
+  for (std::string_view header : kInterruptHeaders) {
+    headerWindow.Print(0, x, header, attributes);
+    x += header.size() + UPPER_PANEL_SPACING_BETWEEN_COLUMNS;
+  }
+  char label[16];
+  for (size_t column = 0;
+       column < cpus.size() && x + IRQ_CPU_WIDTH <= headerWindow.Width();
+       ++column) {
+    int len = snprintf(label, sizeof(label), "CPU%d", cpus[column]);
+    headerWindow.Print(0, x + IRQ_CPU_WIDTH - len, label, attributes);
+    x += IRQ_CPU_WIDTH;
+  }
+}
+
+// Formats a source into `line` without allocating
+static void displayInterruptRow(Format::LineBuffer& line,
+                                const InterruptSource& source,
+                                const double* cpuRates, int numCpus) {
+  char field[32];
+  char* const fieldLast = field + sizeof(field);
+
+  line.Write(0, std::string_view(source.line.name).substr(0, IRQ_NAME_WIDTH - 1));
+  line.Write(IRQ_NAME_WIDTH, std::string_view(source.line.description)
+                                 .substr(0, IRQ_DESCRIPTION_WIDTH - 1));
+  int x = IRQ_NAME_WIDTH + IRQ_DESCRIPTION_WIDTH;
+  int width = kInterruptHeaders[0].size();
+  char* end = Format::Integer(field, fieldLast, std::llround(source.rate));
+  line.WriteRight(x, width, std::string_view(field, end - field));
+  x += width + UPPER_PANEL_SPACING_BETWEEN_COLUMNS;
+  width = kInterruptHeaders[1].size();
+  if (source.topShare > 0) {
+    int len = snprintf(field, sizeof(field), "%d", source.topCpu);
+    line.WriteRight(x, width, std::string_view(field, len));
+  }
+  x += width + UPPER_PANEL_SPACING_BETWEEN_COLUMNS;
+  width = kInterruptHeaders[2].size();
+  if (source.topShare > 0) {
+    end = Format::Tenths(field, fieldLast, source.topShare * 100.0f);
+    line.WriteRight(x, width, std::string_view(field, end - field));
+  }
+  x += width + UPPER_PANEL_SPACING_BETWEEN_COLUMNS;
+  for (int cpu = 0; cpu < numCpus && x + IRQ_CPU_WIDTH <= line.Width(); ++cpu) {
+    end = Format::Integer(field, fieldLast, std::llround(cpuRates[cpu]));
+    line.WriteRight(x, IRQ_CPU_WIDTH, std::string_view(field, end - field));
+    x += IRQ_CPU_WIDTH;
+  }
+}
+
+// Replaces the process list: the interrupt and softirq sources that fired
+// in the last interval, busiest first, with their rate on every CPU. Sources
+// a single CPU handles nearly all of stand out on multi-CPU systems.
+static void displayInterrupts(ShadowWindow& window,
+                              const InterruptStats& interrupts,
+                              int& scroll_offset) {
+  int width = window.Width();
+  int numCpus = interrupts.NumCpus();
+  const auto& sources = interrupts.Sources();
+  if (!interrupts.HasRates()) {
+    window.Print(0, 0, "sampling /proc/interrupts and /proc/softirqs...",
+                 COLOR_PAIR(ColorPairs::cyan_black_pair));
+    return;
+  }
+
+  std::vector<size_t> active;
+  size_t hot = 0;
+  double total = 0;
+  for (size_t i = 0; i < sources.size(); ++i) {
+    const InterruptSource& source = sources[i];
+    if (source.rate <= 0) continue;
+    active.push_back(i);
+    total += source.rate;
+    if (numCpus > 1 && source.rate >= IRQ_HOT_RATE &&
+        source.topShare >= IRQ_CONCENTRATED_SHARE) {
+      hot++;
+    }
+  }
+  std::sort(active.begin(), active.end(), [&](size_t l, size_t r) {
+    if (sources[l].rate != sources[r].rate) {
+      return sources[l].rate > sources[r].rate;
+    }
+    return l < r;
+  });
+
+  char summary[160];
+  snprintf(summary, sizeof(summary),
+           "%zu of %zu sources active, %.0f/s on %d CPUs, %zu concentrated "
+           "on one CPU (i: back)",
+           active.size(), sources.size(), total, numCpus, hot);
+  window.Print(0, 0, summary, COLOR_PAIR(ColorPairs::cyan_black_pair));
+
+  Format::LineBuffer line;
+  int rows = std::max(0, window.Height() - 1);
+  scroll_offset = std::clamp(scroll_offset, 0,
+                             std::max(0, (int)active.size() - rows));
+  for (int i = 0; i < rows; ++i) {
+    size_t index = scroll_offset + i;
+    if (index >= active.size()) break;
+    const InterruptSource& source = sources[active[index]];
+    line.Reset(width);
+    displayInterruptRow(line, source, interrupts.CpuRates(active[index]),
+                        numCpus);
+    attr_t attributes = A_NORMAL;
+    if (numCpus > 1 && source.rate >= IRQ_HOT_RATE &&
+        source.topShare >= IRQ_CONCENTRATED_SHARE) {
+      attributes = COLOR_PAIR(ColorPairs::red_black_pair) | A_BOLD;
+    } else if (source.softirq) {
+      attributes = COLOR_PAIR(ColorPairs::magenta_black_pair);
+    }
+    window.Print(1 + i, 0, line.View(), attributes);
+  }
+}
+
+// Off-screen copies of the windows the UI is made of
+struct Screen {
+  ShadowWindow upperPanel;
+  ShadowWindow header;
+  ShadowWindow processesList;
+  ShadowWindow footer;  // filter prompt
+};
+
+// Cost of the previous frame, shown with 'S'
+struct RenderStats {
+  double buildMs = 0;
+  size_t cellsWritten = 0;
+  long long bytesWritten = 0;
+};
+
+// Bytes this thread has passed to write(), i.e. what curses sent to the
+// terminal
+static long long threadBytesWritten() {
+  char buffer[512];
+  int fd = open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return 0;
+  ssize_t len = read(fd, buffer, sizeof(buffer) - 1);
+  close(fd);
+  if (len <= 0) return 0;
+  buffer[len] = '\0';
+  const char* wchar = strstr(buffer, "wchar:");
+  return wchar ? atoll(wchar + 6) : 0;
+}
+
+static void drawRenderStats(ShadowWindow& upperPanel, const RenderStats& stats) {
+  char text[96];
+  int len = snprintf(text, sizeof(text), "frame %.2f ms, %zu cells, %lld B",
+                     stats.buildMs, stats.cellsWritten, stats.bytesWritten);
+  upperPanel.Print(0, upperPanel.Width() - UPPER_PANEL_RIGHT_PADDING - len,
+                   text, COLOR_PAIR(ColorPairs::yellow_black_pair));
 }
 
 struct DisplayState {
@@ -477,10 +1198,190 @@ struct DisplayState {
   int current_selection = 0;
   int scroll_offset = 0;
   std::vector<std::shared_ptr<Process>> processes;
+  std::vector<ListRow> rows;
   int numProcessesToDisplay = 0;
   bool running = true;
+  // Notified when running goes false, so that the redraw timer does not
+  // sleep out its interval
+  std::condition_variable stopped;
+  // The first frame is up while the data source takes its first process
+  // samples; nothing else reads the data source until they are in
+  bool priming = false;
+  bool cgroupMode = false;
+  std::unordered_set<std::string> expandedCgroups;
+  int sortColumn = Columns::kCpu;  // the order GetSortedProcesses() has
+  CpuUsage cpuUsage;
+  std::vector<int> cpuNodes;  // NUMA node of every core, read once
+  bool showRenderStats = false;
+  RenderStats renderStats;
+  // The monitor's own footprint, shown in low impact mode
+  SelfStats selfStats;
+  // What the selection points at, so it survives re-sorting
+  pid_t selectedPid = -1;
+  bool cgroupSelected = false;
+  std::string selectedCgroup;
+  // Digits typed to jump to a PID
+  std::string pidQuery;
+  std::chrono::steady_clock::time_point lastPidKey;
+  // '/' filter: the list only shows processes whose user or command contain
+  // the query; `filterStale` is set when a new sample replaced the processes
+  bool filterInput = false;
+  std::string filterQuery;
+  ProcessFilter filter;
+  bool filterStale = true;
+  size_t filterMatches = 0;
+  // 'n' shows the network interfaces instead of the processes
+  bool networkMode = false;
+  NetFilter networkFilter = NetFilter::PHYSICAL;
+  int networkScroll = 0;
+  // 'i' shows the interrupt and softirq rates per CPU instead
+  bool interruptMode = false;
+  int interruptScroll = 0;
+  // 'K' lists kernel threads too
+  bool showKernelThreads = false;
+  // Enter on a process shows all of its command line over the list
+  bool detailOpen = false;
+  pid_t detailPid = -1;
+  std::string detailTitle;
+  std::string detailCommand;
+  int detailScroll = 0;
+  // 'N' shows on which NUMA nodes the memory of the selected process is
+  bool showNumaMaps = false;
+  pid_t numaPid = -1;
+  bool numaValid = false;
+  std::vector<uint64_t> numaKb;
+  std::chrono::steady_clock::time_point numaRead;
 };
 
+static void rememberSelection(DisplayState& state) {
+  state.selectedPid = -1;
+  state.cgroupSelected = false;
+  state.selectedCgroup.clear();
+  if (state.current_selection >= (ssize_t)state.rows.size()) return;
+  const ListRow& row = state.rows[state.current_selection];
+  if (row.cgroup != nullptr) {
+    state.cgroupSelected = true;
+    state.selectedCgroup = row.cgroup->path;
+  } else {
+    state.selectedPid = row.process->Pid();
+  }
+}
+
+// Selects `target` (clamped) and scrolls as little as possible to show it
+static void moveSelection(DisplayState& state, int target) {
+  int last = std::max(0, (int)state.rows.size() - 1);
+  state.current_selection = std::clamp(target, 0, last);
+  if (state.current_selection < state.scroll_offset) {
+    state.scroll_offset = state.current_selection;
+  } else if (state.current_selection >=
+             state.scroll_offset + state.numProcessesToDisplay) {
+    state.scroll_offset =
+        state.current_selection - state.numProcessesToDisplay + 1;
+  }
+  rememberSelection(state);
+}
+
+// After the rows were rebuilt: finds the remembered row again and keeps it
+// on the same screen line
+static void restoreSelection(DisplayState& state) {
+  int screenLine = std::clamp(state.current_selection - state.scroll_offset,
+                              0, std::max(0, state.numProcessesToDisplay - 1));
+  for (size_t i = 0; i < state.rows.size(); ++i) {
+    const ListRow& row = state.rows[i];
+    bool match = row.cgroup != nullptr
+                     ? state.cgroupSelected &&
+                           row.cgroup->path == state.selectedCgroup
+                     : row.process->Pid() == state.selectedPid;
+    if (match) {
+      state.current_selection = i;
+      state.scroll_offset = std::max(0, (int)i - screenLine);
+      return;
+    }
+  }
+  // The process is gone; stay on the same line
+  moveSelection(state, state.current_selection);
+}
+
+// Selects the first process whose PID starts with the typed digits, an
+// exact match wins
+static void jumpToPid(DisplayState& state, char digit) {
+  auto now = std::chrono::steady_clock::now();
+  if (now - state.lastPidKey > std::chrono::milliseconds(1500)) {
+    state.pidQuery.clear();
+  }
+  state.lastPidKey = now;
+  state.pidQuery.push_back(digit);
+
+  int prefixMatch = -1;
+  char pid[16];
+  for (size_t i = 0; i < state.rows.size(); ++i) {
+    if (state.rows[i].process == nullptr) continue;
+    std::string_view text(
+        pid, Format::Integer(pid, pid + sizeof(pid),
+                             state.rows[i].process->Pid()) - pid);
+    if (text == state.pidQuery) {
+      moveSelection(state, i);
+      return;
+    }
+    if (prefixMatch < 0 && text.substr(0, state.pidQuery.size()) ==
+                               state.pidQuery) {
+      prefixMatch = i;
+    }
+  }
+  if (prefixMatch >= 0) moveSelection(state, prefixMatch);
+}
+
+// Flat list of processes, or processes grouped under their cgroup headers
+static void buildRows(DisplayState& state, DataSource& system) {
+  state.rows.clear();
+
+  std::vector<const std::shared_ptr<Process>*> processes;
+  processes.reserve(state.processes.size());
+  if (state.filterQuery.empty()) {
+    for (const auto& process : state.processes) processes.push_back(&process);
+  } else {
+    if (state.filterStale) {
+      state.filter.Clear();
+      for (const auto& process : state.processes) {
+        state.filter.Add(process->User(), process->Command());
+      }
+      state.filterStale = false;
+    }
+    for (uint32_t index : state.filter.Apply(state.filterQuery)) {
+      processes.push_back(&state.processes[index]);
+    }
+  }
+  state.filterMatches = processes.size();
+
+  if (!state.cgroupMode) {
+    for (const auto* process : processes) {
+      state.rows.push_back({nullptr, *process, false});
+    }
+    return;
+  }
+
+  // Processes keep their sorted order inside every group
+  std::unordered_map<std::string, std::vector<const std::shared_ptr<Process>*>>
+      members;
+  for (const auto* processPtr : processes) {
+    const std::shared_ptr<Process>& process = *processPtr;
+    if (state.expandedCgroups.count(process->Cgroup())) {
+      members[process->Cgroup()].push_back(&process);
+    }
+  }
+
+  for (const CgroupStats* cgroup :
+       system.GetSortedCgroups()) {
+    bool expanded = state.expandedCgroups.count(cgroup->path) > 0;
+    state.rows.push_back({cgroup, nullptr, expanded});
+    if (expanded) {
+      for (const auto* process : members[cgroup->path]) {
+        state.rows.push_back({nullptr, *process, false});
+      }
+    }
+  }
+}
+
 static int signal_pipe[2];
 
 static void handleResize(int signal) {
@@ -528,6 +1429,7 @@ static void screenResizer(DisplayState& state, EventQueue<Event>& eventQueue) {
   }
 }
 
+// getch() times out so the thread notices when the UI stops
 static void scanKeys(DisplayState& state, EventQueue<Event>& eventQueue) {
   while (true) {
     {
@@ -535,14 +1437,7 @@ static void scanKeys(DisplayState& state, EventQueue<Event>& eventQueue) {
       if (!state.running) return;
     }
     int ch = getch();
-    if (ch == 'q') {
-      {
-        std::lock_guard<std::mutex> lck(state.mtx);
-        state.running = false;
-      }
-      eventQueue.push({EventType::NONE, 0});
-      return;
-    } else {
+    if (ch != ERR) {
       eventQueue.push({EventType::KEY_PRESS, ch});
     }
   }
@@ -550,7 +1445,7 @@ static void scanKeys(DisplayState& state, EventQueue<Event>& eventQueue) {
 
 static void screenRedrawer(DisplayState& state, EventQueue<Event>& eventQueue) {
 
-  const std::chrono::milliseconds redrawInterval(GLOBAL_REFRESH_RATE);
+  const std::chrono::milliseconds redrawInterval(Globals::RefreshRate());
 
   while (true) {
     {
@@ -558,7 +1453,9 @@ static void screenRedrawer(DisplayState& state, EventQueue<Event>& eventQueue) {
       if (!state.running) return;
     }
     eventQueue.push({EventType::REDRAW, 0});
-    std::this_thread::sleep_for(redrawInterval);
+    std::unique_lock<std::mutex> lck(state.mtx);
+    state.stopped.wait_for(lck, redrawInterval,
+                           [&state] { return !state.running; });
   }
 }
 
@@ -584,7 +1481,7 @@ static bool resizeOrReallocateWindow(WINDOW **win, int newHeight,
 }
 
 static void reinitWindows(WINDOW** processesListWindow, WINDOW** headerWindow,
-                          WINDOW** upperPanel) {
+                          WINDOW** upperPanel, WINDOW** footerWindow) {
   werase(stdscr);
   wnoutrefresh(stdscr);
 
@@ -594,76 +1491,453 @@ static void reinitWindows(WINDOW** processesListWindow, WINDOW** headerWindow,
   werase(*processesListWindow);
   werase(*headerWindow);
   werase(*upperPanel);
+  werase(*footerWindow);
 
-  int processesListWindowHeight = std::max(1, windowHeight - LOWER_PANEL_WIDTH - UPPER_PANEL_HEIGHT);
+  int processesListWindowHeight = std::max(1, windowHeight - LOWER_PANEL_WIDTH - upper_panel_height);
 
   // Resize or reallocate windows as needed
   resizeOrReallocateWindow(processesListWindow, processesListWindowHeight, windowWidth,
-                           UPPER_PANEL_HEIGHT + 1, 0);
-  resizeOrReallocateWindow(headerWindow, 1, windowWidth, UPPER_PANEL_HEIGHT, 0);
-  resizeOrReallocateWindow(upperPanel, UPPER_PANEL_HEIGHT, windowWidth, 0, 0);
+                           upper_panel_height + 1, 0);
+  resizeOrReallocateWindow(headerWindow, 1, windowWidth, upper_panel_height, 0);
+  resizeOrReallocateWindow(upperPanel, upper_panel_height, windowWidth, 0, 0);
+  resizeOrReallocateWindow(footerWindow, 1, windowWidth,
+                           std::max(0, windowHeight - 1), 0);
 
   doupdate();
 }
 
-static void redrawWindow(DisplayState& state,
-                         WINDOW* processesListWindow, WINDOW* headerWindow,
-                         WINDOW* upperPanel, System& system,
-                         bool redrawUpperPanel = true) {
+static void drawFilterPrompt(ShadowWindow& footer, const DisplayState& state) {
+  if (!state.filterInput && state.filterQuery.empty()) return;
+  int x = 0;
+  auto print = [&](std::string_view text, attr_t attributes) {
+    footer.Print(0, x, text, attributes);
+    x += text.size();
+  };
+  print("Filter: ", COLOR_PAIR(ColorPairs::cyan_black_pair));
+  print(state.filterQuery, A_BOLD);
+  if (state.filterInput) print("_", A_BLINK);
+
+  char counts[64];
+  snprintf(counts, sizeof(counts), "  %zu of %zu", state.filterMatches,
+           state.processes.size());
+  print(counts, A_NORMAL);
+  print(state.filterInput ? "  Enter keep, Esc clear" : "  / edit, Esc clear",
+        COLOR_PAIR(ColorPairs::cyan_black_pair));
+}
+
+// Box over the process list with the command line of the process Enter was
+// pressed on, wrapped to the width of the box
+static void drawProcessDetail(ShadowWindow& window, DisplayState& state) {
+  int width = window.Width() - 4;
+  int height = window.Height() - 2;
+  if (width < 10 || height < 3) return;
+  int left = 2;
+  int top = 1;
+  attr_t border = COLOR_PAIR(ColorPairs::cyan_black_pair);
+
+  // Plain ASCII, like the graphs, for the narrow curses library
+  window.Fill(top, left, width, '-' | border);
+  window.Fill(top + height - 1, left, width, '-' | border);
+  for (int y = top; y < top + height; ++y) {
+    bool corner = y == top || y == top + height - 1;
+    window.Fill(y, left, 1, (corner ? '+' : '|') | border);
+    window.Fill(y, left + width - 1, 1, (corner ? '+' : '|') | border);
+    if (!corner) window.Fill(y, left + 1, width - 2, ' ');
+  }
+  window.Print(top, left + 2, state.detailTitle, A_BOLD);
+  window.Print(top + height - 1, left + 2,
+               " Up/Down scroll, Enter or Esc close ", border);
+
+  int textWidth = width - 4;
+  int rows = height - 2;
+  int lines = std::max<int>(
+      1, (state.detailCommand.size() + textWidth - 1) / textWidth);
+  state.detailScroll =
+      std::clamp(state.detailScroll, 0, std::max(0, lines - rows));
+  std::string_view command(state.detailCommand);
+  for (int i = 0; i < rows; ++i) {
+    size_t start = (size_t)(state.detailScroll + i) * textWidth;
+    if (start >= command.size()) break;
+    window.Print(top + 1 + i, left + 2, command.substr(start, textWidth));
+  }
+}
+
+// Opens the detail box for the selected process, reading all of its
+// command line now rather than keeping it for every process
+static void openProcessDetail(DisplayState& state, DataSource& system) {
+  if (state.current_selection >= (ssize_t)state.rows.size()) return;
+  const std::shared_ptr<Process>& process =
+      state.rows[state.current_selection].process;
+  if (!process) return;
+  state.detailOpen = true;
+  state.detailPid = process->Pid();
+  state.detailScroll = 0;
+  state.detailCommand = system.ProcessCommandLine(process->Pid());
+  if (state.detailCommand.empty()) state.detailCommand = process->Command();
+  char title[96];
+  snprintf(title, sizeof(title), " PID %d  %s  state %c  %u threads  %zu bytes ",
+           process->Pid(), process->User().c_str(), process->State(),
+           process->getNumThreads(), state.detailCommand.size());
+  state.detailTitle = title;
+}
+
+// Scrolling and closing of the detail box, which takes every key while open
+static bool handleDetailKey(DisplayState& state, int key) {
+  if (!state.detailOpen) return false;
+  int page = std::max(1, state.numProcessesToDisplay - 4);
+  switch (key) {
+    case KEY_UP: state.detailScroll -= 1; break;
+    case KEY_DOWN: state.detailScroll += 1; break;
+    case KEY_PPAGE: state.detailScroll -= page; break;
+    case KEY_NPAGE: state.detailScroll += page; break;
+    case KEY_HOME: state.detailScroll = 0; break;
+    case KEY_END: state.detailScroll = INT32_MAX; break;  // clamped when drawn
+    case 27:  // Esc
+    case '\n':
+    case KEY_ENTER:
+    case 'q':
+      state.detailOpen = false;
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+// Node placement of the selected process at the right of the footer. The
+// file is read when another process gets selected and every
+// NUMA_MAPS_REFRESH_MS, as the kernel walks all of its page tables for it.
+static void drawNumaMaps(ShadowWindow& footer, DisplayState& state,
+                         DataSource& system) {
+  if (!state.showNumaMaps || state.selectedPid < 0) return;
+  auto now = std::chrono::steady_clock::now();
+  if (state.numaPid != state.selectedPid ||
+      now - state.numaRead >= std::chrono::milliseconds(NUMA_MAPS_REFRESH_MS)) {
+    state.numaPid = state.selectedPid;
+    state.numaValid = system.ProcessNumaMemory(state.numaPid, state.numaKb);
+    state.numaRead = now;
+  }
+
+  char text[256];
+  int len = snprintf(text, sizeof(text), "PID %d", state.numaPid);
+  if (!state.numaValid) {
+    len += snprintf(text + len, sizeof(text) - len, " numa_maps not readable");
+  } else {
+    uint64_t total = 0;
+    for (uint64_t kb : state.numaKb) total += kb;
+    for (size_t node = 0; node < state.numaKb.size() &&
+                          len < (int)sizeof(text) - 1;
+         ++node) {
+      if (state.numaKb[node] == 0) continue;
+      len += snprintf(text + len, sizeof(text) - len, "  N%zu %s %.0f%%", node,
+                      convertMemoryToStr(state.numaKb[node]).c_str(),
+                      total ? 100.0 * state.numaKb[node] / total : 0.0);
+    }
+    if (total == 0) {
+      len += snprintf(text + len, sizeof(text) - len, " no resident pages");
+    }
+  }
+  len = std::min<int>(len, sizeof(text) - 1);
+  footer.Print(0, std::max(0, footer.Width() - len - 1), std::string_view(text, len),
+               COLOR_PAIR(ColorPairs::cyan_black_pair));
+}
+
+// Composes the frame into the shadow windows; only cells that differ from
+// the previous frame reach curses. Without `resample` only the process list
+// is repainted from the current snapshot, which is all navigation needs.
+static void redrawWindow(DisplayState& state, Screen& screen,
+                         DataSource& system, bool resample = true) {
   std::lock_guard<std::mutex> lck(state.mtx);
 
-  //getmaxyx(stdscr, windowHeight, windowWidth);
-  //state.numProcessesToDisplay = std::max(0, windowHeight - UPPER_PANEL_HEIGHT - 2);
+  if (resample && state.numProcessesToDisplay > 0 && !state.priming) {
+    system.Update();
+  }
+
+  auto frameStart = std::chrono::steady_clock::now();
+  long long bytesBefore = state.showRenderStats ? threadBytesWritten() : 0;
+  size_t cellsWritten = 0;
   const auto& memData = system.MemoryUtilization();
 
-  if (state.numProcessesToDisplay > 0) {
-    werase(processesListWindow);
-    system.processManager.UpdateProcesses();
+  if (state.numProcessesToDisplay > 0 && state.priming) {
+    screen.processesList.Clear();
+    screen.processesList.Print(0, 0, "Scanning processes...",
+                               COLOR_PAIR(ColorPairs::cyan_black_pair));
+    cellsWritten += screen.processesList.Flush();
+  } else if (state.numProcessesToDisplay > 0) {
+    if (resample) {
+      state.processes = system.GetSortedProcesses();
+      if (state.sortColumn != Columns::kCpu) {
+        Columns::Sort(state.processes, state.sortColumn, memData);
+      }
+      state.filterStale = true;
+      buildRows(state, system);
+      restoreSelection(state);
+    }
+    screen.processesList.Clear();
+    const NetworkStats* network = system.Network();
+    const InterruptStats* interrupts = system.Interrupts();
+    if (state.interruptMode && interrupts != nullptr) {
+      displayInterrupts(screen.processesList, *interrupts,
+                        state.interruptScroll);
+    } else if (state.networkMode && network != nullptr) {
+      displayNetwork(screen.processesList, *network, system.History(),
+                     state.networkFilter, state.networkScroll);
+    } else {
+      displayProcesses(screen.processesList, state.rows, memData,
+                       state.numProcessesToDisplay, state.current_selection,
+                       state.scroll_offset, state.cgroupMode,
+                       state.filterQuery);
+      if (Columns::Sources(visible_columns) & SAMPLE_SOURCES_PASS) {
+        // The expensive sources are read for these before the rest
+        std::vector<pid_t> pids;
+        size_t end = std::min(state.rows.size(),
+                              (size_t)(state.scroll_offset +
+                                       state.numProcessesToDisplay));
+        for (size_t i = state.scroll_offset; i < end; ++i) {
+          const auto& process = state.rows[i].process;
+          if (process) pids.push_back(process->Pid());
+        }
+        system.SetVisiblePids(std::move(pids));
+      }
+      if (state.detailOpen) {
+        drawProcessDetail(screen.processesList, state);
+      }
+    }
+    cellsWritten += screen.processesList.Flush();
+  }
+
+  screen.footer.Clear();
+  drawFilterPrompt(screen.footer, state);
+  drawNumaMaps(screen.footer, state, system);
+  cellsWritten += screen.footer.Flush();
+
+  screen.header.Clear();
+  if (state.interruptMode && system.Interrupts() != nullptr) {
+    displayInterruptHeader(screen.header, system.Interrupts()->Cpus());
+  } else if (state.networkMode) {
+    displayNetworkHeader(screen.header);
+  } else {
+    displayTableHeader(screen.header, state.sortColumn);
+  }
+  cellsWritten += screen.header.Flush();
+
+  if (resample) {
+    screen.upperPanel.Clear();
+
+    state.cpuUsage.Update(system.totalCpuUtilization());
+    state.cpuUsage.UpdateBreakdown(system.totalCpuUtilization());
+    drawCpuBars(screen.upperPanel, state.cpuUsage.Ratios(),
+                state.cpuUsage.Breakdown(), state.cpuNodes);
+
+    drawMemUtilization(screen.upperPanel, memData);
+    if (const SampleHistory* history = system.History()) {
+      drawHistory(screen.upperPanel, *history);
+    }
+    drawGlobalSystemStats(screen.upperPanel, system);
+    int first_row = UPPER_PANEL_HEIGHT;
+    const PressureStats* pressure = system.Pressure();
+    if (pressure != nullptr && pressure->Available()) {
+      drawPressure(screen.upperPanel, *pressure, system.History(), first_row);
+      first_row++;
+    }
+    const auto* numaNodes = system.NumaMemory();
+    if (numaNodes != nullptr && !numaNodes->empty()) {
+      drawNumaMemory(screen.upperPanel, *numaNodes, first_row);
+      first_row++;
+    }
+    if (LowImpact::Current().Enabled()) {
+      state.selfStats.Update(LinuxParser::SelfUsage(),
+                             std::chrono::steady_clock::now());
+      drawSelfStats(screen.upperPanel, state.selfStats, first_row);
+      first_row++;
+    }
+    if (const DiskStats* disks = system.Disks()) {
+      drawDiskBars(screen.upperPanel, *disks, first_row);
+    }
+    if (state.showRenderStats) {
+      drawRenderStats(screen.upperPanel, state.renderStats);
+    }
+
+    cellsWritten += screen.upperPanel.Flush();
+  }
+  doupdate();
 
-    state.processes = system.processManager.GetSortedProcessesForDisplay();
-    displayProcesses(processesListWindow, state.processes, memData,
-                     state.numProcessesToDisplay, state.current_selection,
-                     state.scroll_offset);
-    wrefresh(processesListWindow);
+  state.renderStats.buildMs =
+      std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - frameStart).count();
+  state.renderStats.cellsWritten = cellsWritten;
+  state.renderStats.bytesWritten =
+      state.showRenderStats ? threadBytesWritten() - bytesBefore : 0;
+}
+
+// Editing keys of the '/' filter; returns false for keys it does not use.
+// Every change narrows or widens the rows of the current snapshot.
+static bool handleFilterKey(DisplayState& state, DataSource& system, int key) {
+  if (!state.filterInput) {
+    if (key == '/') {
+      state.filterInput = true;
+      return true;
+    }
+    if (key == 27 && !state.filterQuery.empty()) {
+      state.filterQuery.clear();
+    } else {
+      return false;
+    }
+  } else if (key == 27) {
+    state.filterInput = false;
+    state.filterQuery.clear();
+  } else if (key == '\n' || key == KEY_ENTER) {
+    state.filterInput = false;
+    return true;
+  } else if (key == KEY_BACKSPACE || key == 127 || key == 8) {
+    if (state.filterQuery.empty()) return true;
+    state.filterQuery.pop_back();
+  } else if (key >= ' ' && key <= '~') {
+    state.filterQuery.push_back((char)key);
+  } else {
+    return false;  // e.g. arrows keep navigating while typing
   }
 
-  if (redrawUpperPanel) {
-    werase(upperPanel);
-    werase(headerWindow);
-    displayTableHeader(headerWindow);
+  buildRows(state, system);
+  restoreSelection(state);
+  return true;
+}
 
-    const auto& cpuData = System::totalCpuUtilization();
-    drawCpuBars(upperPanel, cpuData);
+// Shows `toggled` in front of `anchor` (behind it with `after`), or hides
+// them if any is visible
+static void toggleColumns(DisplayState& state, DataSource& system,
+                          std::initializer_list<int> toggled, int anchor,
+                          bool after = false) {
+  std::vector<int> columns;
+  bool shown = false;
+  for (int column : visible_columns) {
+    if (std::find(toggled.begin(), toggled.end(), column) != toggled.end()) {
+      shown = true;
+    } else {
+      columns.push_back(column);
+    }
+  }
+  if (!shown) {
+    auto position = std::find(columns.begin(), columns.end(), anchor);
+    if (after && position != columns.end()) ++position;
+    columns.insert(position, toggled);
+  }
+  if (std::find(columns.begin(), columns.end(), state.sortColumn) ==
+      columns.end()) {
+    state.sortColumn = Columns::kCpu;
+  }
+  calculateColumnPositions(columns);
+  system.SetWantedSources(Columns::Sources(columns));
+}
 
-    drawMemUtilization(upperPanel, memData);
-    drawGlobalSystemStats(upperPanel, system);
+// UPPER_PANEL_HEIGHT, a row for pressure where the kernel has PSI, one for
+// the NUMA nodes where there are several and one for every disk bar that
+// fits
+static int upperPanelHeight(DataSource& system) {
+  const PressureStats* pressure = system.Pressure();
+  const auto* numaNodes = system.NumaMemory();
+  const DiskStats* disks = system.Disks();
+  int bars = disks ? std::min<int>(disks->Disks().size(), DISK_MAX_BARS) : 0;
+  return UPPER_PANEL_HEIGHT + (pressure && pressure->Available()) +
+         (numaNodes && !numaNodes->empty()) + LowImpact::Current().Enabled() +
+         bars;
+}
 
-    wrefresh(headerWindow);
-    wrefresh(upperPanel);
+// Scrolling and the interface filter of the network view; returns false for
+// keys it does not use
+static bool handleNetworkKey(DisplayState& state, int key) {
+  if (!state.networkMode) return false;
+  int page = std::max(1, state.numProcessesToDisplay - 3);
+  switch (key) {
+    case KEY_UP: state.networkScroll -= 1; break;
+    case KEY_DOWN: state.networkScroll += 1; break;
+    case KEY_PPAGE: state.networkScroll -= page; break;
+    case KEY_NPAGE: state.networkScroll += page; break;
+    case KEY_HOME: state.networkScroll = 0; break;
+    case KEY_END: state.networkScroll = INT32_MAX; break;  // clamped when drawn
+    case 'v':
+      state.networkFilter = state.networkFilter == NetFilter::PHYSICAL
+                                ? NetFilter::EXTERNAL
+                                : state.networkFilter == NetFilter::EXTERNAL
+                                      ? NetFilter::ALL
+                                      : NetFilter::PHYSICAL;
+      state.networkScroll = 0;
+      break;
+    default:
+      return false;
   }
+  return true;
+}
 
+// Scrolling of the interrupt view; returns false for keys it does not use
+static bool handleInterruptKey(DisplayState& state, int key) {
+  if (!state.interruptMode) return false;
+  int page = std::max(1, state.numProcessesToDisplay - 1);
+  switch (key) {
+    case KEY_UP: state.interruptScroll -= 1; break;
+    case KEY_DOWN: state.interruptScroll += 1; break;
+    case KEY_PPAGE: state.interruptScroll -= page; break;
+    case KEY_NPAGE: state.interruptScroll += page; break;
+    case KEY_HOME: state.interruptScroll = 0; break;
+    case KEY_END: state.interruptScroll = INT32_MAX; break;  // clamped when drawn
+    default:
+      return false;
+  }
+  return true;
 }
 
-void Display(System& system) {
+void Display(DataSource& system, const std::vector<int>& columns) {
   initscr();  // Start ncurses mode
   raw();
   noecho();  // Don't echo keystrokes
   keypad(stdscr, TRUE);
+  set_escdelay(25);  // Esc leaves the filter prompt without a pause
+  timeout(100);
   curs_set(0);    // Hide cursor
   start_color();  // Enable colors
   initColors();
 
-  calculateColumnPositions();
+  calculateColumnPositions(columns);
+  upper_panel_height = upperPanelHeight(system);
   int windowHeight, windowWidth;
   getmaxyx(stdscr, windowHeight, windowWidth);
-  WINDOW* processesListWindow = newwin(windowHeight - LOWER_PANEL_WIDTH - UPPER_PANEL_HEIGHT,
-                                       windowWidth, 1 + UPPER_PANEL_HEIGHT, 0);
-  WINDOW* headerWindow = newwin(1, windowWidth, UPPER_PANEL_HEIGHT, 0);
-  WINDOW* upperPanel = newwin(UPPER_PANEL_HEIGHT, windowWidth, 0, 0);
+  WINDOW* processesListWindow = newwin(windowHeight - LOWER_PANEL_WIDTH - upper_panel_height,
+                                       windowWidth, 1 + upper_panel_height, 0);
+  WINDOW* headerWindow = newwin(1, windowWidth, upper_panel_height, 0);
+  WINDOW* upperPanel = newwin(upper_panel_height, windowWidth, 0, 0);
+  WINDOW* footerWindow = newwin(1, windowWidth, windowHeight - 1, 0);
+  Screen screen;
+  screen.processesList.Reset(processesListWindow);
+  screen.header.Reset(headerWindow);
+  screen.upperPanel.Reset(upperPanel);
+  screen.footer.Reset(footerWindow);
 
   DisplayState displayState;
-  displayState.numProcessesToDisplay = std::max(1, windowHeight - LOWER_PANEL_WIDTH - UPPER_PANEL_HEIGHT);
+  displayState.numProcessesToDisplay = std::max(1, windowHeight - LOWER_PANEL_WIDTH - upper_panel_height);
+  displayState.cpuNodes = system.CpuNodes();
+  system.SetWantedSources(Columns::Sources(columns));
+
+  // The system-wide panels go up right away; the process list follows once
+  // the first scan and the priming sample are in
+  displayState.priming = true;
+  // getch() refreshes stdscr, clearing the screen the first time; that has to
+  // happen before the windows are drawn, not over them
+  refresh();
+  redrawWindow(displayState, screen, system, true);
   EventQueue<Event> queue;
+  std::thread primer([&system, &displayState, &queue] {
+    system.Prime();
+    {
+      std::lock_guard<std::mutex> lck(displayState.mtx);
+      displayState.priming = false;
+    }
+    queue.push({EventType::REDRAW, 0});
+  });
+  // Keys and resizes that came in while priming, handled after it
+  std::vector<Event> deferred;
+
+  // Like the primer, these inherit the scheduling policy and CPU affinity
+  // LowImpact::Apply() gave the main thread
   std::thread keysScanner(scanKeys, std::ref(displayState), std::ref(queue));
   std::thread refreshTimer(screenRedrawer, std::ref(displayState), std::ref(queue));
   std::thread screenResizerT(screenResizer, std::ref(displayState), std::ref(queue));
@@ -676,33 +1950,252 @@ void Display(System& system) {
     // Process events from the queue
     Event event = queue.pop();
 
+    bool priming;
+    {
+      std::lock_guard<std::mutex> lck(displayState.mtx);
+      priming = displayState.priming;
+    }
+    if (priming && event.type != EventType::NONE) {
+      if (event.type == EventType::KEY_PRESS && event.key == 'q') {
+        // Otherwise the primer is joined only once the whole scan is done
+        system.CancelPrime();
+        std::lock_guard<std::mutex> lck(displayState.mtx);
+        displayState.running = false;
+        displayState.stopped.notify_all();
+      } else if (event.type == EventType::KEY_PRESS ||
+                 event.type == EventType::RESIZE) {
+        deferred.push_back(event);
+      }
+      continue;
+    }
+    for (Event& pending : deferred) queue.push(std::move(pending));
+    deferred.clear();
+
     if (event.type == EventType::KEY_PRESS) {
       std::unique_lock<std::mutex> lock(displayState.mtx);
+      if (handleDetailKey(displayState, event.key) ||
+          handleFilterKey(displayState, system, event.key)) {
+        lock.unlock();
+        redrawWindow(displayState, screen, system, false);
+        continue;
+      }
+      if (handleNetworkKey(displayState, event.key) ||
+          handleInterruptKey(displayState, event.key)) {
+        lock.unlock();
+        redrawWindow(displayState, screen, system, false);
+        continue;
+      }
+      // Keys of the data source (e.g. replay controls) take precedence
+      if (system.HandleKey(event.key)) {
+        lock.unlock();
+        redrawWindow(displayState, screen, system, true);
+        continue;
+      }
       switch (event.key) {
+        case 'q':
+          displayState.running = false;
+          displayState.stopped.notify_all();
+          break;
+
         case KEY_UP:
-          if (displayState.current_selection > 0) {
-            if (displayState.current_selection == displayState.scroll_offset) {
-              displayState.scroll_offset--;
+        case KEY_DOWN:
+        case KEY_PPAGE:
+        case KEY_NPAGE:
+        case KEY_HOME:
+        case KEY_END: {
+          // Navigation only moves over the current snapshot
+          int page = std::max(1, displayState.numProcessesToDisplay);
+          int target = displayState.current_selection;
+          switch (event.key) {
+            case KEY_UP: target -= 1; break;
+            case KEY_DOWN: target += 1; break;
+            case KEY_PPAGE: target -= page; break;
+            case KEY_NPAGE: target += page; break;
+            case KEY_HOME: target = 0; break;
+            case KEY_END: target = displayState.rows.size(); break;
+          }
+          moveSelection(displayState, target);
+          lock.unlock();
+          redrawWindow(displayState, screen, system, false);
+          break;
+        }
+
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+          jumpToPid(displayState, (char)event.key);
+          lock.unlock();
+          redrawWindow(displayState, screen, system, false);
+          break;
+
+        case '<':
+        case '>': {
+          // Sort by the visible column on the left or right of the current
+          auto it = std::find(visible_columns.begin(), visible_columns.end(),
+                              displayState.sortColumn);
+          int index = it - visible_columns.begin();
+          int count = visible_columns.size();
+          index = (it == visible_columns.end())
+                      ? 0
+                      : (index + (event.key == '>' ? 1 : count - 1)) % count;
+          displayState.sortColumn = visible_columns[index];
+          rememberSelection(displayState);
+          if (displayState.sortColumn == Columns::kCpu) {
+            ProcessManager::SortForDisplay(displayState.processes, 0);
+          } else {
+            Columns::Sort(displayState.processes, displayState.sortColumn,
+                          system.MemoryUtilization());
+          }
+          displayState.filterStale = true;
+          buildRows(displayState, system);
+          restoreSelection(displayState);
+          lock.unlock();
+          redrawWindow(displayState, screen, system, false);
+          break;
+        }
+
+        case 'I':
+          // Show or hide the I/O rate columns, in front of the command
+          toggleColumns(displayState, system,
+                        {Columns::Index("read_rate"),
+                         Columns::Index("write_rate"),
+                         Columns::Index("syscall_rate")},
+                        Columns::kCommand);
+          lock.unlock();
+          redrawWindow(displayState, screen, system, true);
+          break;
+
+        case 'M':
+          // Show or hide PSS and USS, behind SHR
+          toggleColumns(displayState, system,
+                        {Columns::Index("pss"), Columns::Index("uss")},
+                        Columns::kShr, true);
+          lock.unlock();
+          redrawWindow(displayState, screen, system, true);
+          break;
+
+        case 'L':
+          // Show or hide run queue wait (of all threads) and the context
+          // switch rates (of the main thread), behind CPU%, to find the
+          // processes starved of CPU
+          toggleColumns(displayState, system,
+                        {Columns::Index("wait"), Columns::Index("vcsw_rate"),
+                         Columns::Index("ivcsw_rate")},
+                        Columns::kCpu, true);
+          lock.unlock();
+          redrawWindow(displayState, screen, system, true);
+          break;
+
+        case 'D': {
+          // Cycle the descriptor columns: FDS and FD%, then also the socket
+          // count (which reads every fd link), then none
+          int fds = Columns::Index("fds");
+          int usage = Columns::Index("fd_usage");
+          int sockets = Columns::Index("sockets");
+          if (column_positions[sockets] >= 0) {
+            toggleColumns(displayState, system, {fds, usage, sockets},
+                          Columns::kCommand);
+          } else {
+            bool shown = column_positions[fds] >= 0;
+            toggleColumns(displayState, system, {fds, usage},
+                          Columns::kCommand);
+            if (shown) {
+              toggleColumns(displayState, system, {fds, usage, sockets},
+                            Columns::kCommand);
+            }
+          }
+          lock.unlock();
+          redrawWindow(displayState, screen, system, true);
+          break;
+        }
+
+        case 'K':
+          // Toggle the kernel threads; the next sample adds or drops them
+          displayState.showKernelThreads =
+              !displayState.showKernelThreads &&
+              system.SetShowKernelThreads(true);
+          if (!displayState.showKernelThreads) system.SetShowKernelThreads(false);
+          lock.unlock();
+          redrawWindow(displayState, screen, system, true);
+          break;
+
+        case 'N':
+          // Toggle the NUMA placement of the selected process
+          displayState.showNumaMaps = !displayState.showNumaMaps;
+          displayState.numaPid = -1;
+          lock.unlock();
+          redrawWindow(displayState, screen, system, false);
+          break;
+
+        case 'S':
+          // Toggle the frame cost readout
+          displayState.showRenderStats = !displayState.showRenderStats;
+          lock.unlock();
+          redrawWindow(displayState, screen, system, true);
+          break;
+
+        case 'n':
+          // Toggle the network interfaces in place of the process list
+          if (const NetworkStats* network = system.Network()) {
+            displayState.networkMode = !displayState.networkMode;
+            displayState.networkFilter = network->DefaultFilter();
+            displayState.networkScroll = 0;
+            if (displayState.interruptMode) {
+              displayState.interruptMode = false;
+              system.SetInterruptTracking(false);
             }
-            displayState.current_selection--;
             lock.unlock();
-            redrawWindow(displayState, processesListWindow,
-                         headerWindow, upperPanel, system,
-                         true);
+            redrawWindow(displayState, screen, system, false);
           }
           break;
 
-        case KEY_DOWN:
-          if (displayState.current_selection < static_cast<ssize_t>(displayState.processes.size()) - 1) {
-            if (displayState.current_selection == displayState.numProcessesToDisplay
-                                                      + displayState.scroll_offset - 1) {
-              displayState.scroll_offset++;
+        case 'i':
+          // Toggle the interrupt rates in place of the process list
+          displayState.interruptMode = !displayState.interruptMode &&
+                                       system.SetInterruptTracking(true);
+          if (!displayState.interruptMode) system.SetInterruptTracking(false);
+          if (displayState.interruptMode) displayState.networkMode = false;
+          displayState.interruptScroll = 0;
+          lock.unlock();
+          redrawWindow(displayState, screen, system, true);
+          break;
+
+        case 'c':
+          // Toggle the cgroup aggregation view
+          displayState.cgroupMode = !displayState.cgroupMode &&
+                                    system.SetCgroupTracking(true);
+          if (!displayState.cgroupMode) system.SetCgroupTracking(false);
+          displayState.current_selection = 0;
+          displayState.scroll_offset = 0;
+          displayState.selectedPid = -1;
+          displayState.cgroupSelected = false;
+          lock.unlock();
+          redrawWindow(displayState, screen, system, true);
+          break;
+
+        case ' ':
+        case '\n':
+        case KEY_ENTER:
+          // Collapse or expand the selected cgroup; Enter on a process shows
+          // its command line
+          if (event.key != ' ' && !displayState.networkMode &&
+              !displayState.interruptMode &&
+              displayState.current_selection < (ssize_t)displayState.rows.size() &&
+              displayState.rows[displayState.current_selection].process) {
+            openProcessDetail(displayState, system);
+            lock.unlock();
+            redrawWindow(displayState, screen, system, false);
+          } else if (displayState.cgroupMode &&
+              displayState.current_selection < (ssize_t)displayState.rows.size()) {
+            const ListRow& row = displayState.rows[displayState.current_selection];
+            if (row.cgroup != nullptr) {
+              if (row.expanded) {
+                displayState.expandedCgroups.erase(row.cgroup->path);
+              } else {
+                displayState.expandedCgroups.insert(row.cgroup->path);
+              }
             }
-            displayState.current_selection++;
             lock.unlock();
-            redrawWindow(displayState, processesListWindow,
-                         headerWindow, upperPanel, system,
-                         true);
+            redrawWindow(displayState, screen, system, true);
           }
           break;
 
@@ -711,8 +2204,9 @@ void Display(System& system) {
       if (event.type == EventType::RESIZE) {
         endwin();
         getmaxyx(stdscr, windowHeight, windowWidth);
+        upper_panel_height = upperPanelHeight(system);
         // Update numProcessesToDisplay based on the new window height
-        int newNumProcessesToDisplay = std::max(1, windowHeight - LOWER_PANEL_WIDTH - UPPER_PANEL_HEIGHT);
+        int newNumProcessesToDisplay = std::max(1, windowHeight - LOWER_PANEL_WIDTH - upper_panel_height);
 
         {
           std::lock_guard<std::mutex> lck(displayState.mtx);
@@ -725,15 +2219,20 @@ void Display(System& system) {
 
           displayState.numProcessesToDisplay = newNumProcessesToDisplay;
         }
-        reinitWindows(&processesListWindow, &headerWindow, &upperPanel);
+        reinitWindows(&processesListWindow, &headerWindow, &upperPanel,
+                      &footerWindow);
+        screen.processesList.Reset(processesListWindow);
+        screen.header.Reset(headerWindow);
+        screen.upperPanel.Reset(upperPanel);
+        screen.footer.Reset(footerWindow);
       }
-      redrawWindow(displayState, processesListWindow,
-                   headerWindow, upperPanel, system, true);
+      redrawWindow(displayState, screen, system, true);
     } else if (event.type == EventType::NONE) {
       break;
     }
   }
 
+  primer.join();
   keysScanner.join();
   refreshTimer.join();
   write(signal_pipe[1], "q", 1);
@@ -741,6 +2240,7 @@ void Display(System& system) {
   delwin(processesListWindow);
   delwin(headerWindow);
   delwin(upperPanel);
+  delwin(footerWindow);
   endwin();
 }
 
@@ -0,0 +1,87 @@
+#include "network_stats.h"
+
+#include <cstring>
+
+// Counters that went backwards belong to a recreated interface
+static double Rate(uint64_t current, uint64_t previous, double seconds) {
+  return current >= previous ? (current - previous) / seconds : 0.0;
+}
+
+void NetworkStats::Update(const std::vector<LinuxParser::netDevData>& devices,
+                          std::chrono::steady_clock::time_point now) {
+  double seconds = std::chrono::duration<double>(now - time_).count();
+  time_ = now;
+
+  previous_.swap(interfaces_);
+  interfaces_.clear();
+  for (size_t i = 0; i < devices.size(); ++i) {
+    const LinuxParser::netDevData& counters = devices[i];
+    const NetInterface* before = nullptr;
+    if (i < previous_.size() &&
+        strcmp(previous_[i].counters.name, counters.name) == 0) {
+      before = &previous_[i];
+    } else {
+      for (const NetInterface& candidate : previous_) {
+        if (strcmp(candidate.counters.name, counters.name) == 0) {
+          before = &candidate;
+          break;
+        }
+      }
+    }
+
+    NetInterface& interface = interfaces_.emplace_back();
+    interface.counters = counters;
+    if (before == nullptr) {
+      interface.loopback = strcmp(counters.name, "lo") == 0;
+      interface.physical = LinuxParser::IsPhysicalInterface(counters.name);
+      continue;
+    }
+    interface.loopback = before->loopback;
+    interface.physical = before->physical;
+    const LinuxParser::netDevData& last = before->counters;
+    interface.hasRates = true;
+    interface.rates = {
+        Rate(counters.rxBytes, last.rxBytes, seconds),
+        Rate(counters.rxPackets, last.rxPackets, seconds),
+        Rate(counters.rxErrors, last.rxErrors, seconds),
+        Rate(counters.rxDrops, last.rxDrops, seconds),
+        Rate(counters.txBytes, last.txBytes, seconds),
+        Rate(counters.txPackets, last.txPackets, seconds),
+        Rate(counters.txErrors, last.txErrors, seconds),
+        Rate(counters.txDrops, last.txDrops, seconds),
+    };
+  }
+}
+
+bool NetworkStats::Admits(NetFilter filter, const NetInterface& interface) {
+  switch (filter) {
+    case NetFilter::PHYSICAL: return interface.physical;
+    case NetFilter::EXTERNAL: return !interface.loopback;
+    case NetFilter::ALL: return true;
+  }
+  return true;
+}
+
+NetRates NetworkStats::Total(NetFilter filter) const {
+  NetRates total{};
+  for (const NetInterface& interface : interfaces_) {
+    if (!interface.hasRates || !Admits(filter, interface)) continue;
+    const NetRates& rates = interface.rates;
+    total.rxBytes += rates.rxBytes;
+    total.rxPackets += rates.rxPackets;
+    total.rxErrors += rates.rxErrors;
+    total.rxDrops += rates.rxDrops;
+    total.txBytes += rates.txBytes;
+    total.txPackets += rates.txPackets;
+    total.txErrors += rates.txErrors;
+    total.txDrops += rates.txDrops;
+  }
+  return total;
+}
+
+NetFilter NetworkStats::DefaultFilter() const {
+  for (const NetInterface& interface : interfaces_) {
+    if (interface.physical) return NetFilter::PHYSICAL;
+  }
+  return NetFilter::EXTERNAL;
+}
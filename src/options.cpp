@@ -0,0 +1,208 @@
+#include "options.h"
+
+#include <getopt.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#include "columns.h"
+
+namespace CommandLine {
+
+// Width of the option column of the usage text
+#define USAGE_INDENT 26
+#define USAGE_WIDTH 66
+
+static void PrintUsage(const char* program, FILE* stream) {
+  fprintf(stream,
+          "Usage: %s [options]\n"
+          "  -b, --batch             write snapshots to stdout instead of the UI\n"
+          "  -d, --interval <ms>     refresh interval (default %d)\n"
+          "  -n, --iterations <n>    stop after n snapshots (batch mode)\n"
+          "  -t, --top <n>           only output the n busiest processes\n"
+          "  -f, --format <fmt>      json (newline delimited) or csv\n"
+          "  -F, --fields <list>     comma separated process fields (or\n"
+          "                          columns of the UI):\n",
+          program, GLOBAL_REFRESH_RATE);
+  // Every column of the registry, wrapped
+  int x = 0;
+  for (int i = 0; i < Columns::kCount; ++i) {
+    std::string_view name = Columns::kColumns[i].name;
+    int length = name.size() + (i + 1 < Columns::kCount);
+    if (x == 0 || x + length > USAGE_WIDTH - USAGE_INDENT) {
+      fprintf(stream, "%s%*s", x ? "\n" : "", USAGE_INDENT, "");
+      x = 0;
+    }
+    fprintf(stream, "%.*s%s", (int)name.size(), name.data(),
+            i + 1 < Columns::kCount ? "," : "\n");
+    x += length;
+  }
+  fprintf(stream,
+          "  -r, --record <file>     append every snapshot to a recording\n"
+          "  -R, --replay <file>     show a recording in the UI\n"
+          "                          (p pause, , . step, [ ] seek a minute)\n"
+          "  -l, --listen <addr>     serve OpenMetrics on [host]:port or\n"
+          "                          unix:<path> (GET /metrics)\n"
+          "  -B, --benchmark <name>  run a built-in benchmark\n"
+          "                          (format, filter, cpu, startup)\n"
+          "  -C, --cmdline-max <n>   bytes of a command line kept per process\n"
+          "                          (default %d; Enter shows all of it)\n"
+          "  -p, --priority <p>      run under SCHED_IDLE (idle) or at nice\n"
+          "                          level p (-20..19)\n"
+          "  -a, --cpus <list>       only run on these CPUs (e.g. 0,2-3)\n"
+          "  -m, --mlock             pre-fault and lock the monitor's memory\n"
+          "  -h, --help              show this help\n",
+          GLOBAL_CMDLINE_MAX);
+}
+
+// Parses a positive integer argument, rejecting trailing garbage
+static bool ParsePositive(const char* text, long& value) {
+  char* end = nullptr;
+  errno = 0;
+  value = strtol(text, &end, 10);
+  return errno == 0 && end != text && *end == '\0' && value > 0;
+}
+
+bool Parse(int argc, char* argv[], Options& options, int& exitCode) {
+  static const struct option longOptions[] = {
+      {"batch", no_argument, nullptr, 'b'},
+      {"interval", required_argument, nullptr, 'd'},
+      {"iterations", required_argument, nullptr, 'n'},
+      {"top", required_argument, nullptr, 't'},
+      {"format", required_argument, nullptr, 'f'},
+      {"fields", required_argument, nullptr, 'F'},
+      {"record", required_argument, nullptr, 'r'},
+      {"replay", required_argument, nullptr, 'R'},
+      {"listen", required_argument, nullptr, 'l'},
+      {"benchmark", required_argument, nullptr, 'B'},
+      {"cmdline-max", required_argument, nullptr, 'C'},
+      {"priority", required_argument, nullptr, 'p'},
+      {"cpus", required_argument, nullptr, 'a'},
+      {"mlock", no_argument, nullptr, 'm'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+
+  exitCode = 2;
+  int opt;
+  long value;
+  while ((opt = getopt_long(argc, argv, "bd:n:t:f:F:r:R:l:B:C:p:a:mh", longOptions,
+                            nullptr)) != -1) {
+    switch (opt) {
+      case 'b':
+        options.batch = true;
+        break;
+      case 'd':
+        if (!ParsePositive(optarg, value)) {
+          fprintf(stderr, "invalid interval: %s\n", optarg);
+          return false;
+        }
+        options.intervalMs = static_cast<int>(value);
+        break;
+      case 'n':
+        if (!ParsePositive(optarg, value)) {
+          fprintf(stderr, "invalid iteration count: %s\n", optarg);
+          return false;
+        }
+        options.iterations = value;
+        break;
+      case 't':
+        if (!ParsePositive(optarg, value)) {
+          fprintf(stderr, "invalid process count: %s\n", optarg);
+          return false;
+        }
+        options.topN = static_cast<size_t>(value);
+        break;
+      case 'f':
+        if (strcmp(optarg, "json") == 0) {
+          options.format = OutputFormat::JSON;
+        } else if (strcmp(optarg, "csv") == 0) {
+          options.format = OutputFormat::CSV;
+        } else {
+          fprintf(stderr, "unknown format: %s\n", optarg);
+          return false;
+        }
+        break;
+      case 'F':
+        options.fields = optarg;
+        break;
+      case 'r':
+        options.recordPath = optarg;
+        break;
+      case 'R':
+        options.replayPath = optarg;
+        break;
+      case 'l':
+        options.listenAddress = optarg;
+        break;
+      case 'B':
+        options.benchmark = optarg;
+        break;
+      case 'C':
+        if (!ParsePositive(optarg, value)) {
+          fprintf(stderr, "invalid command line length: %s\n", optarg);
+          return false;
+        }
+        options.cmdlineMax = static_cast<size_t>(value);
+        break;
+      case 'p': {
+        if (strcmp(optarg, "idle") == 0) {
+          options.policy.idle = true;
+          options.policy.setNice = false;
+          break;
+        }
+        char* end = nullptr;
+        errno = 0;
+        value = strtol(optarg, &end, 10);
+        if (errno != 0 || end == optarg || *end != '\0' || value < -20 ||
+            value > 19) {
+          fprintf(stderr, "invalid priority: %s\n", optarg);
+          return false;
+        }
+        options.policy.idle = false;
+        options.policy.setNice = true;
+        options.policy.nice = static_cast<int>(value);
+        break;
+      }
+      case 'a':
+        if (!LowImpact::ParseCpuList(optarg, options.policy.cpus)) {
+          fprintf(stderr, "invalid CPU list: %s\n", optarg);
+          return false;
+        }
+        break;
+      case 'm':
+        options.policy.lockMemory = true;
+        break;
+      case 'h':
+        PrintUsage(argv[0], stdout);
+        exitCode = 0;
+        return false;
+      default:
+        PrintUsage(argv[0], stderr);
+        return false;
+    }
+  }
+
+  if (options.batch + !options.recordPath.empty() +
+          !options.replayPath.empty() + !options.benchmark.empty() > 1) {
+    fprintf(stderr,
+            "--batch, --record, --replay and --benchmark are exclusive\n");
+    return false;
+  }
+
+  if (!options.listenAddress.empty() && !options.replayPath.empty()) {
+    fprintf(stderr, "--listen only exports live samples, not --replay\n");
+    return false;
+  }
+
+  if (optind < argc) {
+    fprintf(stderr, "unexpected argument: %s\n", argv[optind]);
+    PrintUsage(argv[0], stderr);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace CommandLine
@@ -0,0 +1,30 @@
+#include "pressure_stats.h"
+
+#include <algorithm>
+
+// Share of `microseconds` the total grew by, in percent
+static float StallPercent(uint64_t current, uint64_t previous,
+                          double microseconds) {
+  if (current < previous || microseconds <= 0) return 0.0f;
+  return std::min(100.0, (current - previous) / microseconds * 100.0);
+}
+
+void PressureStats::Update(
+    const std::array<LinuxParser::psiFileData, LinuxParser::PSI_NUM_RESOURCES>& pressure,
+    std::chrono::steady_clock::time_point now) {
+  double microseconds =
+      std::chrono::duration<double, std::micro>(now - time_).count();
+  for (int resource = 0; resource < LinuxParser::PSI_NUM_RESOURCES; ++resource) {
+    const LinuxParser::psiFileData& previous = pressure_[resource];
+    const LinuxParser::psiFileData& current = pressure[resource];
+    if (!previous.valid || !current.valid) {
+      stall_[resource] = {};
+      continue;
+    }
+    stall_[resource] = {
+        StallPercent(current.some.total, previous.some.total, microseconds),
+        StallPercent(current.full.total, previous.full.total, microseconds)};
+  }
+  pressure_ = pressure;
+  time_ = now;
+}
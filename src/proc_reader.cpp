@@ -0,0 +1,407 @@
+#include "proc_reader.h"
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef MONITOR_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#endif
+
+// PIDs handled per submission; every PID uses two slots (stat and status)
+#define PROC_READER_CHUNK_PIDS 128
+#define PROC_READER_SLOTS (PROC_READER_CHUNK_PIDS * 2)
+#define PROC_READER_PATH_SIZE 32
+#define PROC_READER_STAT_SIZE 1024
+#define PROC_READER_STATUS_SIZE 4096
+// getdents64 buffer of the fd directory walk, room for ~400 entries a call
+#define PROC_READER_DIRENT_SIZE 8192
+
+static size_t slotSize(size_t slot) {
+  return slot % 2 == 0 ? PROC_READER_STAT_SIZE : PROC_READER_STATUS_SIZE;
+}
+
+// Writes "<pid>/<name>" NUL-terminated into `out`
+static void formatPath(char* out, pid_t pid, const char* name) {
+  char* end = std::to_chars(out, out + PROC_READER_PATH_SIZE - 1, pid).ptr;
+  *end++ = '/';
+  size_t len = std::min(std::strlen(name),
+                        static_cast<size_t>(out + PROC_READER_PATH_SIZE - 1 - end));
+  std::memcpy(end, name, len);
+  end[len] = '\0';
+}
+
+#ifdef MONITOR_HAVE_IO_URING
+
+// Minimal io_uring wrapper driven through raw syscalls (no liburing needed)
+struct ProcBatchReader::Ring {
+  int fd = -1;
+  void* sqPtr = MAP_FAILED;
+  void* cqPtr = MAP_FAILED;
+  size_t sqSize = 0;
+  size_t cqSize = 0;
+  io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+  size_t sqesSize = 0;
+  unsigned* sqHead = nullptr;
+  unsigned* sqTail = nullptr;
+  unsigned* sqMask = nullptr;
+  unsigned* sqArray = nullptr;
+  unsigned* cqHead = nullptr;
+  unsigned* cqTail = nullptr;
+  unsigned* cqMask = nullptr;
+  io_uring_cqe* cqes = nullptr;
+
+  bool Setup(unsigned entries) {
+    io_uring_params params{};
+    fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) return false;
+
+    sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) sqSize = cqSize = std::max(sqSize, cqSize);
+
+    sqPtr = mmap(nullptr, sqSize, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqPtr == MAP_FAILED) return false;
+    if (singleMmap) {
+      cqPtr = sqPtr;
+    } else {
+      cqPtr = mmap(nullptr, cqSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+      if (cqPtr == MAP_FAILED) return false;
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqesPtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqesPtr == MAP_FAILED) return false;
+    sqes = static_cast<io_uring_sqe*>(sqesPtr);
+
+    char* sq = static_cast<char*>(sqPtr);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(cqPtr);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    return params.sq_entries >= PROC_READER_SLOTS * 2 && supportsOps();
+  }
+
+  // openat, read and close were all added in 5.6; ask the kernel to be sure
+  bool supportsOps() {
+    std::vector<char> storage(sizeof(io_uring_probe) +
+                              256 * sizeof(io_uring_probe_op));
+    auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe,
+                256) < 0) {
+      return false;
+    }
+    for (int op : {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE}) {
+      if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+        return false;
+    }
+    return true;
+  }
+
+  io_uring_sqe* NextSqe(unsigned& tail) {
+    unsigned idx = tail & *sqMask;
+    sqArray[idx] = idx;
+    io_uring_sqe* sqe = &sqes[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    tail++;
+    return sqe;
+  }
+
+  // Publishes the queue up to `tail`, then waits until all `count` entries
+  // completed, handing each CQE to `onComplete`. On failure, the entries
+  // that made it to the kernel are still waited for, so that none completes
+  // behind the caller's back; the others never run.
+  template <typename Func>
+  bool SubmitAndReap(unsigned tail, unsigned count, Func&& onComplete) {
+    __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+    unsigned submitted = 0;
+    unsigned reaped = 0;
+    bool failed = false;
+    while (reaped < (failed ? submitted : count)) {
+      long ret;
+      if (!failed && submitted < count) {
+        ret = syscall(__NR_io_uring_enter, fd, count - submitted, 0, 0,
+                      nullptr, 0);
+        if (ret > 0) submitted += ret;
+        if (ret < 0 && errno != EINTR && errno != EAGAIN) {
+          failed = true;
+          continue;
+        }
+      } else {
+        ret = syscall(__NR_io_uring_enter, fd, 0,
+                      (failed ? submitted : count) - reaped,
+                      IORING_ENTER_GETEVENTS, nullptr, 0);
+        // A ring that cannot even be waited on is beyond saving
+        if (ret < 0 && errno != EINTR && errno != EAGAIN) return false;
+      }
+
+      unsigned head = *cqHead;
+      unsigned cqTailValue = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+      while (head != cqTailValue) {
+        const io_uring_cqe& cqe = cqes[head & *cqMask];
+        onComplete(cqe.user_data, cqe.res);
+        head++;
+        reaped++;
+      }
+      __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+    return !failed;
+  }
+
+  ~Ring() {
+    if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+    if (cqPtr != MAP_FAILED && cqPtr != sqPtr) munmap(cqPtr, cqSize);
+    if (sqPtr != MAP_FAILED) munmap(sqPtr, sqSize);
+    if (fd >= 0) close(fd);
+  }
+};
+
+#else
+
+struct ProcBatchReader::Ring {};
+
+#endif
+
+ProcBatchReader::ProcBatchReader()
+    : statBuffers_(PROC_READER_CHUNK_PIDS * PROC_READER_STAT_SIZE),
+      statusBuffers_(PROC_READER_CHUNK_PIDS * PROC_READER_STATUS_SIZE),
+      paths_(PROC_READER_SLOTS * PROC_READER_PATH_SIZE),
+      fds_(PROC_READER_SLOTS, -1),
+      lengths_(PROC_READER_SLOTS, 0) {
+  procDirFd_ = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (procDirFd_ < 0) {
+    perror("error while opening /proc");
+  }
+
+#ifdef MONITOR_HAVE_IO_URING
+  ring_ = std::make_unique<Ring>();
+  if (!ring_->Setup(PROC_READER_SLOTS * 2)) {
+    ring_.reset();
+  }
+#endif
+}
+
+ProcBatchReader::~ProcBatchReader() {
+  if (procDirFd_ >= 0) close(procDirFd_);
+}
+
+bool ProcBatchReader::UsingIoUring() const { return ring_ != nullptr; }
+
+std::string_view ProcBatchReader::ReadFile(int procDirFd, pid_t pid,
+                                           const char* name, char* buffer,
+                                           size_t size) {
+  char path[PROC_READER_PATH_SIZE];
+  formatPath(path, pid, name);
+  int fd = openat(procDirFd, path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return {};
+  ssize_t len = read(fd, buffer, size - 1);
+  close(fd);
+  if (len <= 0) return {};
+  return std::string_view(buffer, static_cast<size_t>(len));
+}
+
+// Record layout of getdents64, which glibc does not declare
+struct linuxDirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+int ProcBatchReader::CountFds(int procDirFd, pid_t pid, int* sockets) {
+  char path[PROC_READER_PATH_SIZE];
+  formatPath(path, pid, "fd");
+  int dirFd = openat(procDirFd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dirFd < 0) return -1;
+
+  alignas(linuxDirent64) char buffer[PROC_READER_DIRENT_SIZE];
+  int count = 0;
+  if (sockets != nullptr) *sockets = 0;
+  while (true) {
+    long len = syscall(SYS_getdents64, dirFd, buffer, sizeof(buffer));
+    if (len <= 0) {
+      if (len < 0) count = -1;
+      break;
+    }
+    for (long offset = 0; offset < len;) {
+      const auto* entry = reinterpret_cast<const linuxDirent64*>(buffer + offset);
+      offset += entry->d_reclen;
+      if (entry->d_name[0] == '.') continue;  // "." and ".."
+      ++count;
+      if (sockets == nullptr) continue;
+      // Sockets link to "socket:[<inode>]"
+      char target[16];
+      ssize_t targetLen =
+          readlinkat(dirFd, entry->d_name, target, sizeof(target));
+      if (targetLen >= 7 && std::memcmp(target, "socket:", 7) == 0) {
+        ++*sockets;
+      }
+    }
+  }
+  int error = errno;
+  close(dirFd);
+  errno = error;
+  return count;
+}
+
+int ProcBatchReader::openTaskDir(int procDirFd, pid_t pid) {
+  char path[PROC_READER_PATH_SIZE];
+  formatPath(path, pid, "task");
+  return openat(procDirFd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+int ProcBatchReader::readTaskIds(int dirFd, pid_t* tids) {
+  alignas(linuxDirent64) char entries[PROC_READER_TASK_IDS * 24];
+  int count = 0;
+  // A call may return nothing but "." and "..", which is not the end yet
+  while (count == 0) {
+    long len = syscall(SYS_getdents64, dirFd, entries, sizeof(entries));
+    if (len <= 0) return len < 0 ? -1 : 0;
+    for (long offset = 0; offset < len;) {
+      const auto* entry =
+          reinterpret_cast<const linuxDirent64*>(entries + offset);
+      offset += entry->d_reclen;
+      if (entry->d_name[0] == '.') continue;  // "." and ".."
+      pid_t tid = 0;
+      std::from_chars(entry->d_name, entry->d_name + strlen(entry->d_name),
+                      tid);
+      tids[count++] = tid;
+    }
+  }
+  return count;
+}
+
+void ProcBatchReader::readChunkSync(const pid_t* pids, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    std::string_view stat =
+        ReadFile(procDirFd_, pids[i], "stat",
+                 &statBuffers_[i * PROC_READER_STAT_SIZE], PROC_READER_STAT_SIZE);
+    std::string_view status = ReadFile(
+        procDirFd_, pids[i], "status",
+        &statusBuffers_[i * PROC_READER_STATUS_SIZE], PROC_READER_STATUS_SIZE);
+    lengths_[i * 2] = static_cast<int>(stat.size());
+    lengths_[i * 2 + 1] = static_cast<int>(status.size());
+  }
+}
+
+#ifdef MONITOR_HAVE_IO_URING
+
+static char* slotBuffer(std::vector<char>& statBuffers,
+                        std::vector<char>& statusBuffers, size_t slot) {
+  size_t pidIdx = slot / 2;
+  return slot % 2 == 0 ? &statBuffers[pidIdx * PROC_READER_STAT_SIZE]
+                       : &statusBuffers[pidIdx * PROC_READER_STATUS_SIZE];
+}
+
+bool ProcBatchReader::readChunkIoUring(const pid_t* pids, size_t count) {
+  size_t slots = count * 2;
+  unsigned tail = *ring_->sqTail;
+
+  // Phase 1: open every file of the chunk relative to the /proc dirfd
+  for (size_t slot = 0; slot < slots; ++slot) {
+    char* path = &paths_[slot * PROC_READER_PATH_SIZE];
+    formatPath(path, pids[slot / 2], slot % 2 == 0 ? "stat" : "status");
+    io_uring_sqe* sqe = ring_->NextSqe(tail);
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = procDirFd_;
+    sqe->addr = reinterpret_cast<uint64_t>(path);
+    sqe->open_flags = O_RDONLY | O_CLOEXEC;
+    sqe->user_data = slot;
+  }
+  bool ok = ring_->SubmitAndReap(
+      tail, slots, [&](uint64_t slot, int res) { fds_[slot] = res; });
+  if (!ok) {
+    closeSlots(slots);
+    return false;
+  }
+
+  // Phase 2: read each opened file, hard-linked to its close so that a failed
+  // read still releases the descriptor. A slot keeps its descriptor until the
+  // close completed.
+  unsigned queued = 0;
+  for (size_t slot = 0; slot < slots; ++slot) {
+    lengths_[slot] = 0;
+    if (fds_[slot] < 0) continue;
+    io_uring_sqe* sqe = ring_->NextSqe(tail);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fds_[slot];
+    sqe->addr = reinterpret_cast<uint64_t>(
+        slotBuffer(statBuffers_, statusBuffers_, slot));
+    sqe->len = slotSize(slot) - 1;
+    sqe->off = 0;
+    sqe->flags = IOSQE_IO_HARDLINK;
+    sqe->user_data = slot;
+
+    sqe = ring_->NextSqe(tail);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fds_[slot];
+    sqe->user_data = PROC_READER_SLOTS + slot;
+    queued += 2;
+  }
+  if (queued == 0) return true;
+  ok = ring_->SubmitAndReap(tail, queued, [&](uint64_t slot, int res) {
+    if (slot < PROC_READER_SLOTS) {
+      lengths_[slot] = std::max(res, 0);
+    } else {
+      fds_[slot - PROC_READER_SLOTS] = -1;
+    }
+  });
+  if (!ok) closeSlots(slots);
+  return ok;
+}
+
+// Closes what the ring left open after a failure: opens it reaped, and files
+// whose close was never submitted
+void ProcBatchReader::closeSlots(size_t slots) {
+  for (size_t slot = 0; slot < slots; ++slot) {
+    if (fds_[slot] >= 0) close(fds_[slot]);
+    fds_[slot] = -1;
+  }
+}
+
+#else
+
+bool ProcBatchReader::readChunkIoUring(const pid_t*, size_t) { return false; }
+
+#endif
+
+void ProcBatchReader::ReadBatch(const std::vector<pid_t>& pids,
+                                const Callback& callback,
+                                const std::atomic<bool>* stop) {
+  for (size_t start = 0; start < pids.size();
+       start += PROC_READER_CHUNK_PIDS) {
+    if (stop != nullptr && *stop) return;
+    size_t count = std::min<size_t>(PROC_READER_CHUNK_PIDS, pids.size() - start);
+    if (!ring_ || !readChunkIoUring(&pids[start], count)) {
+      // Drop to the synchronous path for good once the ring misbehaves
+      ring_.reset();
+      readChunkSync(&pids[start], count);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      std::string_view stat(&statBuffers_[i * PROC_READER_STAT_SIZE],
+                            lengths_[i * 2]);
+      std::string_view status(&statusBuffers_[i * PROC_READER_STATUS_SIZE],
+                              lengths_[i * 2 + 1]);
+      callback(start + i, stat, status);
+    }
+  }
+}
@@ -8,24 +8,48 @@
 #include "linux_parser.h"
 #include "globals.h"
 
-Process::Process(pid_t pid) {
+Process::Process(pid_t pid, const LinuxParser::procStatFileData& statData,
+                 const LinuxParser::procStatusFileData& statusData,
+                 unsigned long long totalSystemJiffies,
+                 std::chrono::steady_clock::time_point now,
+                 std::string_view comm) {
 
   this->pid_ = pid;
-  this->user_ = LinuxParser::Uid(pid);
-  this->_lastUpdate = std::chrono::steady_clock::now();
-  this->_command = LinuxParser::Command(pid);
+  this->user_ = LinuxParser::UserName(statusData.uid);
+  this->_is_kernel_process = statData.flags & PROC_FLAG_KTHREAD;
+  if (!this->_is_kernel_process) {
+    this->_command = LinuxParser::Command(pid, Globals::CmdlineMaxLength());
+  }
   if (this->_command.empty()) {
-    this->_is_kernel_process = true;
+    this->_command.reserve(comm.size() + 2);
+    this->_command.append("[").append(comm).append("]");
   }
 
-  std::vector<struct CPUDataWithHistory> totalCpuUtilizationValues =
-      LinuxParser::totalCpuUtilization();
-  this->_lastTotalSystemJiffies = totalCpuUtilizationValues[0].current.totaltime;
+  this->_lastTotalSystemJiffies = totalSystemJiffies;
 
-  _updateProcStatFileData();
-  _updateProcStatusFileData();
+  _updateProcStatFileData(statData);
+  _updateProcStatusFileData(statusData);
   this->_lastActiveJiffies = this->_utime + this->_stime;
   this->_cpuUtilization = 0.0f;
+  this->_ctxtTime = now;
+  this->_voluntaryCtxt = statusData.voluntaryCtxtSwitches;
+  this->_nonvoluntaryCtxt = statusData.nonvoluntaryCtxtSwitches;
+}
+
+Process::Process(pid_t pid, std::string user, std::string command)
+    : pid_(pid), user_(std::move(user)), _command(std::move(command)) {
+  this->_cgroupRead = true;  // not part of recordings
+  this->_lastActiveJiffies = 0;
+  this->_lastTotalSystemJiffies = 0;
+  this->_cpuUtilization = 0.0f;
+}
+
+void Process::Restore(const LinuxParser::procStatFileData& statData,
+                      const LinuxParser::procStatusFileData& statusData,
+                      float cpuUtilization) {
+  _updateProcStatFileData(statData);
+  _updateProcStatusFileData(statusData);
+  this->_cpuUtilization = cpuUtilization;
 }
 
 int Process::Pid() { return this->pid_; }
@@ -34,9 +58,7 @@ int Process::Pid() { return this->pid_; }
 #define CLAMP(x,low,high) (((x)>(high))?(high):(((x)<(low))?(low):(x)))
 #endif
 
-float Process::CpuUtilization(bool allowUpdate) {
-  if (allowUpdate)
-    _isUpdateNeeded();
+float Process::CpuUtilization() {
   return this->_cpuUtilization;
 }
 
@@ -45,88 +67,236 @@ const std::string& Process::Command() {
 }
 
 const ProcessMemUtilization& Process::MemUtilization() {
-  _isUpdateNeeded();
   return *_memUtilization;
 }
 
-std::string Process::User() { return this->user_; }
+const std::string& Process::User() { return this->user_; }
 
 double Process::UpTime() {
-  _isUpdateNeeded();
-  return (double)(this->_utime + this->_stime) / sysconf(_SC_CLK_TCK);
+  static const long clockTicks = sysconf(_SC_CLK_TCK);
+  return (double)(this->_utime + this->_stime) / clockTicks;
 }
 
 bool Process::isKernelProcess() {
   return this->_is_kernel_process;
 }
 
-bool Process::_isUpdateNeeded() {
-  auto now = std::chrono::steady_clock::now();
-  if (now - _lastUpdate >= std::chrono::milliseconds(GLOBAL_REFRESH_RATE)) {
-    _updateProcStatFileData();
-    _updateProcStatusFileData();
-    _updateCpuUtilization();
-    _lastUpdate = now;
-    return true;
+unsigned long long Process::StartTime() {
+  return this->_starttime;
+}
+
+unsigned long Process::ActiveJiffies() {
+  return this->_utime + this->_stime;
+}
+
+// The cgroup is read once, the first time somebody asks for it
+const std::string& Process::Cgroup() {
+  if (!this->_cgroupRead) {
+    this->_cgroup = LinuxParser::Cgroup(this->pid_);
+    this->_cgroupRead = true;
   }
-  return false;
+  return this->_cgroup;
+}
+
+void Process::Update(const LinuxParser::procStatFileData& statData,
+                     const LinuxParser::procStatusFileData& statusData,
+                     unsigned long long totalSystemJiffies, int numCpus,
+                     std::chrono::steady_clock::time_point now) {
+  _updateProcStatFileData(statData);
+  _updateProcStatusFileData(statusData);
+  _updateCpuUtilization(totalSystemJiffies, numCpus);
+  _updateCtxtRates(statusData, now);
 }
 
-void Process::_updateProcStatFileData() {
-  struct LinuxParser::procStatFileData procStatFileData =
-      LinuxParser::parseProcStatFilePid(this->pid_);
+void Process::_updateCtxtRates(const LinuxParser::procStatusFileData& data,
+                               std::chrono::steady_clock::time_point now) {
+  double seconds = std::chrono::duration<double>(now - this->_ctxtTime).count();
+  if (seconds <= 0) return;
+  auto rate = [seconds](uint64_t current, uint64_t previous) {
+    return current >= previous ? (current - previous) / seconds : 0.0;
+  };
+  this->_voluntaryCtxtRate =
+      rate(data.voluntaryCtxtSwitches, this->_voluntaryCtxt);
+  this->_nonvoluntaryCtxtRate =
+      rate(data.nonvoluntaryCtxtSwitches, this->_nonvoluntaryCtxt);
+  this->_ctxtAvailable = true;
+  this->_ctxtTime = now;
+  this->_voluntaryCtxt = data.voluntaryCtxtSwitches;
+  this->_nonvoluntaryCtxt = data.nonvoluntaryCtxtSwitches;
+}
+
+bool Process::CtxtAvailable() { return this->_ctxtAvailable; }
+
+double Process::VoluntaryCtxtRate() { return this->_voluntaryCtxtRate; }
 
+double Process::NonvoluntaryCtxtRate() { return this->_nonvoluntaryCtxtRate; }
+
+bool Process::SchedAvailable() { return this->_schedAvailable; }
+
+double Process::WaitPercent() { return this->_waitPercent; }
+
+void Process::UpdateSchedstat(const LinuxParser::procSchedstatData& schedData,
+                              bool summed,
+                              std::chrono::steady_clock::time_point now) {
+  double seconds = std::chrono::duration<double>(now - this->_schedTime).count();
+  if (this->_schedSampled && this->_schedSummed == summed && seconds > 0) {
+    uint64_t waitNs = schedData.waitNs >= this->_waitNs
+                          ? schedData.waitNs - this->_waitNs
+                          : 0;
+    this->_waitPercent = waitNs / (seconds * 1e9) * 100.0;
+    this->_schedAvailable = true;
+  }
+  this->_schedSampled = true;
+  this->_schedSummed = summed;
+  this->_schedTime = now;
+  this->_waitNs = schedData.waitNs;
+}
+
+void Process::_updateProcStatFileData(
+    const LinuxParser::procStatFileData& procStatFileData) {
   this->_nice_value = procStatFileData.niceval;
   this->_priority_value = procStatFileData.priorityval;
   this->_state = procStatFileData.state;
   this->_utime = procStatFileData.utime;
   this->_stime = procStatFileData.stime;
+  this->_starttime = procStatFileData.starttime;
 }
 
-void Process::_updateProcStatusFileData() {
-  LinuxParser::procStatusFileData data = LinuxParser::parseProcStatusFilePid(pid_);
-  this->_memUtilization = std::make_unique<ProcessMemUtilization>(
-      data.memData);
+void Process::_updateProcStatusFileData(
+    const LinuxParser::procStatusFileData& data) {
+  if (!_memUtilization) {
+    _memUtilization = std::make_unique<ProcessMemUtilization>();
+  }
+  *_memUtilization = data.memData;
   this->_numThreads = data.numThreads;
 }
 
 long Process::NiceValue() {
-  _isUpdateNeeded();
   return this->_nice_value;
 }
 
 long Process::PriorityValue() {
-  _isUpdateNeeded();
   return this->_priority_value;
 }
 
 char Process::State() {
-  _isUpdateNeeded();
   return this->_state;
 }
 
 unsigned int Process::getNumThreads() {
-  _isUpdateNeeded();
   return this->_numThreads;
 }
 
-void Process::_updateCpuUtilization() {
+void Process::_updateCpuUtilization(unsigned long long totalSystemJiffies,
+                                    int numCpus) {
   unsigned long currActiveJiffies = this->_utime + this->_stime;
   unsigned long deltaActiveJiffies = currActiveJiffies - _lastActiveJiffies;
 
-  // Retrieve and cache total CPU usage (global) every cache duration period
-  const std::vector<struct CPUDataWithHistory>& currTotalCpuUtilizationValues =
-      LinuxParser::totalCpuUtilization();  // Uses cached global data
-  unsigned long currTotalCpuUtilization = currTotalCpuUtilizationValues[0].current.totaltime;
-  int num_cpus = std::max(1, (int)currTotalCpuUtilizationValues.size() - 1);
+  // The global counters are cached; an unchanged total means no new sample
+  if (totalSystemJiffies <= _lastTotalSystemJiffies) {
+    return;
+  }
 
   // Calculate CPU usage as a ratio of the process' delta to system delta
   float usage = static_cast<float>(deltaActiveJiffies) /
-                (currTotalCpuUtilization - _lastTotalSystemJiffies) * num_cpus * 100.0;
-  usage = CLAMP(usage, 0.0, 100.0 * num_cpus);
+                (totalSystemJiffies - _lastTotalSystemJiffies) * numCpus * 100.0;
+  usage = CLAMP(usage, 0.0, 100.0 * numCpus);
 
   // Update the last recorded values
-  _lastTotalSystemJiffies = currTotalCpuUtilization;
+  _lastTotalSystemJiffies = totalSystemJiffies;
   _lastActiveJiffies = currActiveJiffies;
   this->_cpuUtilization = usage;
 }
+
+bool Process::IoAvailable() { return this->_ioAvailable; }
+
+double Process::IoReadRate() { return this->_ioReadRate; }
+
+double Process::IoWriteRate() { return this->_ioWriteRate; }
+
+double Process::IoSyscallRate() { return this->_ioSyscallRate; }
+
+bool Process::IoDenied() { return this->_ioDenied; }
+
+void Process::UpdateIo(const LinuxParser::procIoFileData& ioData,
+                       std::chrono::steady_clock::time_point now) {
+  // Written bytes whose dirty pages were dropped before reaching the disk
+  // (e.g. truncated files) do not count
+  uint64_t writeBytes = ioData.writeBytes > ioData.cancelledWriteBytes
+                            ? ioData.writeBytes - ioData.cancelledWriteBytes
+                            : 0;
+  uint64_t syscalls = ioData.syscr + ioData.syscw;
+
+  double seconds = std::chrono::duration<double>(now - this->_ioTime).count();
+  if (this->_ioSampled && seconds > 0) {
+    auto rate = [seconds](uint64_t current, uint64_t previous) {
+      return current >= previous ? (current - previous) / seconds : 0.0;
+    };
+    this->_ioReadRate = rate(ioData.readBytes, this->_ioReadBytes);
+    this->_ioWriteRate = rate(writeBytes, this->_ioWriteBytes);
+    this->_ioSyscallRate = rate(syscalls, this->_ioSyscalls);
+    this->_ioAvailable = true;
+  }
+
+  this->_ioSampled = true;
+  this->_ioTime = now;
+  this->_ioReadBytes = ioData.readBytes;
+  this->_ioWriteBytes = writeBytes;
+  this->_ioSyscalls = syscalls;
+}
+
+void Process::DenyIo() { this->_ioDenied = true; }
+
+std::chrono::steady_clock::time_point Process::PassTime() {
+  return this->_passTime;
+}
+
+void Process::SetPassTime(std::chrono::steady_clock::time_point now) {
+  this->_passTime = now;
+}
+
+bool Process::SmapsAvailable() { return this->_smapsAvailable; }
+
+uint64_t Process::Pss() { return this->_pss; }
+
+uint64_t Process::Uss() { return this->_uss; }
+
+bool Process::SmapsDenied() { return this->_smapsDenied; }
+
+void Process::UpdateSmaps(const LinuxParser::procSmapsRollupData& smapsData) {
+  this->_pss = smapsData.pss;
+  // Pages no other process maps, i.e. what killing the process frees
+  this->_uss = smapsData.privateClean + smapsData.privateDirty +
+               smapsData.privateHugetlb;
+  this->_smapsAvailable = true;
+}
+
+void Process::DenySmaps() { this->_smapsDenied = true; }
+
+bool Process::FdAvailable() { return this->_fdAvailable; }
+
+int Process::FdCount() { return this->_fdCount; }
+
+uint64_t Process::FdLimit() { return this->_fdLimit; }
+
+double Process::FdUsage() {
+  return this->_fdLimit ? (double)this->_fdCount / this->_fdLimit : 0.0;
+}
+
+bool Process::SocketsAvailable() { return this->_socketsAvailable; }
+
+int Process::SocketCount() { return this->_socketCount; }
+
+bool Process::FdDenied() { return this->_fdDenied; }
+
+void Process::UpdateFds(int count, int sockets, uint64_t limit) {
+  this->_fdCount = count;
+  this->_fdLimit = limit;
+  this->_fdAvailable = true;
+  if (sockets >= 0) {
+    this->_socketCount = sockets;
+    this->_socketsAvailable = true;
+  }
+}
+
+void Process::DenyFds() { this->_fdDenied = true; }
@@ -0,0 +1,123 @@
+#include "process_filter.h"
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Never part of a query, so user and command cannot match as one string
+#define FILTER_FIELD_SEPARATOR '\x01'
+
+static inline char ToLower(char c) {
+  return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+// First position of `needle` (k >= 1 bytes) in `haystack`, or npos. With SSE2
+// the first and last byte of the needle are compared against 16 positions at
+// once and only positions where both match are verified.
+static size_t FindBytes(const char* haystack, size_t n, const char* needle,
+                        size_t k) {
+  if (k > n) return std::string_view::npos;
+  if (k == 1) {
+    const void* hit = std::memchr(haystack, needle[0], n);
+    return hit ? static_cast<const char*>(hit) - haystack
+               : std::string_view::npos;
+  }
+
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[k - 1]);
+  for (; i + k - 1 + 16 <= n; i += 16) {
+    __m128i blockFirst =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+    __m128i blockLast = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(haystack + i + k - 1));
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast)));
+    while (mask != 0) {
+      unsigned bit = __builtin_ctz(mask);
+      if (std::memcmp(haystack + i + bit + 1, needle + 1, k - 2) == 0) {
+        return i + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+#endif
+  for (; i + k <= n; ++i) {
+    if (haystack[i] == needle[0] &&
+        std::memcmp(haystack + i + 1, needle + 1, k - 1) == 0) {
+      return i;
+    }
+  }
+  return std::string_view::npos;
+}
+
+void ProcessFilter::Clear() {
+  arena_.clear();
+  offsets_.assign(1, 0);
+  matches_.clear();
+  valid_ = false;
+}
+
+void ProcessFilter::Add(std::string_view user, std::string_view command) {
+  for (char c : user) arena_.push_back(ToLower(c));
+  arena_.push_back(FILTER_FIELD_SEPARATOR);
+  for (char c : command) arena_.push_back(ToLower(c));
+  offsets_.push_back(arena_.size());
+}
+
+const std::vector<uint32_t>& ProcessFilter::Apply(std::string_view query) {
+  std::string lowered(query);
+  for (char& c : lowered) c = ToLower(c);
+
+  // A longer query can only match a subset of what the shorter one matched
+  bool narrowing = valid_ && lowered.compare(0, query_.size(), query_) == 0;
+  candidates_.swap(matches_);
+  matches_.clear();
+  const size_t entries = Size();
+
+  if (lowered.empty()) {
+    for (uint32_t i = 0; i < entries; ++i) matches_.push_back(i);
+  } else if (narrowing) {
+    for (uint32_t i : candidates_) {
+      if (FindBytes(arena_.data() + offsets_[i], offsets_[i + 1] - offsets_[i],
+                    lowered.data(), lowered.size()) != std::string_view::npos) {
+        matches_.push_back(i);
+      }
+    }
+  } else {
+    // One pass over the whole arena; every hit skips the rest of its entry
+    size_t position = 0;
+    uint32_t entry = 0;
+    while (entry < entries) {
+      size_t hit = FindBytes(arena_.data() + position, arena_.size() - position,
+                             lowered.data(), lowered.size());
+      if (hit == std::string_view::npos) break;
+      hit += position;
+      while (offsets_[entry + 1] <= hit) ++entry;
+      // A match that runs into the next entry does not count
+      if (hit + lowered.size() <= offsets_[entry + 1]) {
+        matches_.push_back(entry);
+        position = offsets_[++entry];
+      } else {
+        position = hit + 1;
+      }
+    }
+  }
+
+  query_ = std::move(lowered);
+  valid_ = true;
+  return matches_;
+}
+
+size_t ProcessFilter::Find(std::string_view text, std::string_view query) {
+  if (query.empty() || query.size() > text.size()) return std::string_view::npos;
+  for (size_t i = 0; i + query.size() <= text.size(); ++i) {
+    size_t j = 0;
+    while (j < query.size() && ToLower(text[i + j]) == ToLower(query[j])) ++j;
+    if (j == query.size()) return i;
+  }
+  return std::string_view::npos;
+}
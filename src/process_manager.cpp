@@ -1,84 +1,213 @@
 #include "process_manager.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <thread>
 
 #include "globals.h"
 #include "linux_parser.h"
 #include "process.h"
-
-// Create a new process if not found in the existing map
-void ProcessManager::AddProcessIfNotExists(pid_t pid) {
-
-  auto it = processMap_.find(pid);
-  if (it == processMap_.end()) {
-    // Add new process to map
-    std::shared_ptr<Process> newProcess = std::make_shared<Process>(pid);
-    if (!newProcess->isKernelProcess())
-      processMap_.emplace(pid, newProcess);
-  }
-}
+#include "processor.h"
 
 // Remove stale processes not found in the current `/proc` scan
 void ProcessManager::CleanupStaleProcesses(const std::vector<int>& currentPids) {
   std::unordered_map<pid_t, std::shared_ptr<Process>> updatedMap;
+  std::unordered_set<pid_t> updatedKernelThreads;
 
   for (pid_t pid : currentPids) {
     if (processMap_.find(pid) != processMap_.end()) {
       // Retain only active processes
       updatedMap.emplace(pid, processMap_.find(pid)->second);
     }
+    if (kernelThreads_.count(pid)) {
+      updatedKernelThreads.insert(pid);
+    }
   }
 
   processMap_ = std::move(updatedMap);
+  kernelThreads_ = std::move(updatedKernelThreads);
 }
 
 // Update all processes by iterating through available PIDs
-void ProcessManager::UpdateProcesses() {
+bool ProcessManager::UpdateProcesses(bool force) {
   auto now = std::chrono::steady_clock::now();
   auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
                      now - lastUpdateTime_).count();
 
-  if (elapsed < GLOBAL_REFRESH_RATE) {
-    // Skip the update if less than 1500 ms have passed
-    return;
+  if ((!force && elapsed < Globals::RefreshRate()) || cancelled_) {
+    // Skip the update if less than one refresh interval has passed
+    return false;
   }
+  uint32_t due = scheduler_.NextTick();
   // this should contain all PIDs currently in /proc
   std::vector<pid_t> currentPids = LinuxParser::Pids();
 
-  // Update or add all current processes
-  for (pid_t pid : currentPids) {
-    AddProcessIfNotExists(pid);
+  const std::vector<struct CPUDataWithHistory>& cpuData =
+      LinuxParser::totalCpuUtilization(force);
+  unsigned long long totalSystemJiffies = cpuData[0].current.totaltime;
+  int numCpus = std::max(1, (int)cpuData.size() - 1);
+
+  // Known kernel threads skip the batch, except on the ticks that check
+  // them again
+  const std::vector<pid_t>* batch = &currentPids;
+  bool recheck = kernelThreadTick_++ % SAMPLE_SLOW_TIER_TICKS == 0;
+  if (!kernelThreads_.empty() && !recheck) {
+    batchPids_.clear();
+    for (pid_t pid : currentPids) {
+      if (kernelThreads_.find(pid) == kernelThreads_.end()) {
+        batchPids_.push_back(pid);
+      }
+    }
+    batch = &batchPids_;
   }
 
+  // Sample stat and status of every PID in one batch, then update existing
+  // processes or create new ones from the buffers
+  procReader_.ReadBatch(
+      *batch,
+      [&](size_t index, std::string_view stat, std::string_view status) {
+        if (stat.empty() || status.empty()) {
+          return;  // the process exited in the meantime
+        }
+        pid_t pid = (*batch)[index];
+        LinuxParser::procStatFileData statData =
+            LinuxParser::parseProcStatBuffer(stat);
+        if (!showKernelThreads_) {
+          if (statData.flags & PROC_FLAG_KTHREAD) {
+            kernelThreads_.insert(pid);
+            return;
+          }
+          kernelThreads_.erase(pid);  // the PID got reused
+        }
+        LinuxParser::procStatusFileData statusData =
+            LinuxParser::parseProcStatusBuffer(status);
+
+        auto it = processMap_.find(pid);
+        if (it != processMap_.end() &&
+            it->second->StartTime() == statData.starttime) {
+          it->second->Update(statData, statusData, totalSystemJiffies,
+                             numCpus, now);
+          return;
+        }
+        // New process, or the PID got reused since the last scan
+        if (it != processMap_.end()) {
+          processMap_.erase(it);
+        }
+        newProcesses_.push_back({pid, statData, statusData,
+                                 std::string(LinuxParser::parseProcStatComm(stat)),
+                                 nullptr});
+      },
+      &cancelled_);
+  _createProcesses(totalSystemJiffies, now);
+  if (cancelled_) return false;
+
   // Clean up stale processes not in `currentPids`
   CleanupStaleProcesses(currentPids);
   _numOfTasks = processMap_.size();
   _updateNumOfThreads();
+  if (cgroupTracking_) {
+    _updateCgroups();
+  }
+  if (due & SAMPLE_SOURCE_IO) {
+    _updateIo(now);
+  }
+  if (due & SAMPLE_SOURCE_SCHEDSTAT) {
+    _updateSchedstat(now);
+  }
+  uint32_t passSources = scheduler_.Wanted() & SAMPLE_SOURCES_PASS;
+  if (passSources) {
+    _updatePass(passSources, (due & passSources) || passRestart_, now);
+    passRestart_ = false;
+  } else {
+    passQueue_.clear();
+    passNext_ = 0;
+  }
   lastUpdateTime_ = now;
+  return true;
 }
 
 std::vector<std::shared_ptr<Process>> ProcessManager::
-    GetSortedProcessesForDisplay() {
+    GetSortedProcessesForDisplay(size_t limit) {
   std::vector<std::shared_ptr<Process>> sortedProcesses;
-  /*for (auto& [pid, process] : processMap_) {
-    sortedProcesses.push_back(process);
-  }*/
+  sortedProcesses.reserve(processMap_.size());
 
   for (const auto &it : processMap_) {
     sortedProcesses.push_back(it.second);
   }
 
-  std::sort(sortedProcesses.begin(), sortedProcesses.end(),
-            [] (const std::shared_ptr<Process>& l, const std::shared_ptr<Process>& r) {
-              if (std::abs(l->CpuUtilization(false) - r->CpuUtilization(false)) > 1e-3)
-                return l->CpuUtilization(false) > r->CpuUtilization(false);
-              return l->Pid() < r->Pid();
-            });
+  SortForDisplay(sortedProcesses, limit);
   return sortedProcesses;
 }
 
-ProcessManager::ProcessManager() {
-  UpdateProcesses();
+void ProcessManager::SortForDisplay(
+    std::vector<std::shared_ptr<Process>>& processes, size_t limit) {
+  auto byCpu = [] (const std::shared_ptr<Process>& l, const std::shared_ptr<Process>& r) {
+    if (std::abs(l->CpuUtilization() - r->CpuUtilization()) > 1e-3)
+      return l->CpuUtilization() > r->CpuUtilization();
+    return l->Pid() < r->Pid();
+  };
+
+  if (limit > 0 && limit < processes.size()) {
+    // Only the first `limit` entries are wanted
+    std::partial_sort(processes.begin(), processes.begin() + limit,
+                      processes.end(), byCpu);
+    processes.resize(limit);
+  } else {
+    std::sort(processes.begin(), processes.end(), byCpu);
+  }
+}
+
+ProcessManager::ProcessManager() {}
+
+void ProcessManager::SetScanThreads(unsigned int threads) {
+  scanThreads_ = std::max(1u, threads);
+}
+
+void ProcessManager::Cancel() { cancelled_ = true; }
+
+// Building a process reads its command line, which makes the first scan of
+// a host with tens of thousands of processes take seconds on one thread
+void ProcessManager::_createProcesses(
+    unsigned long long totalSystemJiffies,
+    std::chrono::steady_clock::time_point now) {
+  auto create = [&](NewProcess& entry) {
+    entry.process = std::make_shared<Process>(entry.pid, entry.stat,
+                                              entry.status, totalSystemJiffies,
+                                              now, entry.comm);
+  };
+
+  unsigned int threads = std::min<size_t>(
+      {scanThreads_, std::max(1u, std::thread::hardware_concurrency()),
+       newProcesses_.size() / PROCESS_PARALLEL_MIN});
+  if (threads <= 1) {
+    for (NewProcess& entry : newProcesses_) {
+      if (cancelled_) break;
+      create(entry);
+    }
+  } else {
+    // UserName() caches every user it looks up; with all of them looked up
+    // here first, the workers only read the cache
+    for (const NewProcess& entry : newProcesses_) {
+      LinuxParser::UserName(entry.status.uid);
+    }
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+      for (size_t i = next++; i < newProcesses_.size() && !cancelled_;
+           i = next++) {
+        create(newProcesses_[i]);
+      }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < threads; ++i) workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers) worker.join();
+  }
+
+  for (NewProcess& entry : newProcesses_) {
+    if (entry.process) processMap_.emplace(entry.pid, std::move(entry.process));
+  }
+  newProcesses_.clear();
 }
 
 unsigned int ProcessManager::getNumOfTasks() {
@@ -103,3 +232,195 @@ unsigned int ProcessManager::getNumOfThreads() {
 unsigned int ProcessManager::getNumOfRunningTasks() {
   return this->_numOfRunningTasks;
 }
+
+void ProcessManager::SetCgroupTracking(bool enabled) {
+  bool wasEnabled = cgroupTracking_;
+  cgroupTracking_ = enabled;
+  if (enabled && !wasEnabled) {
+    _updateCgroups();
+  }
+}
+
+bool ProcessManager::IsCgroupTrackingEnabled() {
+  return cgroupTracking_;
+}
+
+const CgroupManager& ProcessManager::Cgroups() {
+  return cgroupManager_;
+}
+
+void ProcessManager::_updateCgroups() {
+  std::unordered_map<std::string, unsigned int> processCounts;
+  for (const auto& it : processMap_) {
+    processCounts[it.second->Cgroup()]++;
+  }
+  cgroupManager_.Update(processCounts);
+}
+
+void ProcessManager::SetWantedSources(uint32_t sources) {
+  uint32_t added = sources & ~scheduler_.Wanted() & SAMPLE_SOURCES_PASS;
+  scheduler_.SetWanted(sources);
+  if (added) {
+    // The pass in progress does not read the new sources; start over on the
+    // next tick instead of waiting for the slow tier
+    for (const auto& it : processMap_) {
+      it.second->SetPassTime(std::chrono::steady_clock::time_point());
+    }
+    passQueue_.clear();
+    passNext_ = 0;
+    passRestart_ = true;
+  }
+}
+
+void ProcessManager::SetVisiblePids(std::vector<pid_t> pids) {
+  visiblePids_ = std::move(pids);
+}
+
+void ProcessManager::SetShowKernelThreads(bool show) {
+  if (show == showKernelThreads_) return;
+  showKernelThreads_ = show;
+  if (show) {
+    // Read and added on the next tick
+    kernelThreads_.clear();
+  } else {
+    for (auto it = processMap_.begin(); it != processMap_.end();) {
+      if (it->second->isKernelProcess()) {
+        kernelThreads_.insert(it->first);
+        it = processMap_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
+bool ProcessManager::ShowKernelThreads() { return showKernelThreads_; }
+
+void ProcessManager::_updateIo(std::chrono::steady_clock::time_point now) {
+  char buffer[512];
+  for (const auto& [pid, process] : processMap_) {
+    // Kernel threads have no I/O accounting of their own
+    if (process->IoDenied() || process->isKernelProcess()) continue;
+    errno = 0;
+    std::string_view io = ProcBatchReader::ReadFile(
+        procReader_.ProcDirFd(), pid, "io", buffer, sizeof(buffer));
+    if (!io.empty()) {
+      process->UpdateIo(LinuxParser::parseProcIoBuffer(io), now);
+    } else if (errno == EACCES || errno == EPERM) {
+      // Other users' processes stay unreadable until the PID is reused
+      process->DenyIo();
+    }
+  }
+}
+
+// Multi-threaded processes are summed over their threads in the passes
+void ProcessManager::_updateSchedstat(
+    std::chrono::steady_clock::time_point now) {
+  char buffer[128];
+  for (const auto& [pid, process] : processMap_) {
+    if (process->getNumThreads() > 1) continue;
+    std::string_view schedstat = ProcBatchReader::ReadFile(
+        procReader_.ProcDirFd(), pid, "schedstat", buffer, sizeof(buffer));
+    if (!schedstat.empty()) {
+      process->UpdateSchedstat(LinuxParser::parseProcSchedstatBuffer(schedstat),
+                               false, now);
+    }
+  }
+}
+
+// A pass reads the expensive `sources` of every process once, the visible
+// ones first, within SAMPLE_PASS_BUDGET_US per tick. Visible processes never
+// read before (e.g. scrolled into view) are read on any tick.
+void ProcessManager::_updatePass(uint32_t sources, bool due,
+                                 std::chrono::steady_clock::time_point now) {
+  if (due) {
+    // Continue with what the previous pass did not get to, or start over
+    std::vector<pid_t> queue = visiblePids_;
+    if (passNext_ < passQueue_.size()) {
+      queue.insert(queue.end(), passQueue_.begin() + passNext_,
+                   passQueue_.end());
+    } else {
+      for (const auto& it : processMap_) queue.push_back(it.first);
+    }
+    passQueue_.swap(queue);
+    passNext_ = 0;
+    passStart_ = now;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::microseconds(SAMPLE_PASS_BUDGET_US);
+  // Reads `pid` unless the current pass already did; false once the budget
+  // is spent
+  auto read = [&](pid_t pid, bool unread) {
+    auto it = processMap_.find(pid);
+    // Kernel threads have no user memory and no descriptors
+    if (it == processMap_.end() || it->second->isKernelProcess()) return true;
+    Process& process = *it->second;
+    auto passTime = process.PassTime();
+    if (unread ? passTime != std::chrono::steady_clock::time_point()
+               : passTime >= passStart_) {
+      return true;
+    }
+    _readPassSources(process, sources, now);
+    process.SetPassTime(now);
+    return std::chrono::steady_clock::now() < deadline;
+  };
+
+  for (pid_t pid : visiblePids_) {
+    if (!read(pid, true)) return;
+  }
+  while (passNext_ < passQueue_.size()) {
+    if (!read(passQueue_[passNext_++], false)) return;
+  }
+}
+
+// Other users' files stay unreadable until the PID is reused
+void ProcessManager::_readPassSources(
+    Process& process, uint32_t sources,
+    std::chrono::steady_clock::time_point now) {
+  char buffer[2048];
+  int procDirFd = procReader_.ProcDirFd();
+  pid_t pid = process.Pid();
+
+  if ((sources & SAMPLE_SOURCE_SMAPS) && !process.SmapsDenied()) {
+    errno = 0;
+    std::string_view smaps = ProcBatchReader::ReadFile(
+        procDirFd, pid, "smaps_rollup", buffer, sizeof(buffer));
+    if (!smaps.empty()) {
+      process.UpdateSmaps(LinuxParser::parseProcSmapsRollupBuffer(smaps));
+    } else if (errno == EACCES || errno == EPERM) {
+      process.DenySmaps();
+    }
+  }
+
+  if ((sources & (SAMPLE_SOURCE_FD | SAMPLE_SOURCE_SOCKETS)) &&
+      !process.FdDenied()) {
+    int sockets = -1;
+    errno = 0;
+    int count = ProcBatchReader::CountFds(
+        procDirFd, pid, (sources & SAMPLE_SOURCE_SOCKETS) ? &sockets : nullptr);
+    if (count >= 0) {
+      std::string_view limits = ProcBatchReader::ReadFile(
+          procDirFd, pid, "limits", buffer, sizeof(buffer));
+      process.UpdateFds(count, sockets,
+                        LinuxParser::parseProcLimitsNoFile(limits));
+    } else if (errno == EACCES || errno == EPERM) {
+      process.DenyFds();
+    }
+  }
+
+  // /proc/<pid>/schedstat only counts the main thread
+  if ((sources & SAMPLE_SOURCE_TASKS) && process.getNumThreads() > 1) {
+    LinuxParser::procSchedstatData total{};
+    bool listed = ProcBatchReader::ReadTaskFiles(
+        procDirFd, pid, "schedstat", buffer, sizeof(buffer),
+        [&total](std::string_view schedstat) {
+          LinuxParser::procSchedstatData thread =
+              LinuxParser::parseProcSchedstatBuffer(schedstat);
+          total.runNs += thread.runNs;
+          total.waitNs += thread.waitNs;
+          total.timeslices += thread.timeslices;
+        });
+    if (listed) process.UpdateSchedstat(total, true, now);
+  }
+}
@@ -0,0 +1,806 @@
+#include "recording.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+#include "disk_stats.h"
+#include "linux_parser.h"
+#include "process.h"
+#include "process_manager.h"
+#include "system.h"
+
+#define RECORDING_MAGIC "MONREC01"
+#define RECORDING_INDEX_MAGIC "MONIDX01"
+#define RECORDING_MAGIC_SIZE 8
+#define RECORDING_TRAILER_SIZE 16
+#define RECORDING_KEYFRAME_INTERVAL 60
+#define RECORDING_SEEK_SECONDS 60
+
+#define FRAME_KEY 'K'
+#define FRAME_DELTA 'D'
+#define FRAME_INDEX 'I'
+
+// Layout of the system values of a frame
+#define SYS_TIMESTAMP 0
+#define SYS_UPTIME 1
+#define SYS_LOAD 2  // three values, in hundredths
+#define SYS_TASKS 5
+#define SYS_THREADS 6
+#define SYS_RUNNING 7
+#define SYS_MEM 8  // the ten MemData fields
+#define SYS_NUM_CPUS 18
+#define SYS_CPU 19  // CPU_FIELDS per entry, total first
+#define CPU_FIELDS 11
+// After the CPUs: the number of disks, then DISK_FIELDS per disk (absent in
+// older recordings). The name comes first, 8 bytes per value.
+#define DISK_NAME_WORDS 4
+#define DISK_FIELDS (DISK_NAME_WORDS + 9)
+
+namespace Recording {
+
+// Varint (LEB128) and zigzag encoding
+
+static void AppendVarint(OutputBuffer& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.Append(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.Append(static_cast<char>(value));
+}
+
+static void AppendSigned(OutputBuffer& out, int64_t value) {
+  AppendVarint(out, (static_cast<uint64_t>(value) << 1) ^
+                        static_cast<uint64_t>(value >> 63));
+}
+
+static void AppendString(OutputBuffer& out, const std::string& text) {
+  AppendVarint(out, text.size());
+  out.Append(text);
+}
+
+// Bounds checked reader over a decoded payload
+class Reader {
+ public:
+  Reader(const char* data, size_t size) : data_(data), size_(size) {}
+
+  uint64_t Varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (pos_ >= size_) {
+        ok_ = false;
+        return 0;
+      }
+      uint8_t byte = static_cast<uint8_t>(data_[pos_++]);
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) return value;
+    }
+    ok_ = false;
+    return value;
+  }
+
+  int64_t Signed() {
+    uint64_t value = Varint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+
+  std::string String() {
+    uint64_t length = Varint();
+    if (!ok_ || length > size_ - pos_) {
+      ok_ = false;
+      return {};
+    }
+    std::string text(data_ + pos_, length);
+    pos_ += length;
+    return text;
+  }
+
+  bool Ok() const { return ok_; }
+  size_t Position() const { return pos_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t pos_ = 0;
+  bool ok_ = true;
+};
+
+static bool ReadAt(int fd, uint64_t offset, char* buffer, size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t ret = pread(fd, buffer + done, size - done, offset + done);
+    if (ret <= 0) return false;
+    done += ret;
+  }
+  return true;
+}
+
+static void FillSystemValues(System& system, std::vector<int64_t>& values) {
+  const MemData& mem = system.MemoryUtilization();
+  const auto& cpuData = system.totalCpuUtilization();
+  const std::vector<Disk>& disks = system.Disks()->Disks();
+  size_t diskStart = SYS_CPU + cpuData.size() * CPU_FIELDS;
+  values.assign(diskStart + 1 + disks.size() * DISK_FIELDS, 0);
+
+  values[SYS_TIMESTAMP] = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::system_clock::now().time_since_epoch())
+                              .count();
+  values[SYS_UPTIME] = system.UpTime();
+  std::string loadAverage = system.LoadAverage();
+  const char* cursor = loadAverage.c_str();
+  for (int i = 0; i < 3; ++i) {
+    char* end;
+    values[SYS_LOAD + i] = std::llround(strtod(cursor, &end) * 100.0);
+    cursor = end;
+  }
+  values[SYS_TASKS] = system.getNumOfTasks();
+  values[SYS_THREADS] = system.getNumOfThreads();
+  values[SYS_RUNNING] = system.getNumOfRunningTasks();
+
+  const uint64_t memFields[] = {mem.memTotal,  mem.memFree,    mem.memAvailable,
+                                mem.buffers,   mem.cached,     mem.swapCached,
+                                mem.sReclaimable, mem.shmem,   mem.swapTotal,
+                                mem.swapFree};
+  for (int i = 0; i < 10; ++i) values[SYS_MEM + i] = memFields[i];
+
+  values[SYS_NUM_CPUS] = cpuData.size();
+  for (size_t i = 0; i < cpuData.size(); ++i) {
+    const CPUData& cpu = cpuData[i].current;
+    const uint64_t cpuFields[CPU_FIELDS] = {
+        cpu.usertime,  cpu.nicetime,    cpu.systemtime, cpu.idletime,
+        cpu.iowaittime, cpu.irqtime,    cpu.softirqtime, cpu.stealtime,
+        cpu.guesttime, cpu.guestnicetime, cpu.totaltime};
+    for (int j = 0; j < CPU_FIELDS; ++j) {
+      values[SYS_CPU + i * CPU_FIELDS + j] = cpuFields[j];
+    }
+  }
+
+  values[diskStart] = disks.size();
+  for (size_t i = 0; i < disks.size(); ++i) {
+    const LinuxParser::diskStatsData& disk = disks[i].counters;
+    int64_t* fields = &values[diskStart + 1 + i * DISK_FIELDS];
+    for (size_t byte = 0; byte < sizeof(disk.name); ++byte) {
+      fields[byte / 8] |= (int64_t)(uint8_t)disk.name[byte] << (byte % 8 * 8);
+    }
+    const uint64_t diskFields[] = {disk.reads,      disk.readSectors,
+                                   disk.readMs,     disk.writes,
+                                   disk.writeSectors, disk.writeMs,
+                                   disk.inFlight,   disk.ioMs,
+                                   disk.weightedMs};
+    for (int j = 0; j < DISK_FIELDS - DISK_NAME_WORDS; ++j) {
+      fields[DISK_NAME_WORDS + j] = diskFields[j];
+    }
+  }
+}
+
+static void FillProcessFields(Process& process, int64_t* fields) {
+  const ProcessMemUtilization& mem = process.MemUtilization();
+  fields[STATE] = process.State();
+  fields[PRIORITY] = process.PriorityValue();
+  fields[NICE] = process.NiceValue();
+  fields[START_TIME] = process.StartTime();
+  fields[ACTIVE_JIFFIES] = process.ActiveJiffies();
+  fields[VIRTUAL_MEM] = mem.virtual_mem;
+  fields[RESIDENT_MEM] = mem.resident_mem;
+  fields[SHARED_MEM] = mem.shared_mem;
+  fields[THREADS] = process.getNumThreads();
+  fields[CPU_PERMILLE] = std::llround(process.CpuUtilization() * 10.0);
+}
+
+static void AppendFullRecord(OutputBuffer& out, const ProcessRecord& record) {
+  AppendString(out, record.user);
+  AppendString(out, record.command);
+  for (int i = 0; i < NUM_PROCESS_FIELDS; ++i) {
+    AppendSigned(out, record.fields[i]);
+  }
+}
+
+static bool ReadFullRecord(Reader& reader, ProcessRecord& record) {
+  record.user = reader.String();
+  record.command = reader.String();
+  for (int i = 0; i < NUM_PROCESS_FIELDS; ++i) {
+    record.fields[i] = reader.Signed();
+  }
+  return reader.Ok();
+}
+
+// Recorder
+
+Recorder::~Recorder() { Close(); }
+
+bool Recorder::Open(const std::string& path, int intervalMs,
+                    const std::string& os, const std::string& kernel) {
+  fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    perror(("error while opening file " + path).c_str());
+    return false;
+  }
+
+  frame_.Clear();
+  frame_.Append(std::string_view(RECORDING_MAGIC, RECORDING_MAGIC_SIZE));
+  AppendVarint(frame_, intervalMs);
+  AppendString(frame_, os);
+  AppendString(frame_, kernel);
+  offset_ = frame_.Size();
+  return frame_.WriteTo(fd_);
+}
+
+bool Recorder::writeFrame(char kind) {
+  frame_.Clear();
+  frame_.Append(kind);
+  AppendVarint(frame_, payload_.Size());
+  frame_.Append(payload_.View());
+  if (!frame_.WriteTo(fd_)) {
+    perror("error while writing recording");
+    return false;
+  }
+  offset_ += frame_.Size();
+  return true;
+}
+
+bool Recorder::Append(System& system) {
+  if (fd_ < 0) return false;
+  bool keyframe = index_.size() % RECORDING_KEYFRAME_INTERVAL == 0;
+
+  FillSystemValues(system, systemValues_);
+  if (keyframe || previousSystemValues_.size() != systemValues_.size()) {
+    previousSystemValues_.assign(systemValues_.size(), 0);
+  }
+
+  payload_.Clear();
+  AppendVarint(payload_, systemValues_.size());
+  for (size_t i = 0; i < systemValues_.size(); ++i) {
+    AppendSigned(payload_, systemValues_[i] - previousSystemValues_[i]);
+  }
+
+  processes_ = system.processManager.GetSortedProcessesForDisplay();
+  std::sort(processes_.begin(), processes_.end(),
+            [](const std::shared_ptr<Process>& l,
+               const std::shared_ptr<Process>& r) { return l->Pid() < r->Pid(); });
+
+  if (keyframe) {
+    previousProcesses_.clear();
+    AppendVarint(payload_, processes_.size());
+    pid_t previousPid = 0;
+    for (const auto& process : processes_) {
+      ProcessRecord& record = previousProcesses_[process->Pid()];
+      record.user = process->User();
+      record.command = process->Command();
+      FillProcessFields(*process, record.fields);
+      AppendSigned(payload_, process->Pid() - previousPid);
+      previousPid = process->Pid();
+      AppendFullRecord(payload_, record);
+    }
+  } else {
+    // Merge the pid sorted process list with the previous frame
+    removed_.clear();
+    added_.clear();
+    changes_.Clear();
+    int64_t fields[NUM_PROCESS_FIELDS];
+    auto previous = previousProcesses_.begin();
+
+    pid_t previousChangedPid = 0;
+    size_t numChanged = 0;
+    for (const auto& process : processes_) {
+      pid_t pid = process->Pid();
+      while (previous != previousProcesses_.end() && previous->first < pid) {
+        removed_.push_back(previous->first);
+        previous = previousProcesses_.erase(previous);
+      }
+      FillProcessFields(*process, fields);
+
+      if (previous != previousProcesses_.end() && previous->first == pid) {
+        ProcessRecord& record = previous->second;
+        ++previous;
+        if (record.fields[START_TIME] != fields[START_TIME] ||
+            record.command != process->Command()) {
+          // Same PID, different process: replace it
+          removed_.push_back(pid);
+        } else {
+          uint64_t mask = 0;
+          for (int i = 0; i < NUM_PROCESS_FIELDS; ++i) {
+            if (record.fields[i] != fields[i]) mask |= 1u << i;
+          }
+          if (mask != 0) {
+            AppendSigned(changes_, pid - previousChangedPid);
+            previousChangedPid = pid;
+            AppendVarint(changes_, mask);
+            for (int i = 0; i < NUM_PROCESS_FIELDS; ++i) {
+              if (mask & (1u << i)) {
+                AppendSigned(changes_, fields[i] - record.fields[i]);
+                record.fields[i] = fields[i];
+              }
+            }
+            numChanged++;
+          }
+          continue;
+        }
+      }
+      added_.push_back(pid);
+      ProcessRecord& record = previousProcesses_[pid];
+      record.user = process->User();
+      record.command = process->Command();
+      std::copy(fields, fields + NUM_PROCESS_FIELDS, record.fields);
+    }
+    while (previous != previousProcesses_.end()) {
+      removed_.push_back(previous->first);
+      previous = previousProcesses_.erase(previous);
+    }
+
+    AppendVarint(payload_, removed_.size());
+    pid_t previousPid = 0;
+    for (pid_t pid : removed_) {
+      AppendSigned(payload_, pid - previousPid);
+      previousPid = pid;
+    }
+    AppendVarint(payload_, added_.size());
+    previousPid = 0;
+    for (pid_t pid : added_) {
+      AppendSigned(payload_, pid - previousPid);
+      previousPid = pid;
+      AppendFullRecord(payload_, previousProcesses_[pid]);
+    }
+    AppendVarint(payload_, numChanged);
+    payload_.Append(changes_.View());
+  }
+
+  index_.push_back({offset_, systemValues_[SYS_TIMESTAMP], keyframe});
+  previousSystemValues_.swap(systemValues_);
+  return writeFrame(keyframe ? FRAME_KEY : FRAME_DELTA);
+}
+
+bool Recorder::Close() {
+  if (fd_ < 0) return true;
+
+  payload_.Clear();
+  AppendVarint(payload_, index_.size());
+  IndexEntry previous{0, 0, false};
+  for (const IndexEntry& entry : index_) {
+    AppendVarint(payload_, entry.offset - previous.offset);
+    AppendSigned(payload_, entry.timestampMs - previous.timestampMs);
+    payload_.Append(static_cast<char>(entry.keyframe));
+    previous = entry;
+  }
+  uint64_t indexOffset = offset_;
+  bool ok = writeFrame(FRAME_INDEX);
+
+  // Fixed size trailer pointing at the index frame
+  char trailer[RECORDING_TRAILER_SIZE];
+  for (int i = 0; i < 8; ++i) {
+    trailer[i] = static_cast<char>(indexOffset >> (8 * i));
+  }
+  std::memcpy(trailer + 8, RECORDING_INDEX_MAGIC, RECORDING_MAGIC_SIZE);
+  frame_.Clear();
+  frame_.Append(std::string_view(trailer, RECORDING_TRAILER_SIZE));
+  ok = ok && frame_.WriteTo(fd_);
+
+  close(fd_);
+  fd_ = -1;
+  return ok;
+}
+
+static volatile sig_atomic_t stopRecording = 0;
+
+static void handleStopSignal(int) { stopRecording = 1; }
+
+int RunRecorder(System& system, const CommandLine::Options& options) {
+  Recorder recorder;
+  if (!recorder.Open(options.recordPath, options.intervalMs,
+                     system.OperatingSystem(), system.Kernel())) {
+    return 1;
+  }
+
+  struct sigaction sa {};
+  sa.sa_handler = handleStopSignal;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, nullptr);
+  sigaction(SIGTERM, &sa, nullptr);
+
+  const auto interval = std::chrono::milliseconds(options.intervalMs);
+  auto nextTick = std::chrono::steady_clock::now() + interval;
+  for (long iteration = 0;
+       !stopRecording &&
+       (options.iterations == 0 || iteration < options.iterations);
+       ++iteration) {
+    std::this_thread::sleep_until(nextTick);
+    if (stopRecording) break;
+
+    system.Sample(true);
+    if (!recorder.Append(system)) {
+      return 1;
+    }
+
+    nextTick += interval;
+    auto now = std::chrono::steady_clock::now();
+    if (nextTick < now) {
+      nextTick = now + interval;
+    }
+  }
+  return recorder.Close() ? 0 : 1;
+}
+
+// Player
+
+Player::~Player() {
+  if (fd_ >= 0) close(fd_);
+}
+
+int Player::IntervalMs() const { return intervalMs_; }
+
+bool Player::Open(const std::string& path) {
+  fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) {
+    perror(("error while opening file " + path).c_str());
+    return false;
+  }
+  off_t size = lseek(fd_, 0, SEEK_END);
+
+  char header[4096];
+  size_t headerSize = std::min<off_t>(sizeof(header), std::max<off_t>(size, 0));
+  if (!ReadAt(fd_, 0, header, headerSize) ||
+      headerSize < RECORDING_MAGIC_SIZE ||
+      std::memcmp(header, RECORDING_MAGIC, RECORDING_MAGIC_SIZE) != 0) {
+    fprintf(stderr, "%s is not a recording\n", path.c_str());
+    return false;
+  }
+  Reader reader(header + RECORDING_MAGIC_SIZE, headerSize - RECORDING_MAGIC_SIZE);
+  intervalMs_ = static_cast<int>(reader.Varint());
+  os_ = reader.String();
+  kernel_ = reader.String();
+  if (!reader.Ok() || intervalMs_ <= 0) {
+    fprintf(stderr, "%s has a corrupt header\n", path.c_str());
+    return false;
+  }
+  dataStart_ = RECORDING_MAGIC_SIZE + reader.Position();
+  dataEnd_ = size;
+
+  if (!loadIndex() && !scanFrames()) {
+    fprintf(stderr, "%s contains no frames\n", path.c_str());
+    return false;
+  }
+  seek(0);
+  lastAdvance_ = std::chrono::steady_clock::now();
+  return true;
+}
+
+// Reads the index written by Recorder::Close()
+bool Player::loadIndex() {
+  char trailer[RECORDING_TRAILER_SIZE];
+  if (dataEnd_ < dataStart_ + RECORDING_TRAILER_SIZE ||
+      !ReadAt(fd_, dataEnd_ - RECORDING_TRAILER_SIZE, trailer,
+              RECORDING_TRAILER_SIZE) ||
+      std::memcmp(trailer + 8, RECORDING_INDEX_MAGIC, RECORDING_MAGIC_SIZE) != 0) {
+    return false;
+  }
+  uint64_t indexOffset = 0;
+  for (int i = 0; i < 8; ++i) {
+    indexOffset |= static_cast<uint64_t>(static_cast<uint8_t>(trailer[i]))
+                   << (8 * i);
+  }
+  if (indexOffset < dataStart_ || indexOffset >= dataEnd_) return false;
+
+  std::vector<char> index(dataEnd_ - RECORDING_TRAILER_SIZE - indexOffset);
+  if (!ReadAt(fd_, indexOffset, index.data(), index.size()) ||
+      index.empty() || index[0] != FRAME_INDEX) {
+    return false;
+  }
+  Reader reader(index.data() + 1, index.size() - 1);
+  reader.Varint();  // payload length
+  uint64_t count = reader.Varint();
+  IndexEntry previous{0, 0, false};
+  frames_.clear();
+  for (uint64_t i = 0; i < count && reader.Ok(); ++i) {
+    IndexEntry entry;
+    entry.offset = previous.offset + reader.Varint();
+    entry.timestampMs = previous.timestampMs + reader.Signed();
+    entry.keyframe = reader.Varint() != 0;
+    frames_.push_back(entry);
+    previous = entry;
+  }
+  dataEnd_ = indexOffset;
+  return reader.Ok() && !frames_.empty() && frames_[0].keyframe;
+}
+
+// Rebuilds the index of an unterminated recording from the frame headers,
+// stopping at the first incomplete frame
+bool Player::scanFrames() {
+  frames_.clear();
+  uint64_t offset = dataStart_;
+  int64_t timestamp = 0;
+  uint64_t previousNumValues = 0;
+  char head[32];
+  while (offset < dataEnd_) {
+    size_t headSize = std::min<uint64_t>(sizeof(head), dataEnd_ - offset);
+    if (!ReadAt(fd_, offset, head, headSize)) break;
+    char kind = head[0];
+    if (kind != FRAME_KEY && kind != FRAME_DELTA) break;
+    Reader reader(head + 1, headSize - 1);
+    uint64_t length = reader.Varint();
+    size_t payloadStart = 1 + reader.Position();
+    uint64_t numValues = reader.Varint();
+    int64_t timestampDelta = reader.Signed();
+    if (!reader.Ok() || offset + payloadStart + length > dataEnd_) break;
+
+    // Same rule as the decoder: no base to add to for keyframes or a changed
+    // number of system values
+    bool absolute = (kind == FRAME_KEY) || numValues != previousNumValues;
+    timestamp = absolute ? timestampDelta : timestamp + timestampDelta;
+    previousNumValues = numValues;
+    if (frames_.empty() && kind != FRAME_KEY) break;
+    frames_.push_back({offset, timestamp, kind == FRAME_KEY});
+    offset += payloadStart + length;
+  }
+  return !frames_.empty();
+}
+
+// Applies frame `frame` on top of the decoded state of the previous frame
+bool Player::decodeFrame(size_t frame) {
+  const IndexEntry& entry = frames_[frame];
+  char head[16];
+  size_t headSize = std::min<uint64_t>(sizeof(head), dataEnd_ - entry.offset);
+  if (!ReadAt(fd_, entry.offset, head, headSize)) return false;
+  Reader headReader(head + 1, headSize - 1);
+  uint64_t length = headReader.Varint();
+  if (!headReader.Ok()) return false;
+
+  payload_.resize(length);
+  if (!ReadAt(fd_, entry.offset + 1 + headReader.Position(), payload_.data(),
+              length)) {
+    return false;
+  }
+  Reader reader(payload_.data(), payload_.size());
+
+  uint64_t numValues = reader.Varint();
+  if (entry.keyframe || numValues != systemValues_.size()) {
+    systemValues_.assign(numValues, 0);
+  }
+  for (uint64_t i = 0; i < numValues && reader.Ok(); ++i) {
+    systemValues_[i] += reader.Signed();
+  }
+
+  if (entry.keyframe) {
+    records_.clear();
+    uint64_t count = reader.Varint();
+    pid_t pid = 0;
+    for (uint64_t i = 0; i < count && reader.Ok(); ++i) {
+      pid += reader.Signed();
+      ReadFullRecord(reader, records_[pid]);
+    }
+    for (auto it = processes_.begin(); it != processes_.end();) {
+      it = records_.count(it->first) ? std::next(it) : processes_.erase(it);
+    }
+  } else {
+    uint64_t count = reader.Varint();
+    pid_t pid = 0;
+    for (uint64_t i = 0; i < count && reader.Ok(); ++i) {
+      pid += reader.Signed();
+      records_.erase(pid);
+      processes_.erase(pid);
+    }
+    count = reader.Varint();
+    pid = 0;
+    for (uint64_t i = 0; i < count && reader.Ok(); ++i) {
+      pid += reader.Signed();
+      ReadFullRecord(reader, records_[pid]);
+    }
+    count = reader.Varint();
+    pid = 0;
+    for (uint64_t i = 0; i < count && reader.Ok(); ++i) {
+      pid += reader.Signed();
+      uint64_t mask = reader.Varint();
+      ProcessRecord& record = records_[pid];
+      for (int f = 0; f < NUM_PROCESS_FIELDS; ++f) {
+        if (mask & (1u << f)) record.fields[f] += reader.Signed();
+      }
+    }
+  }
+  return reader.Ok();
+}
+
+// Turns the decoded values into what the UI reads
+void Player::applyDecodedState() {
+  const std::vector<int64_t>& v = systemValues_;
+  if (v.size() < SYS_CPU) return;
+
+  uint64_t* memFields[] = {&memData_.memTotal,  &memData_.memFree,
+                           &memData_.memAvailable, &memData_.buffers,
+                           &memData_.cached,    &memData_.swapCached,
+                           &memData_.sReclaimable, &memData_.shmem,
+                           &memData_.swapTotal, &memData_.swapFree};
+  for (int i = 0; i < 10; ++i) *memFields[i] = v[SYS_MEM + i];
+
+  char loadAverage[64];
+  snprintf(loadAverage, sizeof(loadAverage), "%.2f %.2f %.2f",
+           v[SYS_LOAD] / 100.0, v[SYS_LOAD + 1] / 100.0, v[SYS_LOAD + 2] / 100.0);
+  loadAverage_ = loadAverage;
+
+  size_t numCpus = std::min<size_t>(v[SYS_NUM_CPUS],
+                                    (v.size() - SYS_CPU) / CPU_FIELDS);
+  std::vector<CPUDataWithHistory> cpuData(numCpus);
+  for (size_t i = 0; i < numCpus; ++i) {
+    if (i < cpuData_.size()) cpuData[i].setPrevious(cpuData_[i].current);
+    CPUData& cpu = cpuData[i].current;
+    uint64_t* cpuFields[CPU_FIELDS] = {
+        &cpu.usertime,  &cpu.nicetime,    &cpu.systemtime, &cpu.idletime,
+        &cpu.iowaittime, &cpu.irqtime,    &cpu.softirqtime, &cpu.stealtime,
+        &cpu.guesttime, &cpu.guestnicetime, &cpu.totaltime};
+    for (int j = 0; j < CPU_FIELDS; ++j) {
+      *cpuFields[j] = v[SYS_CPU + i * CPU_FIELDS + j];
+    }
+  }
+  cpuData_ = std::move(cpuData);
+
+  size_t diskStart = SYS_CPU + numCpus * CPU_FIELDS;
+  size_t numDisks = 0;
+  if (v.size() > diskStart) {
+    numDisks = std::min<size_t>(v[diskStart],
+                                (v.size() - diskStart - 1) / DISK_FIELDS);
+  }
+  diskData_.resize(numDisks);
+  for (size_t i = 0; i < numDisks; ++i) {
+    LinuxParser::diskStatsData& disk = diskData_[i];
+    const int64_t* fields = &v[diskStart + 1 + i * DISK_FIELDS];
+    for (size_t byte = 0; byte < sizeof(disk.name); ++byte) {
+      disk.name[byte] = (char)(fields[byte / 8] >> (byte % 8 * 8));
+    }
+    disk.name[sizeof(disk.name) - 1] = '\0';
+    uint64_t* diskFields[] = {&disk.reads,      &disk.readSectors,
+                              &disk.readMs,     &disk.writes,
+                              &disk.writeSectors, &disk.writeMs,
+                              &disk.inFlight,   &disk.ioMs,
+                              &disk.weightedMs};
+    for (int j = 0; j < DISK_FIELDS - DISK_NAME_WORDS; ++j) {
+      *diskFields[j] = fields[DISK_NAME_WORDS + j];
+    }
+  }
+  // Rates over the recorded time between the frames
+  disks_.Update(diskData_, std::chrono::steady_clock::time_point(
+                               std::chrono::milliseconds(v[SYS_TIMESTAMP])));
+
+  if (history_.NumCpus() != cpuData_.size()) history_.Reset(cpuData_.size());
+  history_.Record(cpuData_, memData_, loadAverage_);
+
+  for (const auto& [pid, record] : records_) {
+    auto& process = processes_[pid];
+    if (!process || process->Command() != record.command) {
+      process = std::make_shared<Process>(pid, record.user, record.command);
+    }
+    LinuxParser::procStatFileData statData{};
+    statData.state = static_cast<char>(record.fields[STATE]);
+    statData.priorityval = record.fields[PRIORITY];
+    statData.niceval = record.fields[NICE];
+    statData.starttime = record.fields[START_TIME];
+    statData.utime = record.fields[ACTIVE_JIFFIES];
+    LinuxParser::procStatusFileData statusData{};
+    statusData.memData.virtual_mem = record.fields[VIRTUAL_MEM];
+    statusData.memData.resident_mem = record.fields[RESIDENT_MEM];
+    statusData.memData.shared_mem = record.fields[SHARED_MEM];
+    statusData.numThreads = record.fields[THREADS];
+    process->Restore(statData, statusData, record.fields[CPU_PERMILLE] / 10.0f);
+  }
+}
+
+// Decodes forward from the closest keyframe at or before `frame`
+void Player::seek(size_t frame) {
+  frame = std::min(frame, frames_.size() - 1);
+  size_t keyframe = frame;
+  while (keyframe > 0 && !frames_[keyframe].keyframe) keyframe--;
+
+  processes_.clear();
+  cpuData_.clear();
+  disks_.Clear();
+  for (size_t i = keyframe; i <= frame; ++i) {
+    if (!decodeFrame(i)) break;
+    // CPU bars need the counters of the frame before the shown one
+    if (i + 1 == frame) applyDecodedState();
+  }
+  history_.Clear();
+  applyDecodedState();
+  currentFrame_ = frame;
+}
+
+void Player::Update() {
+  auto now = std::chrono::steady_clock::now();
+  if (paused_ || now - lastAdvance_ < std::chrono::milliseconds(intervalMs_) ||
+      currentFrame_ + 1 >= frames_.size()) {
+    return;
+  }
+  if (decodeFrame(currentFrame_ + 1)) {
+    currentFrame_++;
+    applyDecodedState();
+  }
+  lastAdvance_ = now;
+}
+
+bool Player::HandleKey(int key) {
+  switch (key) {
+    case 'p':
+      paused_ = !paused_;
+      lastAdvance_ = std::chrono::steady_clock::now();
+      return true;
+    case '.':
+      paused_ = true;
+      if (currentFrame_ + 1 < frames_.size() && decodeFrame(currentFrame_ + 1)) {
+        currentFrame_++;
+        applyDecodedState();
+      }
+      return true;
+    case ',':
+      paused_ = true;
+      if (currentFrame_ > 0) seek(currentFrame_ - 1);
+      return true;
+    case '[':
+    case ']': {
+      int64_t target = frames_[currentFrame_].timestampMs +
+                       (key == ']' ? 1 : -1) * RECORDING_SEEK_SECONDS * 1000;
+      auto it = std::lower_bound(
+          frames_.begin(), frames_.end(), target,
+          [](const IndexEntry& entry, int64_t ts) { return entry.timestampMs < ts; });
+      seek(std::min<size_t>(it - frames_.begin(), frames_.size() - 1));
+      lastAdvance_ = std::chrono::steady_clock::now();
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string Player::StatusText() {
+  time_t seconds = frames_[currentFrame_].timestampMs / 1000;
+  struct tm local {};
+  localtime_r(&seconds, &local);
+  char when[32];
+  strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &local);
+
+  char status[128];
+  snprintf(status, sizeof(status), "REPLAY %s  frame %zu/%zu%s", when,
+           currentFrame_ + 1, frames_.size(), paused_ ? "  [PAUSED]" : "");
+  return status;
+}
+
+std::vector<std::shared_ptr<Process>> Player::GetSortedProcesses() {
+  std::vector<std::shared_ptr<Process>> sortedProcesses;
+  sortedProcesses.reserve(processes_.size());
+  for (const auto& it : processes_) {
+    sortedProcesses.push_back(it.second);
+  }
+  ProcessManager::SortForDisplay(sortedProcesses);
+  return sortedProcesses;
+}
+
+unsigned int Player::getNumOfTasks() {
+  return systemValues_.size() > SYS_TASKS ? systemValues_[SYS_TASKS] : 0;
+}
+
+unsigned int Player::getNumOfThreads() {
+  return systemValues_.size() > SYS_THREADS ? systemValues_[SYS_THREADS] : 0;
+}
+
+unsigned int Player::getNumOfRunningTasks() {
+  return systemValues_.size() > SYS_RUNNING ? systemValues_[SYS_RUNNING] : 0;
+}
+
+const MemData& Player::MemoryUtilization() { return memData_; }
+
+unsigned long long Player::UpTime() {
+  return systemValues_.size() > SYS_UPTIME ? systemValues_[SYS_UPTIME] : 0;
+}
+
+std::string Player::LoadAverage() { return loadAverage_; }
+
+const std::vector<CPUDataWithHistory>& Player::totalCpuUtilization() {
+  return cpuData_;
+}
+
+std::string Player::Kernel() { return kernel_; }
+
+std::string Player::OperatingSystem() { return os_; }
+
+}  // namespace Recording
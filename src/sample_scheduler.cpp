@@ -0,0 +1,41 @@
+#include "sample_scheduler.h"
+
+SampleTier SampleScheduler::TierOf(uint32_t source) {
+  switch (source) {
+    case SAMPLE_SOURCE_IO:
+      // Rates need two reads, but not every tick to be useful
+      return SampleTier::MEDIUM;
+    case SAMPLE_SOURCE_SMAPS:
+      // The kernel walks every mapping of the process to sum it up
+    case SAMPLE_SOURCE_FD:
+    case SAMPLE_SOURCE_SOCKETS:
+      // A directory walk, and a readlink per descriptor for sockets
+    case SAMPLE_SOURCE_TASKS:
+      // A directory walk, and an open, read and close per thread
+      return SampleTier::SLOW;
+    case SAMPLE_SOURCE_SCHEDSTAT:
+      // A few bytes, and the wait share is best over the interval of CPU%
+    default:
+      return SampleTier::FAST;
+  }
+}
+
+uint32_t SampleScheduler::NextTick() {
+  uint64_t tick = tick_++;
+  uint32_t due = 0;
+  for (uint32_t source = 1; source != 0 && source <= wanted_; source <<= 1) {
+    if (!(wanted_ & source)) continue;
+    switch (TierOf(source)) {
+      case SampleTier::FAST:
+        due |= source;
+        break;
+      case SampleTier::MEDIUM:
+        if (tick % SAMPLE_MEDIUM_TIER_TICKS == 0) due |= source;
+        break;
+      case SampleTier::SLOW:
+        if (tick % SAMPLE_SLOW_TIER_TICKS == 0) due |= source;
+        break;
+    }
+  }
+  return due;
+}
@@ -0,0 +1,14 @@
+#include "self_stats.h"
+
+void SelfStats::Update(const LinuxParser::selfUsageData& usage,
+                       std::chrono::steady_clock::time_point now) {
+  double seconds = std::chrono::duration<double>(now - time_).count();
+  if (time_.time_since_epoch().count() != 0 && seconds > 0) {
+    cpuPercent_ = (usage.cpuUs - usage_.cpuUs) / (seconds * 1e4);
+    ctxtRate_ = ((usage.voluntaryCtxtSwitches - usage_.voluntaryCtxtSwitches) +
+                 (usage.nonvoluntaryCtxtSwitches -
+                  usage_.nonvoluntaryCtxtSwitches)) / seconds;
+  }
+  usage_ = usage;
+  time_ = now;
+}
@@ -0,0 +1,58 @@
+#include "shadow_window.h"
+
+#include <algorithm>
+
+// Never produced by Print() or Fill(), so every cell differs after Reset()
+#define SHADOW_INVALID_CELL (~(chtype)0)
+
+void ShadowWindow::Reset(WINDOW* window) {
+  window_ = window;
+  width_ = window ? getmaxx(window) : 0;
+  height_ = window ? getmaxy(window) : 0;
+  back_.assign((size_t)width_ * height_, ' ');
+  front_.assign((size_t)width_ * height_, SHADOW_INVALID_CELL);
+}
+
+void ShadowWindow::Clear() { std::fill(back_.begin(), back_.end(), ' '); }
+
+void ShadowWindow::Print(int y, int x, std::string_view text,
+                         attr_t attributes) {
+  if (y < 0 || y >= height_ || x >= width_) return;
+  chtype* row = &back_[(size_t)y * width_];
+  for (char c : text) {
+    if (c == '\0' || x >= width_) break;
+    if (x >= 0) {
+      unsigned char ch = static_cast<unsigned char>(c);
+      row[x] = (ch < ' ' ? '?' : ch) | attributes;
+    }
+    ++x;
+  }
+}
+
+void ShadowWindow::Fill(int y, int x, int count, chtype cell) {
+  if (y < 0 || y >= height_) return;
+  int start = std::max(0, x);
+  int end = std::min(width_, x + count);
+  if (start >= end) return;
+  chtype* row = &back_[(size_t)y * width_];
+  std::fill(row + start, row + end, cell);
+}
+
+size_t ShadowWindow::Flush() {
+  size_t written = 0;
+  for (int y = 0; y < height_; ++y) {
+    const chtype* next = &back_[(size_t)y * width_];
+    chtype* shown = &front_[(size_t)y * width_];
+    int first = 0;
+    while (first < width_ && next[first] == shown[first]) ++first;
+    if (first == width_) continue;
+    int last = width_ - 1;
+    while (next[last] == shown[last]) --last;
+
+    mvwaddchnstr(window_, y, first, next + first, last - first + 1);
+    std::copy(next + first, next + last + 1, shown + first);
+    written += last - first + 1;
+  }
+  if (window_) wnoutrefresh(window_);
+  return written;
+}
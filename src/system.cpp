@@ -1,11 +1,89 @@
 #include "system.h"
 
+#include <thread>
+
+#include "globals.h"
 #include "linux_parser.h"
 
 System::System() {
   this->operating_system_ = LinuxParser::OperatingSystem();
   this->kernel_ = LinuxParser::Kernel();
-  this->processManager.UpdateProcesses();
+  this->history_.Reset(LinuxParser::totalCpuUtilization().size());
+  recordHistory();
+}
+
+void System::Update() { Sample(false); }
+
+void System::Prime() {
+  if (!this->processManager.UpdateProcesses(true)) return;  // cancelled
+  std::this_thread::sleep_for(std::chrono::milliseconds(SYSTEM_PRIMING_MS));
+  Sample(true);
+}
+
+void System::CancelPrime() { this->processManager.Cancel(); }
+
+void System::Sample(bool force) {
+  if (!this->processManager.UpdateProcesses(force)) return;
+  recordHistory();
+  for (const auto& observer : observers_) {
+    observer(*this);
+  }
+}
+
+void System::recordHistory() {
+  this->history_.Record(LinuxParser::totalCpuUtilization(),
+                        LinuxParser::MemoryUtilization(),
+                        LinuxParser::LoadAverage());
+
+  // A forced sample within the cache duration sees the same device and
+  // pressure counters; the rates of the previous sample stay. The time is
+  // taken after the reads, so the caches have always expired once this
+  // check passes.
+  if (std::chrono::steady_clock::now() - this->devicesSampled_ >=
+      Globals::CacheDuration()) {
+    const auto& interfaces = LinuxParser::NetworkDevices();
+    const auto& disks = LinuxParser::DiskStatistics();
+    const auto& pressure = LinuxParser::Pressure();
+    if (this->interruptTracking_) {
+      const auto& interrupts = LinuxParser::Interrupts();
+      const auto& softirqs = LinuxParser::SoftIrqs();
+      this->devicesSampled_ = std::chrono::steady_clock::now();
+      this->interrupts_.Update(interrupts, softirqs, this->devicesSampled_);
+    } else {
+      this->devicesSampled_ = std::chrono::steady_clock::now();
+    }
+    this->network_.Update(interfaces, this->devicesSampled_);
+    this->disks_.Update(disks, this->devicesSampled_);
+    this->pressure_.Update(pressure, this->devicesSampled_);
+  }
+  NetRates total = this->network_.Total(this->network_.DefaultFilter());
+  this->history_.RecordNetwork(total.rxBytes, total.txBytes);
+  if (this->pressure_.Available()) {
+    const PressureStats& pressure = this->pressure_;
+    this->history_.RecordPressure(pressure.Stall(LinuxParser::PSI_CPU).some,
+                                  pressure.Stall(LinuxParser::PSI_MEMORY).some,
+                                  pressure.Stall(LinuxParser::PSI_IO).some);
+  }
+}
+
+void System::AddSampleObserver(std::function<void(System&)> observer) {
+  observers_.push_back(std::move(observer));
+}
+
+std::vector<std::shared_ptr<Process>> System::GetSortedProcesses() {
+  return this->processManager.GetSortedProcessesForDisplay();
+}
+
+unsigned int System::getNumOfTasks() {
+  return this->processManager.getNumOfTasks();
+}
+
+unsigned int System::getNumOfThreads() {
+  return this->processManager.getNumOfThreads();
+}
+
+unsigned int System::getNumOfRunningTasks() {
+  return this->processManager.getNumOfRunningTasks();
 }
 
 std::string System::Kernel() { return this->kernel_; }
@@ -16,6 +94,16 @@ const MemData& System::MemoryUtilization() {
 
 std::string System::OperatingSystem() { return this->operating_system_; }
 
+std::vector<int> System::CpuNodes() { return LinuxParser::CpuNodes(); }
+
+const std::vector<LinuxParser::numaNodeData>* System::NumaMemory() {
+  return &LinuxParser::NumaNodes();
+}
+
+bool System::ProcessNumaMemory(pid_t pid, std::vector<uint64_t>& nodeKb) {
+  return LinuxParser::NumaMaps(pid, nodeKb);
+}
+
 unsigned long long System::UpTime() {
   return LinuxParser::UpTime();
 }
@@ -27,3 +115,36 @@ std::string System::LoadAverage() {
 const std::vector<struct CPUDataWithHistory>& System::totalCpuUtilization() {
   return LinuxParser::totalCpuUtilization();
 }
+
+void System::SetWantedSources(uint32_t sources) {
+  this->processManager.SetWantedSources(sources);
+}
+
+void System::SetVisiblePids(std::vector<pid_t> pids) {
+  this->processManager.SetVisiblePids(std::move(pids));
+}
+
+std::string System::ProcessCommandLine(pid_t pid) {
+  return LinuxParser::FullCommand(pid);
+}
+
+bool System::SetShowKernelThreads(bool show) {
+  this->processManager.SetShowKernelThreads(show);
+  return true;
+}
+
+bool System::SetCgroupTracking(bool enabled) {
+  this->processManager.SetCgroupTracking(enabled);
+  return true;
+}
+
+bool System::SetInterruptTracking(bool enabled) {
+  // Rates start over rather than spanning the time nobody looked
+  if (enabled && !this->interruptTracking_) this->interrupts_.Clear();
+  this->interruptTracking_ = enabled;
+  return true;
+}
+
+std::vector<const CgroupStats*> System::GetSortedCgroups() {
+  return this->processManager.Cgroups().GetSortedCgroups();
+}